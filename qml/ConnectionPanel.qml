@@ -85,12 +85,12 @@ Rectangle {
             Button {
                 id: connectButton
                 Layout.fillWidth: true
-                text: mavlinkHandler.connected ? "Disconnect" : "Connect"
+                text: MavlinkHandler.connected ? "Disconnect" : "Connect"
                 font.pixelSize: 14
                 font.bold: true
 
                 background: Rectangle {
-                    color: parent.down ? "#2980b9" : (mavlinkHandler.connected ? "#e74c3c" : "#3498db")
+                    color: parent.down ? "#2980b9" : (MavlinkHandler.connected ? "#e74c3c" : "#3498db")
                     radius: 5
                 }
                 contentItem: Text {
@@ -102,10 +102,10 @@ Rectangle {
                 }
 
                 onClicked: {
-                    if (mavlinkHandler.connected) {
-                        mavlinkHandler.disconnectFromFC()
+                    if (MavlinkHandler.connected) {
+                        MavlinkHandler.disconnectFromFC()
                     } else {
-                        mavlinkHandler.connectToFC(ipField.text, parseInt(portField.text))
+                        MavlinkHandler.connectToFC(ipField.text, parseInt(portField.text))
                     }
                 }
             }
@@ -129,7 +129,36 @@ Rectangle {
                 }
 
                 onClicked: {
-                    mavlinkHandler.clearData()
+                    MavlinkHandler.clearData()
+                }
+            }
+        }
+
+        // Каналы связи: видны, когда их больше одного
+        ColumnLayout {
+            Layout.fillWidth: true
+            spacing: 2
+            visible: MavlinkHandler.links.links.length > 1
+
+            Text {
+                text: "Links (active: " + (MavlinkHandler.links.activeLink || "all")
+                      + ", failovers: " + MavlinkHandler.links.failovers + ")"
+                font.pixelSize: 12
+                color: "white"
+            }
+
+            Repeater {
+                model: MavlinkHandler.links.links
+
+                Text {
+                    text: (modelData.active ? "● " : "○ ") + modelData.name + "  "
+                          + (modelData.connected
+                             ? modelData.lossPercent.toFixed(1) + "% loss, +"
+                               + modelData.delayMs.toFixed(0) + " ms, "
+                               + modelData.duplicates + " dup"
+                             : "disconnected")
+                    font.pixelSize: 11
+                    color: modelData.healthy ? "#2ecc71" : (modelData.connected ? "#f39c12" : "#95a5a6")
                 }
             }
         }
@@ -207,7 +236,7 @@ Rectangle {
             }
 
             onClicked: {
-                // Вызовем метод отправки heartbeat через mavlinkHandler
+                // Вызовем метод отправки heartbeat через MavlinkHandler
                 console.log("Manual heartbeat sent");
             }
         }
@@ -230,7 +259,7 @@ Rectangle {
             }
 
             onClicked: {
-                mavlinkHandler.requestAttitudeStream()
+                MavlinkHandler.requestAttitudeStream()
                 console.log("Requested ATTITUDE data stream")
             }
         }
@@ -253,7 +282,7 @@ Rectangle {
             }
 
             onClicked: {
-                mavlinkHandler.requestAttitudeStream()
+                MavlinkHandler.requestAttitudeStream()
                 console.log("Forced 30Hz attitude stream request")
             }
         }
@@ -26,7 +26,7 @@ Rectangle {
 
         Rectangle {
             Layout.fillWidth: true
-            Layout.preferredHeight: 180 // Увеличим высоту
+            Layout.preferredHeight: 250 // Увеличим высоту
             color: "#2c3e50"
             radius: 6
             border.color: "#7f8c8d"
@@ -54,32 +54,40 @@ Rectangle {
 
                     Text { text: "Roll:"; font.pixelSize: 14; color: "white"; Layout.alignment: Qt.AlignRight }
                     Text {
-                        text: mavlinkHandler.attitude.roll.toFixed(2) + "°"
+                        text: MavlinkHandler.displayAttitude.roll.toFixed(2) + "°"
                         font.pixelSize: 14; font.bold: true; color: "#e74c3c"
                     }
 
                     Text { text: "Pitch:"; font.pixelSize: 14; color: "white"; Layout.alignment: Qt.AlignRight }
                     Text {
-                        text: mavlinkHandler.attitude.pitch.toFixed(2) + "°"
+                        text: MavlinkHandler.displayAttitude.pitch.toFixed(2) + "°"
                         font.pixelSize: 14; font.bold: true; color: "#2ecc71"
                     }
 
                     Text { text: "Yaw:"; font.pixelSize: 14; color: "white"; Layout.alignment: Qt.AlignRight }
                     Text {
-                        text: mavlinkHandler.attitude.yaw.toFixed(2) + "°"
+                        text: MavlinkHandler.displayAttitude.yaw.toFixed(2) + "°"
                         font.pixelSize: 14; font.bold: true; color: "#f39c12"
                     }
 
+                    Text { text: "Rates:"; font.pixelSize: 14; color: "white"; Layout.alignment: Qt.AlignRight }
+                    Text {
+                        text: MavlinkHandler.attitude.rollspeed.toFixed(1) + " / "
+                              + MavlinkHandler.attitude.pitchspeed.toFixed(1) + " / "
+                              + MavlinkHandler.attitude.yawspeed.toFixed(1) + " °/s"
+                        font.pixelSize: 14; color: "#bdc3c7"
+                    }
+
                     Text { text: "Timestamp:"; font.pixelSize: 14; color: "white"; Layout.alignment: Qt.AlignRight }
                     Text {
-                        text: mavlinkHandler.attitude.timestamp + " ms"
+                        text: MavlinkHandler.attitude.timestamp + " ms"
                         font.pixelSize: 14; color: "#bdc3c7"
                     }
 
                     Text { text: "Frequency:"; font.pixelSize: 14; color: "white"; Layout.alignment: Qt.AlignRight }
                     Text {
                         text: {
-                            var freq = mavlinkHandler.attitudeFrequency
+                            var freq = MavlinkHandler.attitudeFrequency
                             if (freq >= 25) return "✓ " + freq + " Hz"
                             else if (freq >= 15) return "⚠ " + freq + " Hz"
                             else return "❌ " + freq + " Hz"
@@ -87,19 +95,51 @@ Rectangle {
                         font.pixelSize: 14;
                         font.bold: true;
                         color: {
-                            var freq = mavlinkHandler.attitudeFrequency
+                            var freq = MavlinkHandler.attitudeFrequency
                             if (freq >= 25) return "#2ecc71"
                             else if (freq >= 15) return "#f39c12"
                             else return "#e74c3c"
                         }
                     }
 
+                    Text { text: "Latency:"; font.pixelSize: 14; color: "white"; Layout.alignment: Qt.AlignRight }
+                    Text {
+                        text: MavlinkHandler.timeSynchronized
+                              ? MavlinkHandler.attitudeLatency.toFixed(1) + " ms (vehicle → screen)"
+                              : "not synchronized"
+                        font.pixelSize: 14
+                        color: {
+                            if (!MavlinkHandler.timeSynchronized) return "#bdc3c7"
+                            var latency = MavlinkHandler.attitudeLatency
+                            if (latency < 100) return "#2ecc71"
+                            else if (latency < 250) return "#f39c12"
+                            else return "#e74c3c"
+                        }
+                    }
+
+                    // Экстраполяция углов по скоростям к моменту вывода кадра
+                    Text { text: "Prediction:"; font.pixelSize: 14; color: "white"; Layout.alignment: Qt.AlignRight }
+                    RowLayout {
+                        spacing: 6
+                        Switch {
+                            checked: MavlinkHandler.predictionEnabled
+                            onToggled: MavlinkHandler.predictionEnabled = checked
+                        }
+                        Text {
+                            text: MavlinkHandler.predictionEnabled
+                                  ? "+" + MavlinkHandler.predictionMs.toFixed(0) + " ms"
+                                  : "off"
+                            font.pixelSize: 14
+                            color: "#bdc3c7"
+                        }
+                    }
+
                     // Добавим диагностику
                     Text { text: "Status:"; font.pixelSize: 14; color: "white"; Layout.alignment: Qt.AlignRight }
                     Text {
                         text: {
-                            if (!mavlinkHandler.connected) return "Disconnected"
-                            var freq = mavlinkHandler.attitudeFrequency
+                            if (!MavlinkHandler.connected) return "Disconnected"
+                            var freq = MavlinkHandler.attitudeFrequency
                             if (freq === 0) return "No data"
                             else if (freq < 10) return "Very low"
                             else if (freq < 20) return "Low"
@@ -108,8 +148,8 @@ Rectangle {
                         }
                         font.pixelSize: 14;
                         color: {
-                            if (!mavlinkHandler.connected) return "#e74c3c"
-                            var freq = mavlinkHandler.attitudeFrequency
+                            if (!MavlinkHandler.connected) return "#e74c3c"
+                            var freq = MavlinkHandler.attitudeFrequency
                             if (freq === 0) return "#e74c3c"
                             else if (freq < 10) return "#e74c3c"
                             else if (freq < 20) return "#f39c12"
@@ -187,7 +227,7 @@ Rectangle {
 
                     TextArea {
                         id: rawDataDisplay
-                        text: mavlinkHandler.rawData
+                        text: MavlinkHandler.rawData
                         readOnly: true
                         font.pixelSize: 10
                         font.family: "Courier New"
@@ -202,7 +242,7 @@ Rectangle {
 
     // Connect to new messages
     Connections {
-        target: mavlinkHandler
+        target: MavlinkHandler
         function onNewMessage(message) {
             var timestamp = new Date().toLocaleTimeString();
             messageLog.text += "[" + timestamp + "] " + message + "\n";
@@ -38,12 +38,12 @@ ApplicationWindow {
         Rectangle {
             Layout.fillWidth: true
             height: 40
-            color: mavlinkHandler.connected ? "#27ae60" : "#e74c3c"
+            color: MavlinkHandler.connected ? "#27ae60" : "#e74c3c"
             radius: 5
 
             Text {
                 anchors.centerIn: parent
-                text: mavlinkHandler.connected ? "CONNECTED" : "DISCONNECTED"
+                text: MavlinkHandler.connected ? "CONNECTED" : "DISCONNECTED"
                 font.pixelSize: 16
                 font.bold: true
                 color: "white"
@@ -53,7 +53,7 @@ ApplicationWindow {
         // Status text
         Text {
             Layout.fillWidth: true
-            text: "Status: " + mavlinkHandler.status
+            text: "Status: " + MavlinkHandler.status
             font.pixelSize: 14
             color: "white"
             padding: 5
@@ -75,18 +75,22 @@ ApplicationWindow {
                     anchors.fill: parent
                     spacing: 10
 
-                    ConnectionPanel {
+                    // Панели создаются асинхронно, чтобы не задерживать первый кадр
+                    Loader {
                         Layout.fillWidth: true
                         Layout.preferredHeight: 400  // Фиксированная высота для ConnectionPanel
+                        asynchronous: true
+                        sourceComponent: Component { ConnectionPanel {} }
                     }
 
                     // Кнопка для показа/скрытия advanced settings
                     Button {
                         Layout.fillWidth: true
-                        text: "Advanced Settings ▼"
+                        text: parameterPanelLoader.shown ? "Advanced Settings ▲" : "Advanced Settings ▼"
                         onClicked: {
-                            parameterPanel.visible = !parameterPanel.visible
-                            text = parameterPanel.visible ? "Advanced Settings ▲" : "Advanced Settings ▼"
+                            // ParameterPanel создается только при первом открытии
+                            parameterPanelLoader.active = true
+                            parameterPanelLoader.shown = !parameterPanelLoader.shown
                         }
                         background: Rectangle {
                             color: parent.down ? "#7f8c8d" : "#95a5a6"
@@ -99,11 +103,22 @@ ApplicationWindow {
                         }
                     }
 
-                    ParameterPanel {
-                        id: parameterPanel
+                    Loader {
+                        id: parameterPanelLoader
+                        property bool shown: false
+
                         Layout.fillWidth: true
-                        Layout.preferredHeight: 0  // Начинаем с нулевой высоты
-                        visible: false
+                        Layout.preferredHeight: shown ? 410 : 0  // Начинаем с нулевой высоты
+                        visible: Layout.preferredHeight > 0
+                        clip: true
+                        active: false
+                        asynchronous: true
+                        sourceComponent: Component { ParameterPanel {} }
+
+                        // Анимация для плавного изменения высоты
+                        Behavior on Layout.preferredHeight {
+                            NumberAnimation { duration: 300 }
+                        }
                     }
 
                     // Spacer чтобы занять оставшееся место
@@ -114,10 +129,44 @@ ApplicationWindow {
             }
 
             // Правая панель - Data display (занимает всё оставшееся пространство)
-            DataDisplay {
+            Loader {
                 Layout.fillWidth: true
                 Layout.fillHeight: true
+                asynchronous: true
+                sourceComponent: Component { DataDisplay {} }
             }
         }
     }
+
+    // Инспектор сообщений MAVLink (F4)
+    property bool inspectorShown: false
+
+    Shortcut {
+        sequence: "F4"
+        onActivated: window.inspectorShown = !window.inspectorShown
+    }
+
+    Loader {
+        anchors.bottom: parent.bottom
+        anchors.left: parent.left
+        anchors.margins: 10
+        active: window.inspectorShown
+        asynchronous: true
+        sourceComponent: Component { MessageInspector {} }
+    }
+
+    // Оверлей профилировщика конвейера (F3 или --profile)
+    Shortcut {
+        sequence: "F3"
+        onActivated: PipelineProfiler.enabled = !PipelineProfiler.enabled
+    }
+
+    Loader {
+        anchors.top: parent.top
+        anchors.right: parent.right
+        anchors.margins: 10
+        active: PipelineProfiler.enabled
+        asynchronous: true
+        sourceComponent: Component { ProfilerOverlay {} }
+    }
 }
@@ -0,0 +1,82 @@
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+
+// Частота и полоса по каждому типу сообщения от каждого компонента
+Rectangle {
+    id: inspectorOverlay
+    implicitWidth: 760
+    implicitHeight: 320
+    color: "#ee1c2833"
+    radius: 6
+    border.color: "#3498db"
+    border.width: 1
+
+    readonly property var columnWidths: [40, 45, 55, 190, 70, 55, 65, 45, 190]
+
+    ColumnLayout {
+        anchors.fill: parent
+        anchors.margins: 10
+        spacing: 4
+
+        RowLayout {
+            Layout.fillWidth: true
+
+            Text {
+                text: "MAVLink inspector"
+                font.pixelSize: 13
+                font.bold: true
+                color: "#3498db"
+            }
+            Item { Layout.fillWidth: true }
+            Text {
+                text: MavlinkHandler.inspector.totalRate.toFixed(1) + " msg/s, "
+                      + (MavlinkHandler.inspector.totalBandwidth / 1024).toFixed(2) + " KiB/s"
+                font.pixelSize: 12
+                font.family: "monospace"
+                color: "white"
+            }
+        }
+
+        HorizontalHeaderView {
+            Layout.fillWidth: true
+            syncView: inspectorTable
+            clip: true
+            delegate: Text {
+                required property var display
+                text: display
+                font.pixelSize: 11
+                color: "#bdc3c7"
+                padding: 2
+            }
+        }
+
+        TableView {
+            id: inspectorTable
+            Layout.fillWidth: true
+            Layout.fillHeight: true
+            clip: true
+            model: MavlinkHandler.inspector
+            columnWidthProvider: function(column) { return inspectorOverlay.columnWidths[column] }
+            ScrollBar.vertical: ScrollBar {}
+
+            delegate: Text {
+                required property var display
+                required property int column
+                text: display
+                elide: Text.ElideRight
+                font.pixelSize: 12
+                font.family: "monospace"
+                color: column === 6 || column === 7 ? "#f1c40f" : "white"
+                horizontalAlignment: column === 3 || column === 8 ? Text.AlignLeft : Text.AlignRight
+                padding: 2
+            }
+        }
+
+        Button {
+            Layout.fillWidth: true
+            text: "Clear"
+            onClicked: MavlinkHandler.clearData()
+        }
+    }
+}
@@ -9,26 +9,7 @@ Rectangle {
     border.color: "#7f8c8d"
     border.width: 2
 
-    property bool expanded: false
-
-    // Анимация для плавного изменения высоты
-    Behavior on height {
-        NumberAnimation { duration: 300 }
-    }
-
-    onVisibleChanged: {
-        if (visible) {
-            height = 200  // Высота когда видима
-            expanded = true
-        } else {
-            height = 0    // Скрыта
-            expanded = false
-        }
-    }
-
-    Component.onCompleted: {
-        height = 0  // Начинаем скрытой
-    }
+    // Высоту и показ/скрытие с анимацией задает Loader в Main.qml
 
     ColumnLayout {
         anchors.fill: parent
@@ -72,7 +53,64 @@ Rectangle {
                 text: "Apply"
                 Layout.preferredWidth: 80
                 onClicked: {
-                    mavlinkHandler.setStreamRates(parseInt(attitudeRate.text), 5)
+                    MavlinkHandler.setStreamRates(parseInt(attitudeRate.text), 5)
+                }
+                background: Rectangle {
+                    color: parent.down ? "#27ae60" : "#2ecc71"
+                    radius: 4
+                }
+                contentItem: Text {
+                    text: parent.text
+                    color: "white"
+                    horizontalAlignment: Text.AlignHCenter
+                    font.pixelSize: 12
+                }
+            }
+        }
+
+        // Бюджет полосы для частот потоков (0 - фиксированные частоты)
+        RowLayout {
+            Layout.fillWidth: true
+            spacing: 10
+
+            Text {
+                text: "Budget:"
+                color: MavlinkHandler.streams.enabled ? "#2ecc71" : "white"
+                font.pixelSize: 12
+                Layout.preferredWidth: 80
+            }
+
+            TextField {
+                id: linkBudget
+                text: MavlinkHandler.streams.enabled ? MavlinkHandler.streams.budget : "0"
+                validator: IntValidator { bottom: 0; top: 1000000 }
+                Layout.fillWidth: true
+                background: Rectangle {
+                    color: "#2c3e50"
+                    border.color: "#7f8c8d"
+                    radius: 4
+                }
+                color: "white"
+            }
+
+            Text {
+                text: MavlinkHandler.streams.enabled
+                      ? Math.round(MavlinkHandler.streams.plannedBandwidth) + " B/s, x"
+                        + MavlinkHandler.streams.scale.toFixed(2)
+                      : "off"
+                color: MavlinkHandler.streams.scale < 1 ? "#f39c12" : "#bdc3c7"
+                font.pixelSize: 11
+                Layout.preferredWidth: 80
+            }
+
+            Button {
+                text: "Apply"
+                Layout.preferredWidth: 80
+                onClicked: {
+                    var budget = parseInt(linkBudget.text)
+                    if (budget > 0)
+                        MavlinkHandler.streams.budget = budget
+                    MavlinkHandler.streams.enabled = budget > 0
                 }
                 background: Rectangle {
                     color: parent.down ? "#27ae60" : "#2ecc71"
@@ -87,6 +125,190 @@ Rectangle {
             }
         }
 
+        // Ключ подписи MAVLink2
+        RowLayout {
+            Layout.fillWidth: true
+            spacing: 10
+
+            Text {
+                text: "Signing:"
+                color: MavlinkHandler.signingEnabled ? "#2ecc71" : "white"
+                font.pixelSize: 12
+                Layout.preferredWidth: 80
+            }
+
+            TextField {
+                id: signingPassphrase
+                placeholderText: "passphrase"
+                echoMode: TextInput.Password
+                Layout.fillWidth: true
+                background: Rectangle {
+                    color: "#2c3e50"
+                    border.color: "#7f8c8d"
+                    radius: 4
+                }
+                color: "white"
+            }
+
+            Button {
+                text: MavlinkHandler.signingEnabled ? "Off" : "Sign"
+                Layout.preferredWidth: 80
+                onClicked: {
+                    if (MavlinkHandler.signingEnabled) {
+                        MavlinkHandler.disableSigning()
+                    } else {
+                        MavlinkHandler.setSigningPassphrase(signingPassphrase.text)
+                        signingPassphrase.text = ""
+                    }
+                }
+                background: Rectangle {
+                    color: parent.down ? "#8e44ad" : "#9b59b6"
+                    radius: 4
+                }
+                contentItem: Text {
+                    text: parent.text
+                    color: "white"
+                    horizontalAlignment: Text.AlignHCenter
+                    font.pixelSize: 12
+                }
+            }
+        }
+
+        // Миссия: скачивание/выгрузка окном запросов
+        RowLayout {
+            Layout.fillWidth: true
+            spacing: 10
+
+            Text {
+                text: "Mission:"
+                color: "white"
+                font.pixelSize: 12
+                Layout.preferredWidth: 80
+            }
+
+            ColumnLayout {
+                Layout.fillWidth: true
+                spacing: 2
+
+                ProgressBar {
+                    Layout.fillWidth: true
+                    value: MavlinkHandler.mission.progress
+                }
+
+                Text {
+                    text: MavlinkHandler.mission.state + "  "
+                          + MavlinkHandler.mission.transferredItems + "/" + MavlinkHandler.mission.totalItems
+                          + "  " + MavlinkHandler.mission.itemsPerSecond.toFixed(1) + " items/s"
+                    color: "#bdc3c7"
+                    font.pixelSize: 10
+                }
+            }
+
+            Button {
+                text: MavlinkHandler.mission.busy ? "Stop" : "Get"
+                Layout.preferredWidth: 38
+                onClicked: {
+                    if (MavlinkHandler.mission.busy) {
+                        MavlinkHandler.mission.cancel()
+                    } else {
+                        MavlinkHandler.downloadMission(applicationDirPath + "/logs/mission.waypoints")
+                    }
+                }
+                background: Rectangle {
+                    color: parent.down ? "#2980b9" : "#3498db"
+                    radius: 4
+                }
+                contentItem: Text {
+                    text: parent.text
+                    color: "white"
+                    horizontalAlignment: Text.AlignHCenter
+                    font.pixelSize: 12
+                }
+            }
+
+            Button {
+                text: "Put"
+                enabled: !MavlinkHandler.mission.busy
+                Layout.preferredWidth: 38
+                onClicked: {
+                    MavlinkHandler.uploadMission(applicationDirPath + "/logs/mission.waypoints")
+                }
+                background: Rectangle {
+                    color: parent.down ? "#d35400" : "#e67e22"
+                    radius: 4
+                }
+                contentItem: Text {
+                    text: parent.text
+                    color: "white"
+                    horizontalAlignment: Text.AlignHCenter
+                    font.pixelSize: 12
+                }
+            }
+        }
+
+        // MAVLink FTP: скачивание файла с борта в logs/
+        RowLayout {
+            Layout.fillWidth: true
+            spacing: 10
+
+            Text {
+                text: "FTP:"
+                color: "white"
+                font.pixelSize: 12
+                Layout.preferredWidth: 80
+            }
+
+            ColumnLayout {
+                Layout.fillWidth: true
+                spacing: 2
+
+                TextField {
+                    id: ftpPathField
+                    Layout.fillWidth: true
+                    text: "@PARAM/param.pck"
+                    enabled: !MavlinkHandler.ftp.busy
+                    font.pixelSize: 11
+                }
+
+                ProgressBar {
+                    Layout.fillWidth: true
+                    value: MavlinkHandler.ftp.progress
+                }
+
+                Text {
+                    text: MavlinkHandler.ftp.state + "  "
+                          + (MavlinkHandler.ftp.bytesReceived / 1024).toFixed(0) + "/"
+                          + (MavlinkHandler.ftp.fileSize / 1024).toFixed(0) + " KB  "
+                          + (MavlinkHandler.ftp.bytesPerSecond / 1024).toFixed(1) + " KB/s"
+                    color: "#bdc3c7"
+                    font.pixelSize: 10
+                }
+            }
+
+            Button {
+                text: MavlinkHandler.ftp.busy ? "Stop" : "Get"
+                Layout.preferredWidth: 38
+                onClicked: {
+                    if (MavlinkHandler.ftp.busy) {
+                        MavlinkHandler.ftp.cancel()
+                    } else {
+                        var name = ftpPathField.text.split("/").pop()
+                        MavlinkHandler.downloadFile(ftpPathField.text, applicationDirPath + "/logs/" + name)
+                    }
+                }
+                background: Rectangle {
+                    color: parent.down ? "#2980b9" : "#3498db"
+                    radius: 4
+                }
+                contentItem: Text {
+                    text: parent.text
+                    color: "white"
+                    horizontalAlignment: Text.AlignHCenter
+                    font.pixelSize: 12
+                }
+            }
+        }
+
         // Кнопки управления
         RowLayout {
             Layout.fillWidth: true
@@ -96,7 +318,7 @@ Rectangle {
                 text: "High Rate"
                 Layout.fillWidth: true
                 onClicked: {
-                    mavlinkHandler.enableHighRateMode()
+                    MavlinkHandler.enableHighRateMode()
                 }
                 background: Rectangle {
                     color: parent.down ? "#c0392b" : "#e74c3c"
@@ -114,7 +336,7 @@ Rectangle {
                 text: "Reset"
                 Layout.fillWidth: true
                 onClicked: {
-                    mavlinkHandler.resetStreamingToDefaults()
+                    MavlinkHandler.resetStreamingToDefaults()
                 }
                 background: Rectangle {
                     color: parent.down ? "#7f8c8d" : "#95a5a6"
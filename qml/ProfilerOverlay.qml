@@ -0,0 +1,78 @@
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+
+// Задержки стадий конвейера "датаграмма -> экран" и их частота
+Rectangle {
+    id: profilerOverlay
+    implicitWidth: 330
+    implicitHeight: overlayLayout.implicitHeight + 20
+    color: "#cc1c2833"
+    radius: 6
+    border.color: "#f39c12"
+    border.width: 1
+
+    ColumnLayout {
+        id: overlayLayout
+        anchors.fill: parent
+        anchors.margins: 10
+        spacing: 4
+
+        Text {
+            text: "Pipeline (" + PipelineProfiler.timestampSource + ")"
+            font.pixelSize: 13
+            font.bold: true
+            color: "#f39c12"
+        }
+
+        RowLayout {
+            spacing: 12
+            Text { text: "Stage"; font.pixelSize: 11; color: "#bdc3c7"; Layout.preferredWidth: 70 }
+            Text { text: "Rate/s"; font.pixelSize: 11; color: "#bdc3c7"; Layout.preferredWidth: 60; horizontalAlignment: Text.AlignRight }
+            Text { text: "Avg µs"; font.pixelSize: 11; color: "#bdc3c7"; Layout.preferredWidth: 60; horizontalAlignment: Text.AlignRight }
+            Text { text: "Max µs"; font.pixelSize: 11; color: "#bdc3c7"; Layout.preferredWidth: 60; horizontalAlignment: Text.AlignRight }
+        }
+
+        Repeater {
+            model: PipelineProfiler.stages
+            delegate: RowLayout {
+                required property var modelData
+                spacing: 12
+
+                Text {
+                    text: modelData.name
+                    font.pixelSize: 12; color: "white"
+                    Layout.preferredWidth: 70
+                }
+                Text {
+                    text: modelData.rate.toFixed(1)
+                    font.pixelSize: 12; font.family: "monospace"; color: "white"
+                    Layout.preferredWidth: 60; horizontalAlignment: Text.AlignRight
+                }
+                Text {
+                    text: modelData.avgUs.toFixed(1)
+                    font.pixelSize: 12; font.family: "monospace"; color: "#2ecc71"
+                    Layout.preferredWidth: 60; horizontalAlignment: Text.AlignRight
+                }
+                Text {
+                    text: modelData.maxUs.toFixed(1)
+                    font.pixelSize: 12; font.family: "monospace"; color: "#f1c40f"
+                    Layout.preferredWidth: 60; horizontalAlignment: Text.AlignRight
+                }
+            }
+        }
+
+        Text {
+            visible: PipelineProfiler.droppedEvents > 0
+            text: "Dropped events: " + PipelineProfiler.droppedEvents
+            font.pixelSize: 11
+            color: "#e74c3c"
+        }
+
+        Button {
+            Layout.fillWidth: true
+            text: "Export Chrome trace"
+            onClicked: PipelineProfiler.exportChromeTrace(applicationDirPath + "/pipeline-trace.json")
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include "allocationcounter.h"
+
+#ifdef MAVLINKREADER_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// POD без конструкторов: доступен из malloc в любой момент жизни потока
+thread_local quint64 t_allocations = 0;
+thread_local quint64 t_bytes = 0;
+
+inline void countAllocation(size_t size)
+{
+    t_allocations++;
+    t_bytes += size;
+}
+
+} // namespace
+
+#if defined(__GLIBC__)
+
+// Подмена в исполняемом файле перекрывает malloc для Qt и libstdc++
+// (operator new в libstdc++ вызывает malloc, поэтому он тоже учитывается).
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    countAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+}
+
+#else
+
+void *operator new(std::size_t size)
+{
+    countAllocation(size);
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    countAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+
+#endif
+
+namespace AllocationCounter {
+
+bool isAvailable()
+{
+    return true;
+}
+
+quint64 allocations()
+{
+    return t_allocations;
+}
+
+quint64 bytes()
+{
+    return t_bytes;
+}
+
+} // namespace AllocationCounter
+
+#else
+
+namespace AllocationCounter {
+
+bool isAvailable()
+{
+    return false;
+}
+
+quint64 allocations()
+{
+    return 0;
+}
+
+quint64 bytes()
+{
+    return 0;
+}
+
+} // namespace AllocationCounter
+
+#endif // MAVLINKREADER_COUNT_ALLOCATIONS
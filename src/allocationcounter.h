@@ -0,0 +1,31 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+// Счетчик выделений памяти в куче для проверки пути приема (--alloc-benchmark).
+// Работает только в сборке с MAVLINKREADER_COUNT_ALLOCATIONS: тогда malloc,
+// calloc и realloc (glibc) или operator new (остальные платформы) подменяются
+// версиями со счетчиком. В обычной сборке счетчики всегда равны нулю.
+namespace AllocationCounter {
+
+bool isAvailable();
+
+// Выделения и байты в текущем потоке с момента его запуска
+quint64 allocations();
+quint64 bytes();
+
+// Выделения между созданием и вызовом count() в текущем потоке
+class Scope
+{
+public:
+    Scope() : m_start(allocations()) {}
+    quint64 count() const { return allocations() - m_start; }
+
+private:
+    quint64 m_start;
+};
+
+} // namespace AllocationCounter
+
+#endif // ALLOCATIONCOUNTER_H
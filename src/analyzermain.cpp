@@ -0,0 +1,99 @@
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QLoggingCategory>
+#include <cstdio>
+#include <thread>
+#include "loganalyzer.h"
+
+// Пакетный анализ логов полетов без GUI:
+//   mavlinkanalyzer [-j N] [--csv summary.csv] <каталог или файл>...
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    app.setApplicationName("MAVLink Log Analyzer");
+    app.setApplicationVersion("1.0.0");
+    app.setOrganizationName("SpeedyBee");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Summarize .tlog and .mavarc flight logs in parallel.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("paths", "Log files or directories (searched recursively).", "<path>...");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs",
+        "Number of worker threads (default: all cores).", "n", "0");
+    QCommandLineOption csvOption("csv",
+        "Also write one CSV row per flight to <file>.", "file");
+    QCommandLineOption outageOption("outage-ms",
+        "Gap between vehicle frames counted as a link outage.", "ms", "1000");
+    QCommandLineOption attitudeOption("min-attitude-hz",
+        "ATTITUDE rate below which a second counts as degraded.", "hz", "25");
+    QCommandLineOption segmentOption("segment-mb",
+        "Size of the file segments processed in parallel.", "mb", "8");
+    parser.addOption(jobsOption);
+    parser.addOption(csvOption);
+    parser.addOption(outageOption);
+    parser.addOption(attitudeOption);
+    parser.addOption(segmentOption);
+    parser.process(app);
+
+    if (parser.positionalArguments().isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    // Сообщения архива о каждом открытии блока здесь не нужны
+    QLoggingCategory::setFilterRules("default.debug=false");
+
+    LogAnalyzer::Options options;
+    options.threads = parser.value(jobsOption).toInt();
+    options.outageUs = parser.value(outageOption).toLongLong() * 1000;
+    options.minAttitudeHz = parser.value(attitudeOption).toInt();
+    options.segmentBytes = qBound(1, parser.value(segmentOption).toInt(), 1024) * 1024 * 1024;
+
+    QStringList files;
+    for (const QString &path : parser.positionalArguments()) {
+        files << LogAnalyzer::findLogs(path);
+    }
+    if (files.isEmpty()) {
+        fprintf(stderr, "No .tlog or .mavarc files found\n");
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    LogAnalyzer analyzer(options);
+    const QList<LogAnalyzer::FlightSummary> summaries = analyzer.analyze(files);
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    quint64 bytes = 0;
+    int failed = 0;
+    for (const LogAnalyzer::FlightSummary &summary : summaries) {
+        fputs(qPrintable(LogAnalyzer::formatSummary(summary, options.minAttitudeHz)), stdout);
+        fputs("\n", stdout);
+        bytes += summary.bytes;
+        if (summary.frames == 0) {
+            failed++;
+        }
+    }
+
+    const int threads = options.threads > 0 ? options.threads : int(std::thread::hardware_concurrency());
+    fprintf(stderr, "%lld logs, %.1f MB of frames in %.2f s (%.0f MB/s, %d threads, %llu stolen tasks)\n",
+            static_cast<long long>(summaries.size()), bytes / 1e6, seconds, seconds > 0 ? bytes / 1e6 / seconds : 0.0,
+            threads, static_cast<unsigned long long>(analyzer.stolenTasks()));
+
+    if (parser.isSet(csvOption)) {
+        QFile csv(parser.value(csvOption));
+        if (!csv.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            fprintf(stderr, "Cannot write %s: %s\n", qPrintable(csv.fileName()), qPrintable(csv.errorString()));
+            return 1;
+        }
+        csv.write(LogAnalyzer::csvHeader());
+        for (const LogAnalyzer::FlightSummary &summary : summaries) {
+            csv.write(LogAnalyzer::csvRow(summary));
+        }
+    }
+
+    return failed == int(summaries.size()) ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+#include "archivereplay.h"
+#include <QDebug>
+
+ArchiveReplay::ArchiveReplay(QObject *parent)
+    : MavlinkSource(parent)
+    , m_hasPending(false)
+    , m_speed(1.0)
+    , m_baseUs(0)
+    , m_positionUs(0)
+    , m_task(0)
+{
+}
+
+ArchiveReplay::~ArchiveReplay()
+{
+    stop();
+}
+
+bool ArchiveReplay::open(const QString &path)
+{
+    stop();
+    m_hasPending = false;
+    if (!m_reader.open(path)) {
+        return false;
+    }
+
+    m_positionUs = m_reader.startUs();
+    qDebug() << "📼 Replaying archive:" << path << m_reader.frameCount() << "frames,"
+             << (m_reader.endUs() - m_reader.startUs()) / 1000000 << "s in" << m_reader.chunks().size() << "chunks";
+    return true;
+}
+
+void ArchiveReplay::setMessageFilter(const QSet<quint32> &msgIds)
+{
+    m_reader.setFilter(msgIds);
+    seek(m_positionUs);
+}
+
+void ArchiveReplay::setSpeed(double speed)
+{
+    // Пересчитываем базу, чтобы смена скорости не вызывала скачка
+    m_baseUs = positionUs();
+    m_clock.restart();
+    m_speed = speed;
+}
+
+bool ArchiveReplay::seek(qint64 timestampUs)
+{
+    m_hasPending = false;
+    if (!m_reader.seek(timestampUs)) {
+        return false;
+    }
+    m_positionUs = qMax(timestampUs, m_reader.startUs());
+    m_baseUs = m_positionUs;
+    m_clock.restart();
+    return true;
+}
+
+void ArchiveReplay::start()
+{
+    if (m_task || !m_reader.isOpen()) {
+        return;
+    }
+    m_baseUs = m_positionUs;
+    m_clock.restart();
+    m_task = Scheduler::instance()->scheduleRepeating(TickMs, this, [this]() {
+        tick();
+    });
+}
+
+void ArchiveReplay::stop()
+{
+    Scheduler::instance()->cancel(m_task);
+    m_task = 0;
+}
+
+bool ArchiveReplay::isRunning() const
+{
+    return m_task != 0;
+}
+
+qint64 ArchiveReplay::startUs() const
+{
+    return m_reader.startUs();
+}
+
+qint64 ArchiveReplay::endUs() const
+{
+    return m_reader.endUs();
+}
+
+qint64 ArchiveReplay::positionUs() const
+{
+    return m_positionUs;
+}
+
+void ArchiveReplay::tick()
+{
+    const bool unpaced = m_speed <= 0.0;
+    const qint64 targetUs = m_baseUs + qint64(m_clock.nsecsElapsed() / 1000 * m_speed);
+
+    // Все кадры, чье время уже наступило, одной пачкой (как датаграммы UDP)
+    QByteArray batch;
+    for (;;) {
+        if (!m_hasPending && !m_reader.readNext(&m_pending)) {
+            if (!batch.isEmpty()) {
+                emit dataReceived(batch);
+            }
+            stop();
+            qDebug() << "📼 Archive replay finished";
+            emit finished();
+            return;
+        }
+        m_hasPending = true;
+
+        if ((!unpaced && m_pending.timestampUs > targetUs) || batch.size() >= MaxBatchBytes) {
+            break;
+        }
+        batch.append(m_pending.frame);
+        m_positionUs = m_pending.timestampUs;
+        m_hasPending = false;
+    }
+
+    if (!batch.isEmpty()) {
+        emit dataReceived(batch);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef ARCHIVEREPLAY_H
+#define ARCHIVEREPLAY_H
+
+#include <QElapsedTimer>
+#include <QSet>
+#include "mavlinksource.h"
+#include "flightarchive.h"
+#include "scheduler.h"
+
+// Воспроизведение архива полета как источника MAVLink.
+// Кадры выдаются пачками с исходными интервалами (с учетом скорости),
+// так что MavlinkHandler видит тот же поток байтов, что и при приеме по UDP.
+class ArchiveReplay : public MavlinkSource
+{
+    Q_OBJECT
+
+public:
+    explicit ArchiveReplay(QObject *parent = nullptr);
+    ~ArchiveReplay();
+
+    bool open(const QString &path);
+
+    // Пустой набор - все сообщения. Блоки без нужных msgid не распаковываются.
+    void setMessageFilter(const QSet<quint32> &msgIds);
+
+    // 1.0 - реальное время, <= 0 - максимально быстро
+    void setSpeed(double speed);
+
+    // Переход к моменту fromUs (Unix мкс); работает и во время воспроизведения
+    bool seek(qint64 timestampUs);
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    qint64 startUs() const;
+    qint64 endUs() const;
+    qint64 positionUs() const;
+
+signals:
+    void finished();
+
+private:
+    void tick();
+
+    static constexpr int TickMs = 20;
+    static constexpr int MaxBatchBytes = 64 * 1024;
+
+    FlightArchive::Reader m_reader;
+    FlightArchive::Record m_pending;
+    bool m_hasPending;
+    double m_speed;
+
+    // Соответствие архивного времени и часов воспроизведения
+    QElapsedTimer m_clock;
+    qint64 m_baseUs;
+    qint64 m_positionUs;
+
+    Scheduler::TaskId m_task;
+};
+
+#endif // ARCHIVEREPLAY_H
@@ -0,0 +1,60 @@
+#include "bufferpool.h"
+#include <vector>
+
+namespace {
+
+struct ThreadPool {
+    std::vector<QByteArray> free;
+    quint64 misses = 0;
+};
+
+ThreadPool &threadPool()
+{
+    thread_local ThreadPool pool;
+    return pool;
+}
+
+} // namespace
+
+QByteArray BufferPool::acquire(int size)
+{
+    ThreadPool &pool = threadPool();
+    if (size > BufferSize || pool.free.empty()) {
+        pool.misses++;
+        QByteArray buffer;
+        buffer.reserve(qMax(size, BufferSize));
+        buffer.resize(size);
+        return buffer;
+    }
+
+    QByteArray buffer = std::move(pool.free.back());
+    pool.free.pop_back();
+    buffer.resize(size); // в пределах емкости, без выделения
+    return buffer;
+}
+
+void BufferPool::release(QByteArray &&buffer)
+{
+    ThreadPool &pool = threadPool();
+    // Только собственные буферы стандартного размера без чужих ссылок
+    if (!buffer.isDetached() || buffer.capacity() < BufferSize || buffer.capacity() > 2 * BufferSize) {
+        return;
+    }
+    if (pool.free.size() >= size_t(MaxFree)) {
+        return;
+    }
+    if (pool.free.capacity() < size_t(MaxFree)) {
+        pool.free.reserve(MaxFree);
+    }
+    pool.free.push_back(std::move(buffer));
+}
+
+int BufferPool::freeCount()
+{
+    return int(threadPool().free.size());
+}
+
+quint64 BufferPool::missCount()
+{
+    return threadPool().misses;
+}
@@ -0,0 +1,42 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <QByteArray>
+
+// Пул буферов приема фиксированного размера, свой в каждом потоке.
+// Датаграмма читается в буфер из пула и после обработки возвращается в него,
+// поэтому в установившемся режиме прием не обращается к куче.
+// Буфер, на который остались ссылки (получатель сохранил копию QByteArray),
+// в пул не возвращается: освободится вместе с последней копией.
+class BufferPool
+{
+public:
+    static constexpr int BufferSize = 2048;  // больше MTU, датаграммы MAVLink помещаются целиком
+    static constexpr int MaxFree = 16;       // свободных буферов на поток
+
+    // Буфер длины size; больше BufferSize - обычное выделение мимо пула
+    static QByteArray acquire(int size);
+    static void release(QByteArray &&buffer);
+
+    // Свободные буферы и выделения мимо пула в текущем потоке
+    static int freeCount();
+    static quint64 missCount();
+
+    // Буфер из пула на время области видимости
+    class Lease
+    {
+    public:
+        explicit Lease(int size) : m_buffer(BufferPool::acquire(size)) {}
+        ~Lease() { BufferPool::release(std::move(m_buffer)); }
+
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        QByteArray &buffer() { return m_buffer; }
+
+    private:
+        QByteArray m_buffer;
+    };
+};
+
+#endif // BUFFERPOOL_H
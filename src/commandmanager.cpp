@@ -0,0 +1,278 @@
+#include "commandmanager.h"
+#include "mavlinkprotocol.h"
+#include <QDebug>
+
+namespace {
+
+constexpr quint32 MsgCommandInt = 75;
+constexpr quint32 MsgCommandLong = 76;
+constexpr quint32 MsgCommandAck = 77;
+
+constexpr quint16 CmdSetMessageInterval = 511;  // MAV_CMD_SET_MESSAGE_INTERVAL
+constexpr quint8 ResultInProgress = 5;          // MAV_RESULT_IN_PROGRESS
+
+// Смещения полей, общих для COMMAND_LONG и COMMAND_INT
+constexpr int CommandOffset = 28;
+constexpr int ConfirmationOffset = 32;          // только COMMAND_LONG
+
+constexpr int ServiceIntervalMs = 20;
+
+} // namespace
+
+QString CommandResult::resultName() const
+{
+    switch (result) {
+    case Timeout: return "TIMEOUT";
+    case Cancelled: return "CANCELLED";
+    case 0: return "ACCEPTED";
+    case 1: return "TEMPORARILY_REJECTED";
+    case 2: return "DENIED";
+    case 3: return "UNSUPPORTED";
+    case 4: return "FAILED";
+    case 5: return "IN_PROGRESS";
+    case 6: return "CANCELLED";
+    case 7: return "COMMAND_LONG_ONLY";
+    case 8: return "COMMAND_INT_ONLY";
+    case 9: return "UNSUPPORTED_MAV_FRAME";
+    default: return QString("RESULT_%1").arg(result);
+    }
+}
+
+CommandManager::CommandManager(QObject *parent)
+    : QObject(parent)
+    , m_retransmissions(0)
+    , m_serviceTask(0)
+{
+    m_clock.start();
+}
+
+CommandManager::~CommandManager()
+{
+    cancelAll();
+}
+
+QFuture<CommandResult> CommandManager::sendCommandLong(quint8 targetSystem, quint8 targetComponent, quint16 command,
+                                                       const QList<float> &params)
+{
+    QByteArray payload;
+    for (int i = 0; i < 7; i++) {
+        Mavlink::appendField<float>(payload, i < params.size() ? params[i] : 0.0f);
+    }
+    Mavlink::appendField<quint16>(payload, command);
+    payload.append(char(targetSystem));
+    payload.append(char(targetComponent));
+    payload.append(char(0)); // confirmation, растет с каждым повтором
+    return submit(targetSystem, targetComponent, command, MsgCommandLong, payload);
+}
+
+QFuture<CommandResult> CommandManager::sendCommandInt(quint8 targetSystem, quint8 targetComponent, quint16 command,
+                                                      quint8 frame, const QList<float> &params,
+                                                      qint32 x, qint32 y, float z)
+{
+    QByteArray payload;
+    for (int i = 0; i < 4; i++) {
+        Mavlink::appendField<float>(payload, i < params.size() ? params[i] : 0.0f);
+    }
+    Mavlink::appendField<qint32>(payload, x);
+    Mavlink::appendField<qint32>(payload, y);
+    Mavlink::appendField<float>(payload, z);
+    Mavlink::appendField<quint16>(payload, command);
+    payload.append(char(targetSystem));
+    payload.append(char(targetComponent));
+    payload.append(char(frame));
+    payload.append(char(0)); // current
+    payload.append(char(0)); // autocontinue
+    return submit(targetSystem, targetComponent, command, MsgCommandInt, payload);
+}
+
+QFuture<CommandResult> CommandManager::setMessageInterval(quint8 targetSystem, quint8 targetComponent,
+                                                          quint32 msgId, qint32 intervalUs)
+{
+    return sendCommandLong(targetSystem, targetComponent, CmdSetMessageInterval,
+                           {float(msgId), float(intervalUs)});
+}
+
+int CommandManager::pending() const
+{
+    return int(m_transactions.size());
+}
+
+double CommandManager::rttMs() const
+{
+    return m_rtt.rttMs();
+}
+
+int CommandManager::retransmissions() const
+{
+    return m_retransmissions;
+}
+
+void CommandManager::setInitialRtt(double rttMs)
+{
+    m_rtt.setInitialRtt(rttMs);
+}
+
+void CommandManager::cancelAll()
+{
+    while (!m_transactions.empty()) {
+        finish(m_transactions.begin(), CommandResult::Cancelled);
+    }
+}
+
+bool CommandManager::isCommandMessage(quint32 msgId)
+{
+    return msgId == MsgCommandAck;
+}
+
+QFuture<CommandResult> CommandManager::submit(quint8 targetSystem, quint8 targetComponent, quint16 command,
+                                              quint32 msgId, const QByteArray &payload)
+{
+    m_transactions.emplace_back();
+    Transaction &transaction = m_transactions.back();
+    transaction.targetSystem = targetSystem;
+    transaction.targetComponent = targetComponent;
+    transaction.command = command;
+    transaction.msgId = msgId;
+    transaction.payload = payload;
+    transaction.promise.start();
+    QFuture<CommandResult> future = transaction.promise.future();
+
+    startWaiting();
+    if (m_serviceTask == 0) {
+        m_serviceTask = Scheduler::instance()->scheduleRepeating(ServiceIntervalMs, this, [this]() {
+            service();
+        });
+    }
+    emit pendingChanged();
+    return future;
+}
+
+bool CommandManager::keyBusy(const Transaction &transaction) const
+{
+    for (const Transaction &other : m_transactions) {
+        if (other.active && other.command == transaction.command && other.targetSystem == transaction.targetSystem
+            && other.targetComponent == transaction.targetComponent) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CommandManager::startWaiting()
+{
+    // ACK не отличает две одинаковые команды одной цели - они идут по очереди
+    for (Transaction &transaction : m_transactions) {
+        if (!transaction.active && !keyBusy(transaction)) {
+            transaction.active = true;
+            transmit(transaction);
+        }
+    }
+}
+
+void CommandManager::transmit(Transaction &transaction)
+{
+    if (transaction.attempts > 0) {
+        m_retransmissions++;
+        if (transaction.msgId == MsgCommandLong) {
+            transaction.payload[ConfirmationOffset] = char(qMin(transaction.attempts, 255));
+        }
+    }
+    transaction.attempts++;
+    transaction.sentNs = m_clock.nsecsElapsed();
+    transaction.deadlineNs = transaction.sentNs + qMin(RttEstimator::MaxRtoNs, m_rtt.rtoNs() << (transaction.attempts - 1));
+    emit frameReady(Mavlink::packMessage(transaction.msgId, transaction.payload));
+}
+
+void CommandManager::finish(Iterator it, int result, qint32 resultParam2)
+{
+    CommandResult outcome;
+    outcome.command = it->command;
+    outcome.result = result;
+    outcome.progress = it->progress;
+    outcome.resultParam2 = resultParam2;
+    outcome.attempts = it->attempts;
+    if (result >= 0) {
+        outcome.rttMs = double(m_clock.nsecsElapsed() - it->sentNs) / 1e6;
+    }
+
+    if (!outcome.accepted()) {
+        qDebug() << "⚠️ Command" << outcome.command << "to" << it->targetSystem << ":" << it->targetComponent
+                 << outcome.resultName() << "after" << outcome.attempts << "attempts";
+    }
+
+    // Обещание выполняется после удаления, чтобы продолжения видели актуальную очередь
+    QPromise<CommandResult> promise = std::move(it->promise);
+    m_transactions.erase(it);
+    startWaiting();
+    if (m_transactions.empty()) {
+        Scheduler::instance()->cancel(m_serviceTask);
+        m_serviceTask = 0;
+    }
+
+    promise.addResult(outcome);
+    promise.finish();
+    emit commandFinished(outcome.command, outcome.result);
+    emit pendingChanged();
+}
+
+void CommandManager::handleMessage(quint8 sysid, quint8 compid, quint32 msgId, const char *payload, int payloadLen)
+{
+    if (msgId != MsgCommandAck) {
+        return;
+    }
+
+    const quint16 command = Mavlink::readField<quint16>(payload, payloadLen, 0);
+    const quint8 result = Mavlink::readField<quint8>(payload, payloadLen, 2);
+    const quint8 progress = Mavlink::readField<quint8>(payload, payloadLen, 3);
+    const qint32 resultParam2 = Mavlink::readField<qint32>(payload, payloadLen, 4);
+
+    // Подтверждения для другой наземной станции пропускаем (поле только в MAVLink 2)
+    const quint8 target = Mavlink::readField<quint8>(payload, payloadLen, 8);
+    if (target != 0 && target != Mavlink::GcsSystemId) {
+        return;
+    }
+
+    for (auto it = m_transactions.begin(); it != m_transactions.end(); ++it) {
+        if (!it->active || it->command != command
+            || (it->targetSystem != 0 && it->targetSystem != sysid)
+            || (it->targetComponent != 0 && it->targetComponent != compid)) {
+            continue;
+        }
+
+        // Замеры только по командам без повторов (алгоритм Карна)
+        const qint64 now = m_clock.nsecsElapsed();
+        if (it->attempts == 1 && !it->inProgress) {
+            m_rtt.sample(now - it->sentNs);
+        }
+
+        if (result == ResultInProgress) {
+            // Борт выполняет команду - ждем без повторов
+            it->inProgress = true;
+            it->progress = progress;
+            it->deadlineNs = now + qint64(InProgressTimeoutMs) * 1000000LL;
+            return;
+        }
+        finish(it, result, resultParam2);
+        return;
+    }
+}
+
+void CommandManager::service()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    for (auto it = m_transactions.begin(); it != m_transactions.end();) {
+        if (!it->active || now < it->deadlineNs) {
+            ++it;
+            continue;
+        }
+        if (it->inProgress || it->attempts >= MaxAttempts) {
+            auto expired = it++;
+            finish(expired, CommandResult::Timeout);
+            // finish мог запустить ожидавшие команды - начинаем обход заново
+            it = m_transactions.begin();
+            continue;
+        }
+        transmit(*it);
+        ++it;
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef COMMANDMANAGER_H
+#define COMMANDMANAGER_H
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QList>
+#include <QObject>
+#include <QPromise>
+#include <QtQml/qqmlregistration.h>
+#include <list>
+#include "rttestimator.h"
+#include "scheduler.h"
+
+// Итог команды: MAV_RESULT из COMMAND_ACK или локальный отказ
+struct CommandResult {
+    enum LocalResult {
+        Timeout = -1,       // ни одного ответа за все попытки
+        Cancelled = -2      // отключение или cancelAll()
+    };
+
+    quint16 command = 0;
+    int result = Timeout;   // MAV_RESULT (0 - ACCEPTED) или LocalResult
+    quint8 progress = 0;    // последний процент из MAV_RESULT_IN_PROGRESS
+    qint32 resultParam2 = 0;
+    int attempts = 0;
+    double rttMs = 0.0;     // от последней отправки до финального ACK
+
+    bool accepted() const { return result == 0; }
+    QString resultName() const;
+};
+
+Q_DECLARE_METATYPE(CommandResult)
+
+// Транзакции COMMAND_LONG / COMMAND_INT с подтверждением COMMAND_ACK.
+// Каждая отправка возвращает QFuture с итогом; ACK сопоставляется по
+// (целевая система, компонент, команда), поэтому в полете не больше одной
+// команды с одним номером на цель - следующие ждут в очереди, остальные
+// идут параллельно через один общий диспетчер. Таймаут считается по
+// измеренному RTT (как RTO в TCP) и удваивается с каждым повтором;
+// повторы COMMAND_LONG увеличивают поле confirmation. Пока борт отвечает
+// MAV_RESULT_IN_PROGRESS, команда не повторяется.
+class CommandManager : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Provided by MavlinkHandler.commands")
+
+    Q_PROPERTY(int pending READ pending NOTIFY pendingChanged)
+    Q_PROPERTY(double rttMs READ rttMs NOTIFY pendingChanged)
+    Q_PROPERTY(int retransmissions READ retransmissions NOTIFY pendingChanged)
+
+public:
+    static constexpr int MaxAttempts = 5;
+    static constexpr int InProgressTimeoutMs = 5000;    // тишина после IN_PROGRESS
+
+    explicit CommandManager(QObject *parent = nullptr);
+    ~CommandManager();
+
+    // params - до 7 (COMMAND_LONG) или до 4 (COMMAND_INT) значений, остальные нули
+    QFuture<CommandResult> sendCommandLong(quint8 targetSystem, quint8 targetComponent, quint16 command,
+                                           const QList<float> &params);
+    QFuture<CommandResult> sendCommandInt(quint8 targetSystem, quint8 targetComponent, quint16 command,
+                                          quint8 frame, const QList<float> &params,
+                                          qint32 x = 0, qint32 y = 0, float z = 0.0f);
+
+    // MAV_CMD_SET_MESSAGE_INTERVAL: интервал в мкс, -1 - выключить, 0 - по умолчанию
+    QFuture<CommandResult> setMessageInterval(quint8 targetSystem, quint8 targetComponent,
+                                              quint32 msgId, qint32 intervalUs);
+
+    int pending() const;
+    double rttMs() const;
+    int retransmissions() const;
+
+    // Начальная оценка RTT (например, из TIMESYNC), пока нет своих замеров
+    void setInitialRtt(double rttMs);
+
+    // Все незавершенные команды получают CommandResult::Cancelled
+    Q_INVOKABLE void cancelAll();
+
+    static bool isCommandMessage(quint32 msgId);
+    void handleMessage(quint8 sysid, quint8 compid, quint32 msgId, const char *payload, int payloadLen);
+
+signals:
+    void frameReady(const QByteArray &frame);
+    void pendingChanged();
+    void commandFinished(quint16 command, int result);
+
+private:
+    struct Transaction {
+        quint8 targetSystem = 0;
+        quint8 targetComponent = 0;
+        quint16 command = 0;
+        quint32 msgId = 0;          // COMMAND_LONG или COMMAND_INT
+        QByteArray payload;
+        bool active = false;        // отправлена и ждет ACK
+        bool inProgress = false;
+        int attempts = 0;
+        qint64 sentNs = 0;
+        qint64 deadlineNs = 0;
+        quint8 progress = 0;
+        QPromise<CommandResult> promise;
+    };
+    using Iterator = std::list<Transaction>::iterator;
+
+    QFuture<CommandResult> submit(quint8 targetSystem, quint8 targetComponent, quint16 command,
+                                  quint32 msgId, const QByteArray &payload);
+    bool keyBusy(const Transaction &transaction) const;
+    void startWaiting();
+    void transmit(Transaction &transaction);
+    void finish(Iterator it, int result, qint32 resultParam2 = 0);
+    void service();
+
+    std::list<Transaction> m_transactions;  // в порядке отправки
+    int m_retransmissions;
+
+    RttEstimator m_rtt;
+
+    QElapsedTimer m_clock;
+    Scheduler::TaskId m_serviceTask;
+};
+
+#endif // COMMANDMANAGER_H
@@ -0,0 +1,572 @@
+#include "flightarchive.h"
+#include "mavlinkprotocol.h"
+#include <QDebug>
+#include <algorithm>
+
+#ifdef MAVLINKREADER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace FlightArchive {
+
+namespace {
+
+const char FileMagic[8] = { 'M', 'A', 'V', 'A', 'R', 'C', '0', '1' };
+const char IndexMagic[8] = { 'M', 'A', 'V', 'I', 'D', 'X', '0', '1' };
+constexpr quint32 ChunkMagic = 0x4B4E4843; // "CHNK"
+
+constexpr int ChunkHeaderSize = 100;
+constexpr int IndexEntrySize = 8 + ChunkHeaderSize;
+constexpr int TrailerSize = 8 + 4 + 8;
+constexpr int RecordHeaderSize = 12;
+
+// Блок закрывается по объему или по длительности (delta_us должен влезть в u32)
+constexpr int ChunkRawBytes = 256 * 1024;
+constexpr qint64 ChunkMaxSpanUs = 30LL * 1000000;
+
+void writeHeader(QByteArray &out, const ChunkInfo &chunk)
+{
+    Mavlink::appendField<quint32>(out, ChunkMagic);
+    out.append(char(chunk.codec));
+    out.append(3, '\0');
+    Mavlink::appendField<quint32>(out, chunk.rawSize);
+    Mavlink::appendField<quint32>(out, chunk.storedSize);
+    Mavlink::appendField<quint32>(out, chunk.frameCount);
+    Mavlink::appendField<qint64>(out, chunk.firstUs);
+    Mavlink::appendField<qint64>(out, chunk.lastUs);
+    out.append(reinterpret_cast<const char *>(chunk.msgBitmap), sizeof(chunk.msgBitmap));
+    out.append(reinterpret_cast<const char *>(chunk.sysBitmap), sizeof(chunk.sysBitmap));
+}
+
+bool readHeader(const char *data, int length, ChunkInfo *chunk)
+{
+    if (length < ChunkHeaderSize || Mavlink::readField<quint32>(data, length, 0) != ChunkMagic) {
+        return false;
+    }
+    chunk->codec = quint8(data[4]);
+    chunk->rawSize = Mavlink::readField<quint32>(data, length, 8);
+    chunk->storedSize = Mavlink::readField<quint32>(data, length, 12);
+    chunk->frameCount = Mavlink::readField<quint32>(data, length, 16);
+    chunk->firstUs = Mavlink::readField<qint64>(data, length, 20);
+    chunk->lastUs = Mavlink::readField<qint64>(data, length, 28);
+    memcpy(chunk->msgBitmap, data + 36, sizeof(chunk->msgBitmap));
+    memcpy(chunk->sysBitmap, data + 68, sizeof(chunk->sysBitmap));
+    return true;
+}
+
+QByteArray compress(quint8 codec, const QByteArray &raw)
+{
+    switch (codec) {
+    case CodecZlib:
+        return qCompress(raw);
+#ifdef MAVLINKREADER_HAVE_ZSTD
+    case CodecZstd: {
+        QByteArray out;
+        out.resize(int(ZSTD_compressBound(size_t(raw.size()))));
+        const size_t size = ZSTD_compress(out.data(), size_t(out.size()), raw.constData(), size_t(raw.size()), 3);
+        if (ZSTD_isError(size)) {
+            return QByteArray();
+        }
+        out.resize(int(size));
+        return out;
+    }
+#endif
+    default:
+        return raw;
+    }
+}
+
+bool decompress(quint8 codec, const QByteArray &stored, quint32 rawSize, QByteArray *raw)
+{
+    switch (codec) {
+    case CodecNone:
+        *raw = stored;
+        break;
+    case CodecZlib:
+        *raw = qUncompress(stored);
+        break;
+#ifdef MAVLINKREADER_HAVE_ZSTD
+    case CodecZstd: {
+        raw->resize(int(rawSize));
+        const size_t size = ZSTD_decompress(raw->data(), rawSize, stored.constData(), size_t(stored.size()));
+        if (ZSTD_isError(size)) {
+            return false;
+        }
+        raw->resize(int(size));
+        break;
+    }
+#endif
+    default:
+        qWarning() << "❌ Archive chunk uses unsupported codec" << codecName(codec);
+        return false;
+    }
+    return quint32(raw->size()) == rawSize;
+}
+
+} // namespace
+
+bool isArchiveFile(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly)
+        && file.read(sizeof(FileMagic)) == QByteArray(FileMagic, sizeof(FileMagic));
+}
+
+Codec defaultCodec()
+{
+#ifdef MAVLINKREADER_HAVE_ZSTD
+    return CodecZstd;
+#else
+    return CodecZlib;
+#endif
+}
+
+QString codecName(quint8 codec)
+{
+    switch (codec) {
+    case CodecNone: return "none";
+    case CodecZlib: return "zlib";
+    case CodecZstd: return "zstd";
+    }
+    return QString("unknown (%1)").arg(codec);
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+
+Writer::Writer()
+    : m_codec(CodecZlib)
+    , m_lastUs(0)
+    , m_frames(0)
+    , m_stopping(false)
+    , m_failed(false)
+{
+}
+
+Writer::~Writer()
+{
+    close();
+}
+
+bool Writer::open(const QString &path, Codec codec)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "❌ Cannot create flight archive:" << path << m_file.errorString();
+        return false;
+    }
+    m_file.write(FileMagic, sizeof(FileMagic));
+
+    m_codec = codec;
+    m_current = PendingChunk();
+    m_current.raw.reserve(ChunkRawBytes + 512);
+    m_lastUs = 0;
+    m_frames = 0;
+    m_index.clear();
+    m_failed = false;
+    m_stopping = false;
+    m_thread = std::thread([this]() { run(); });
+
+    qDebug() << "💾 Recording flight archive:" << path << "codec" << codecName(codec);
+    return true;
+}
+
+void Writer::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    flushChunk();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+
+    // Индекс и хвост - после всех блоков
+    QByteArray index;
+    index.reserve(m_index.size() * IndexEntrySize + TrailerSize);
+    const qint64 indexOffset = m_file.pos();
+    for (const ChunkInfo &chunk : m_index) {
+        Mavlink::appendField<qint64>(index, chunk.offset);
+        writeHeader(index, chunk);
+    }
+    Mavlink::appendField<qint64>(index, indexOffset);
+    Mavlink::appendField<quint32>(index, quint32(m_index.size()));
+    index.append(IndexMagic, sizeof(IndexMagic));
+    m_file.write(index);
+    m_file.close();
+
+    qDebug() << "💾 Flight archive closed:" << m_file.fileName() << m_frames << "frames in"
+             << m_index.size() << "chunks" << (m_failed ? "(write errors)" : "");
+}
+
+bool Writer::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString Writer::path() const
+{
+    return m_file.fileName();
+}
+
+quint64 Writer::framesWritten() const
+{
+    return m_frames;
+}
+
+void Writer::append(qint64 timestampUs, quint8 sysid, quint8 compid, quint32 msgId, const char *frame, int length)
+{
+    if (!m_file.isOpen() || length <= 0 || length > 0xFFFF) {
+        return;
+    }
+
+    // Время в архиве не убывает (перевод системных часов)
+    timestampUs = qMax(timestampUs, m_lastUs);
+    m_lastUs = timestampUs;
+
+    ChunkInfo &info = m_current.info;
+    if (info.frameCount > 0 && timestampUs - info.firstUs > ChunkMaxSpanUs) {
+        flushChunk();
+    }
+    if (info.frameCount == 0) {
+        info.firstUs = timestampUs;
+    }
+
+    QByteArray &raw = m_current.raw;
+    Mavlink::appendField<quint32>(raw, quint32(timestampUs - info.firstUs));
+    Mavlink::appendField<quint16>(raw, quint16(length));
+    raw.append(char(sysid));
+    raw.append(char(compid));
+    Mavlink::appendField<quint32>(raw, msgId);
+    raw.append(frame, length);
+
+    info.lastUs = timestampUs;
+    info.frameCount++;
+    info.msgBitmap[(msgId & 0xFF) >> 3] |= quint8(1 << (msgId & 7));
+    info.sysBitmap[sysid >> 3] |= quint8(1 << (sysid & 7));
+    m_frames++;
+
+    if (raw.size() >= ChunkRawBytes) {
+        flushChunk();
+    }
+}
+
+void Writer::flushChunk()
+{
+    if (m_current.info.frameCount == 0) {
+        return;
+    }
+
+    m_current.info.codec = m_codec;
+    m_current.info.rawSize = quint32(m_current.raw.size());
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(m_current));
+    }
+    m_wake.notify_one();
+
+    m_current = PendingChunk();
+    m_current.raw.reserve(ChunkRawBytes + 512);
+}
+
+void Writer::run()
+{
+    for (;;) {
+        PendingChunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return; // m_stopping и все блоки записаны
+            }
+            chunk = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        if (!writeChunk(chunk)) {
+            m_failed = true;
+        }
+    }
+}
+
+bool Writer::writeChunk(PendingChunk &chunk)
+{
+    QByteArray stored = compress(chunk.info.codec, chunk.raw);
+    if (stored.isEmpty() || stored.size() >= chunk.raw.size()) {
+        // Несжимаемые данные храним как есть
+        chunk.info.codec = CodecNone;
+        stored = chunk.raw;
+    }
+    chunk.info.storedSize = quint32(stored.size());
+    chunk.info.offset = m_file.pos();
+
+    QByteArray header;
+    header.reserve(ChunkHeaderSize);
+    writeHeader(header, chunk.info);
+
+    if (m_file.write(header) != header.size() || m_file.write(stored) != stored.size()) {
+        qWarning() << "❌ Flight archive write failed:" << m_file.errorString();
+        return false;
+    }
+    m_index.append(chunk.info);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+
+bool Reader::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "❌ Cannot open flight archive:" << path << m_file.errorString();
+        return false;
+    }
+
+    const QByteArray magic = m_file.read(sizeof(FileMagic));
+    if (magic != QByteArray(FileMagic, sizeof(FileMagic))) {
+        qWarning() << "❌ Not a flight archive:" << path;
+        m_file.close();
+        return false;
+    }
+
+    if (!readIndex()) {
+        qDebug() << "💾 Archive index missing (interrupted recording?), scanning chunks:" << path;
+        if (!scanChunks()) {
+            m_file.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void Reader::close()
+{
+    m_file.close();
+    m_chunks.clear();
+    m_chunkIndex = -1;
+    m_raw.clear();
+    m_pos = 0;
+}
+
+bool Reader::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+bool Reader::readIndex()
+{
+    const qint64 size = m_file.size();
+    if (size < qint64(sizeof(FileMagic)) + TrailerSize) {
+        return false;
+    }
+
+    m_file.seek(size - TrailerSize);
+    const QByteArray trailer = m_file.read(TrailerSize);
+    if (trailer.size() != TrailerSize || trailer.right(8) != QByteArray(IndexMagic, sizeof(IndexMagic))) {
+        return false;
+    }
+
+    const qint64 indexOffset = Mavlink::readField<qint64>(trailer.constData(), TrailerSize, 0);
+    const quint32 count = Mavlink::readField<quint32>(trailer.constData(), TrailerSize, 8);
+    if (indexOffset < qint64(sizeof(FileMagic)) || indexOffset + qint64(count) * IndexEntrySize != size - TrailerSize) {
+        return false;
+    }
+
+    m_file.seek(indexOffset);
+    const QByteArray index = m_file.read(qint64(count) * IndexEntrySize);
+    if (index.size() != int(count) * IndexEntrySize) {
+        return false;
+    }
+
+    m_chunks.clear();
+    m_chunks.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        const char *entry = index.constData() + i * IndexEntrySize;
+        ChunkInfo chunk;
+        chunk.offset = Mavlink::readField<qint64>(entry, IndexEntrySize, 0);
+        if (!readHeader(entry + 8, ChunkHeaderSize, &chunk)) {
+            m_chunks.clear();
+            return false;
+        }
+        m_chunks.append(chunk);
+    }
+    return true;
+}
+
+bool Reader::scanChunks()
+{
+    m_chunks.clear();
+    qint64 offset = sizeof(FileMagic);
+    const qint64 size = m_file.size();
+
+    while (offset + ChunkHeaderSize <= size) {
+        m_file.seek(offset);
+        const QByteArray header = m_file.read(ChunkHeaderSize);
+        ChunkInfo chunk;
+        if (!readHeader(header.constData(), header.size(), &chunk)) {
+            break;
+        }
+        if (offset + ChunkHeaderSize + chunk.storedSize > quint64(size)) {
+            break; // блок дописан не полностью
+        }
+        chunk.offset = offset;
+        m_chunks.append(chunk);
+        offset += ChunkHeaderSize + chunk.storedSize;
+    }
+    return !m_chunks.isEmpty();
+}
+
+const QList<ChunkInfo> &Reader::chunks() const
+{
+    return m_chunks;
+}
+
+qint64 Reader::startUs() const
+{
+    return m_chunks.isEmpty() ? 0 : m_chunks.first().firstUs;
+}
+
+qint64 Reader::endUs() const
+{
+    return m_chunks.isEmpty() ? 0 : m_chunks.last().lastUs;
+}
+
+quint64 Reader::frameCount() const
+{
+    quint64 count = 0;
+    for (const ChunkInfo &chunk : m_chunks) {
+        count += chunk.frameCount;
+    }
+    return count;
+}
+
+void Reader::setFilter(const QSet<quint32> &msgIds, int sysid)
+{
+    m_msgFilter = msgIds;
+    m_sysFilter = sysid;
+}
+
+bool Reader::chunkMatches(const ChunkInfo &chunk) const
+{
+    if (m_sysFilter >= 0 && !chunk.containsSystem(quint8(m_sysFilter))) {
+        return false;
+    }
+    if (m_msgFilter.isEmpty()) {
+        return true;
+    }
+    for (quint32 msgId : m_msgFilter) {
+        if (chunk.mayContainMessage(msgId)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Reader::recordMatches(const Record &record) const
+{
+    return (m_sysFilter < 0 || record.sysid == m_sysFilter)
+        && (m_msgFilter.isEmpty() || m_msgFilter.contains(record.msgId));
+}
+
+bool Reader::loadChunk(int index, QByteArray *raw) const
+{
+    const ChunkInfo &chunk = m_chunks.at(index);
+    m_file.seek(chunk.offset + ChunkHeaderSize);
+    const QByteArray stored = m_file.read(chunk.storedSize);
+    if (stored.size() != int(chunk.storedSize)) {
+        return false;
+    }
+    return decompress(chunk.codec, stored, chunk.rawSize, raw);
+}
+
+bool Reader::enterChunk(int index)
+{
+    // Блоки без нужных сообщений пропускаются без распаковки
+    for (int i = qMax(0, index); i < m_chunks.size(); ++i) {
+        if (chunkMatches(m_chunks.at(i)) && loadChunk(i, &m_raw)) {
+            m_chunkIndex = i;
+            m_pos = 0;
+            return true;
+        }
+    }
+    m_chunkIndex = m_chunks.size();
+    m_raw.clear();
+    m_pos = 0;
+    return false;
+}
+
+bool Reader::parseRecord(const QByteArray &raw, int *pos, qint64 chunkFirstUs, Record *record)
+{
+    if (*pos + RecordHeaderSize > raw.size()) {
+        return false;
+    }
+    const char *data = raw.constData() + *pos;
+    const int length = Mavlink::readField<quint16>(data, RecordHeaderSize, 4);
+    if (*pos + RecordHeaderSize + length > raw.size()) {
+        return false;
+    }
+
+    record->timestampUs = chunkFirstUs + Mavlink::readField<quint32>(data, RecordHeaderSize, 0);
+    record->sysid = quint8(data[6]);
+    record->compid = quint8(data[7]);
+    record->msgId = Mavlink::readField<quint32>(data, RecordHeaderSize, 8);
+    record->frame = raw.mid(*pos + RecordHeaderSize, length);
+    *pos += RecordHeaderSize + length;
+    return true;
+}
+
+bool Reader::seek(qint64 timestampUs)
+{
+    // Первый блок, который заканчивается не раньше нужного момента
+    auto it = std::lower_bound(m_chunks.cbegin(), m_chunks.cend(), timestampUs,
+                               [](const ChunkInfo &chunk, qint64 us) { return chunk.lastUs < us; });
+    if (!enterChunk(int(it - m_chunks.cbegin()))) {
+        return false;
+    }
+
+    // Внутри блока пропускаем записи до нужного момента
+    Record record;
+    for (;;) {
+        const int pos = m_pos;
+        if (!parseRecord(m_raw, &m_pos, m_chunks.at(m_chunkIndex).firstUs, &record)) {
+            break;
+        }
+        if (record.timestampUs >= timestampUs) {
+            m_pos = pos;
+            break;
+        }
+    }
+    return true;
+}
+
+bool Reader::readNext(Record *record)
+{
+    if (m_chunkIndex < 0 && !enterChunk(0)) {
+        return false;
+    }
+
+    while (m_chunkIndex < m_chunks.size()) {
+        if (!parseRecord(m_raw, &m_pos, m_chunks.at(m_chunkIndex).firstUs, record)) {
+            // Конец блока (или поврежденный хвост) - следующий подходящий блок
+            if (!enterChunk(m_chunkIndex + 1)) {
+                return false;
+            }
+            continue;
+        }
+        if (recordMatches(*record)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace FlightArchive
@@ -0,0 +1,149 @@
+#ifndef FLIGHTARCHIVE_H
+#define FLIGHTARCHIVE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Архив полета: кадры MAVLink с временем приема, сгруппированные в сжатые
+// блоки (chunk). Заголовок каждого блока содержит диапазон времени и битовые
+// карты msgid и sysid, в конце файла - индекс всех заголовков. Поэтому
+// читатель находит момент времени или нужные сообщения, распаковывая только
+// подходящие блоки. Без индекса (запись прервана) заголовки читаются подряд.
+//
+// Формат (little endian):
+//   "MAVARC01"
+//   блоки: ChunkHeader + сжатые записи
+//          запись: delta_us u32, len u16, sysid u8, compid u8, msgid u32, кадр
+//   индекс: (offset u64 + ChunkHeader) * N
+//   хвост: index_offset u64, chunk_count u32, "MAVIDX01"
+namespace FlightArchive {
+
+enum Codec : quint8 {
+    CodecNone = 0,
+    CodecZlib = 1,
+    CodecZstd = 2
+};
+
+struct ChunkInfo {
+    qint64 offset = 0;          // смещение заголовка блока в файле
+    quint8 codec = CodecNone;
+    quint32 rawSize = 0;
+    quint32 storedSize = 0;
+    quint32 frameCount = 0;
+    qint64 firstUs = 0;         // время приема, мкс Unix
+    qint64 lastUs = 0;
+    quint8 msgBitmap[32] = {};  // бит (msgid & 0xFF) - возможны ложные совпадения
+    quint8 sysBitmap[32] = {};
+
+    bool mayContainMessage(quint32 msgId) const { return msgBitmap[(msgId & 0xFF) >> 3] & (1 << (msgId & 7)); }
+    bool containsSystem(quint8 sysid) const { return sysBitmap[sysid >> 3] & (1 << (sysid & 7)); }
+};
+
+struct Record {
+    qint64 timestampUs = 0;
+    quint8 sysid = 0;
+    quint8 compid = 0;
+    quint32 msgId = 0;
+    QByteArray frame;
+};
+
+// Файл начинается с сигнатуры архива
+bool isArchiveFile(const QString &path);
+
+// Лучший кодек, доступный в этой сборке
+Codec defaultCodec();
+QString codecName(quint8 codec);
+
+// Запись архива. append() вызывается из потока приема и только копирует
+// кадр в текущий блок; сжатие и запись на диск - в фоновом потоке.
+class Writer
+{
+public:
+    Writer();
+    ~Writer();
+
+    bool open(const QString &path, Codec codec = defaultCodec());
+    void close();
+    bool isOpen() const;
+    QString path() const;
+
+    void append(qint64 timestampUs, quint8 sysid, quint8 compid, quint32 msgId, const char *frame, int length);
+
+    quint64 framesWritten() const;
+
+private:
+    struct PendingChunk {
+        ChunkInfo info;
+        QByteArray raw;
+    };
+
+    void flushChunk();
+    void run();
+    bool writeChunk(PendingChunk &chunk);
+
+    QFile m_file;
+    Codec m_codec;
+    PendingChunk m_current;
+    qint64 m_lastUs;
+    quint64 m_frames;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<PendingChunk> m_queue;
+    bool m_stopping;
+    QList<ChunkInfo> m_index;   // только в фоновом потоке, до close()
+    bool m_failed;
+};
+
+// Чтение архива с переходом ко времени и фильтром сообщений
+class Reader
+{
+public:
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+
+    const QList<ChunkInfo> &chunks() const;
+    qint64 startUs() const;
+    qint64 endUs() const;
+    quint64 frameCount() const;
+
+    // Пустой набор - все сообщения, sysid < 0 - все аппараты
+    void setFilter(const QSet<quint32> &msgIds, int sysid = -1);
+
+    // Следующий readNext() вернет первую запись с временем >= timestampUs
+    bool seek(qint64 timestampUs);
+    bool readNext(Record *record);
+
+    // Распаковка одного блока (для параллельной обработки по блокам)
+    bool loadChunk(int index, QByteArray *raw) const;
+    static bool parseRecord(const QByteArray &raw, int *pos, qint64 chunkFirstUs, Record *record);
+
+private:
+    bool readIndex();
+    bool scanChunks();
+    bool chunkMatches(const ChunkInfo &chunk) const;
+    bool recordMatches(const Record &record) const;
+    bool enterChunk(int index);
+
+    mutable QFile m_file;
+    QList<ChunkInfo> m_chunks;
+    QSet<quint32> m_msgFilter;
+    int m_sysFilter = -1;
+
+    int m_chunkIndex = -1;
+    QByteArray m_raw;
+    int m_pos = 0;
+};
+
+} // namespace FlightArchive
+
+#endif // FLIGHTARCHIVE_H
@@ -0,0 +1,579 @@
+#include "ftpclient.h"
+#include "mavlinkprotocol.h"
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+constexpr quint32 MsgFileTransferProtocol = 110;
+
+// payload FILE_TRANSFER_PROTOCOL: target_network, target_system, target_component,
+// затем 251 байт FTP: заголовок 12 байт и данные
+constexpr int FtpOffset = 3;
+constexpr int FtpHeaderLen = 12;
+constexpr int FtpPayloadLen = 251;
+constexpr int MaxDataLen = FtpPayloadLen - FtpHeaderLen;
+
+enum Opcode : quint8 {
+    OpTerminateSession = 1,
+    OpResetSessions = 2,
+    OpOpenFileRO = 4,
+    OpReadFile = 5,
+    OpBurstReadFile = 15,
+    OpAck = 128,
+    OpNak = 129
+};
+
+enum NakError : quint8 {
+    ErrFail = 1,
+    ErrFailErrno = 2,
+    ErrInvalidDataSize = 3,
+    ErrInvalidSession = 4,
+    ErrNoSessionsAvailable = 5,
+    ErrEof = 6,
+    ErrUnknownCommand = 7,
+    ErrFileExists = 8,
+    ErrFileProtected = 9,
+    ErrFileNotFound = 10
+};
+
+QString nakName(quint8 error)
+{
+    switch (error) {
+    case ErrFail: return "failed";
+    case ErrFailErrno: return "I/O error";
+    case ErrInvalidDataSize: return "invalid data size";
+    case ErrInvalidSession: return "invalid session";
+    case ErrNoSessionsAvailable: return "no sessions available";
+    case ErrEof: return "end of file";
+    case ErrUnknownCommand: return "unknown command";
+    case ErrFileExists: return "file exists";
+    case ErrFileProtected: return "file protected";
+    case ErrFileNotFound: return "file not found";
+    }
+    return QString("error %1").arg(error);
+}
+
+constexpr int MaxAttempts = 6;
+// Одновременных ReadFile при дочитывании потерянных пакетов
+constexpr int GapWindow = 8;
+
+constexpr int ServiceIntervalMs = 20;
+
+} // namespace
+
+FtpClient::FtpClient(QObject *parent)
+    : QObject(parent)
+    , m_state(State::Idle)
+    , m_targetSystem(1)
+    , m_targetComponent(1)
+    , m_seq(0)
+    , m_session(0)
+    , m_fileSize(0)
+    , m_sessionsReset(false)
+    , m_burstSupported(true)
+    , m_map(nullptr)
+    , m_duplicateBytes(0)
+    , m_controlSentNs(0)
+    , m_controlAttempts(0)
+    , m_lastBurstNs(0)
+    , m_retransmissions(0)
+    , m_startNs(0)
+    , m_lastActivityNs(0)
+    , m_progressDirty(false)
+    , m_serviceTask(0)
+{
+    m_clock.start();
+}
+
+FtpClient::~FtpClient()
+{
+    if (m_map) {
+        m_output.unmap(m_map);
+    }
+}
+
+bool FtpClient::busy() const
+{
+    return m_state == State::Opening || m_state == State::Bursting || m_state == State::FillingGaps;
+}
+
+FtpClient::State FtpClient::state() const
+{
+    return m_state;
+}
+
+QString FtpClient::stateName() const
+{
+    switch (m_state) {
+    case State::Idle: return "Idle";
+    case State::Opening: return "Opening";
+    case State::Bursting: return "Downloading";
+    case State::FillingGaps: return "Filling gaps";
+    case State::Completed: return "Completed";
+    case State::Failed: return "Failed";
+    }
+    return QString();
+}
+
+QString FtpClient::remotePath() const
+{
+    return m_remotePath;
+}
+
+double FtpClient::fileSize() const
+{
+    return double(m_fileSize);
+}
+
+double FtpClient::bytesReceived() const
+{
+    return double(m_received.coveredBytes());
+}
+
+double FtpClient::progress() const
+{
+    if (m_fileSize == 0) {
+        return m_state == State::Completed ? 1.0 : 0.0;
+    }
+    return double(m_received.coveredBytes()) / double(m_fileSize);
+}
+
+double FtpClient::bytesPerSecond() const
+{
+    const qint64 elapsedNs = (busy() ? m_clock.nsecsElapsed() : m_lastActivityNs) - m_startNs;
+    if (elapsedNs <= 0) {
+        return 0.0;
+    }
+    return double(m_received.coveredBytes()) * 1e9 / double(elapsedNs);
+}
+
+int FtpClient::retransmissions() const
+{
+    return m_retransmissions;
+}
+
+void FtpClient::setInitialRtt(double rttMs)
+{
+    m_rtt.setInitialRtt(rttMs);
+}
+
+bool FtpClient::download(quint8 targetSystem, quint8 targetComponent, const QString &remotePath, const QString &localPath)
+{
+    if (busy() || remotePath.isEmpty() || remotePath.toUtf8().size() > MaxDataLen) {
+        return false;
+    }
+
+    if (m_output.isOpen()) {
+        m_output.close();
+    }
+    m_output.setFileName(localPath);
+    if (!m_output.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qWarning() << "❌ Cannot create" << localPath << m_output.errorString();
+        return false;
+    }
+
+    m_targetSystem = targetSystem;
+    m_targetComponent = targetComponent;
+    m_remotePath = remotePath;
+    m_session = 0;
+    m_fileSize = 0;
+    m_sessionsReset = false;
+    m_burstSupported = true;
+    m_received.clear();
+    m_duplicateBytes = 0;
+    m_pending.clear();
+    m_retransmissions = 0;
+    m_rtt.reset();
+    m_controlAttempts = 0;
+    m_startNs = m_clock.nsecsElapsed();
+    m_lastActivityNs = m_startNs;
+
+    setState(State::Opening);
+    sendOpen();
+
+    Scheduler::instance()->cancel(m_serviceTask);
+    m_serviceTask = Scheduler::instance()->scheduleRepeating(ServiceIntervalMs, this, [this]() {
+        service();
+    });
+    return true;
+}
+
+void FtpClient::cancel()
+{
+    if (!busy()) {
+        return;
+    }
+    if (m_state != State::Opening) {
+        sendTerminate();
+    }
+    finish(false, "File download cancelled");
+}
+
+void FtpClient::setState(State state)
+{
+    if (m_state != state) {
+        m_state = state;
+        emit stateChanged();
+    }
+}
+
+void FtpClient::finish(bool success, const QString &message)
+{
+    Scheduler::instance()->cancel(m_serviceTask);
+    m_serviceTask = 0;
+    m_pending.clear();
+    m_lastActivityNs = m_clock.nsecsElapsed();
+
+    if (m_map) {
+        m_output.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_output.close();
+    // Недокачанный файл имеет полный размер - не оставляем его
+    if (!success) {
+        m_output.remove();
+    }
+
+    setState(success ? State::Completed : State::Failed);
+    emit progressChanged();
+    m_progressDirty = false;
+
+    qDebug() << (success ? "📥" : "❌") << message
+             << QString("(%1 KB/s, %2 retransmissions, %3 duplicate bytes)")
+                    .arg(bytesPerSecond() / 1024.0, 0, 'f', 1)
+                    .arg(m_retransmissions)
+                    .arg(m_duplicateBytes);
+    emit finished(success, message);
+}
+
+void FtpClient::service()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    const qint64 rto = m_rtt.rtoNs();
+
+    if (m_state == State::Opening) {
+        if (now - m_controlSentNs > rto) {
+            if (m_controlAttempts >= MaxAttempts) {
+                finish(false, QString("No response to opening %1").arg(m_remotePath));
+                return;
+            }
+            m_retransmissions++;
+            sendOpen();
+        }
+    } else if (m_state == State::Bursting) {
+        // Поток прервался (потеря последних пакетов или обрыв связи) - продолжаем с места обрыва
+        const qint64 timeout = qMin(RttEstimator::MaxRtoNs, rto << qMin(qMax(m_controlAttempts - 1, 0), 4));
+        if (now - m_lastBurstNs > timeout) {
+            m_retransmissions++;
+            continueTransfer();
+            return;
+        }
+    } else if (m_state == State::FillingGaps) {
+        QList<quint32> expired;
+        for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+            const qint64 timeout = qMin(RttEstimator::MaxRtoNs, rto << qMin(it.value().attempts - 1, 6));
+            if (now - it.value().sentNs > timeout) {
+                expired.append(it.key());
+            }
+        }
+        for (quint32 offset : expired) {
+            const Pending pending = m_pending.value(offset);
+            if (pending.attempts >= MaxAttempts) {
+                sendTerminate();
+                finish(false, QString("No data for offset %1 after %2 attempts").arg(offset).arg(MaxAttempts));
+                return;
+            }
+            m_retransmissions++;
+            sendRead(offset, pending.size);
+        }
+    }
+
+    if (m_progressDirty) {
+        m_progressDirty = false;
+        emit progressChanged();
+    }
+}
+
+void FtpClient::continueTransfer()
+{
+    if (m_received.coveredBytes() >= m_fileSize) {
+        sendTerminate();
+        finish(true, QString("Downloaded %1 (%2 bytes)").arg(m_remotePath).arg(m_fileSize));
+        return;
+    }
+
+    // Хвост файла - потоком, потерянные пакеты в середине - запросами ReadFile
+    const quint64 tail = m_received.upperBound();
+    if (m_burstSupported && tail < m_fileSize) {
+        if (m_controlAttempts >= MaxAttempts) {
+            sendTerminate();
+            finish(false, QString("Vehicle stopped sending %1 at offset %2").arg(m_remotePath).arg(tail));
+            return;
+        }
+        setState(State::Bursting);
+        sendBurst(quint32(tail));
+        return;
+    }
+
+    setState(State::FillingGaps);
+    fillGaps();
+}
+
+void FtpClient::fillGaps()
+{
+    if (m_received.coveredBytes() >= m_fileSize) {
+        sendTerminate();
+        finish(true, QString("Downloaded %1 (%2 bytes)").arg(m_remotePath).arg(m_fileSize));
+        return;
+    }
+
+    // Дыры режутся на пакеты; смещение пакета - ключ для сопоставления ответа
+    const QList<IntervalSet::Range> gaps = m_received.gaps(0, m_fileSize, GapWindow);
+    for (const IntervalSet::Range &gap : gaps) {
+        for (quint64 offset = gap.first; offset < gap.second && m_pending.size() < GapWindow; offset += MaxDataLen) {
+            if (!m_pending.contains(quint32(offset))) {
+                sendRead(quint32(offset), quint32(qMin<quint64>(MaxDataLen, gap.second - offset)));
+            }
+        }
+        if (m_pending.size() >= GapWindow) {
+            break;
+        }
+    }
+}
+
+void FtpClient::sendRequest(quint8 opcode, quint32 offset, const QByteArray &data, quint8 size)
+{
+    QByteArray payload;
+    payload.reserve(FtpOffset + FtpPayloadLen);
+    payload.append(char(0)); // target_network
+    payload.append(char(m_targetSystem));
+    payload.append(char(m_targetComponent));
+    Mavlink::appendField<quint16>(payload, ++m_seq);
+    payload.append(char(m_session));
+    payload.append(char(opcode));
+    payload.append(char(size));
+    payload.append(char(0)); // req_opcode
+    payload.append(char(0)); // burst_complete
+    payload.append(char(0)); // padding
+    Mavlink::appendField<quint32>(payload, offset);
+    payload.append(data.left(MaxDataLen));
+    payload.append(FtpOffset + FtpPayloadLen - payload.size(), '\0');
+    emit frameReady(Mavlink::packMessage(MsgFileTransferProtocol, payload));
+}
+
+void FtpClient::sendOpen()
+{
+    m_controlSentNs = m_clock.nsecsElapsed();
+    m_controlAttempts++;
+
+    const QByteArray path = m_remotePath.toUtf8();
+    sendRequest(OpOpenFileRO, 0, path, quint8(path.size()));
+}
+
+void FtpClient::sendResetSessions()
+{
+    m_controlSentNs = m_clock.nsecsElapsed();
+    sendRequest(OpResetSessions, 0, QByteArray(), 0);
+}
+
+void FtpClient::sendBurst(quint32 offset)
+{
+    m_controlAttempts++;
+    m_lastBurstNs = m_clock.nsecsElapsed();
+    sendRequest(OpBurstReadFile, offset, QByteArray(), quint8(MaxDataLen));
+}
+
+void FtpClient::sendRead(quint32 offset, quint32 size)
+{
+    Pending &pending = m_pending[offset];
+    pending.size = size;
+    pending.sentNs = m_clock.nsecsElapsed();
+    pending.attempts++;
+    sendRequest(OpReadFile, offset, QByteArray(), quint8(size));
+}
+
+void FtpClient::sendTerminate()
+{
+    // Ответ не нужен: сессия на борту закроется и по таймауту
+    sendRequest(OpTerminateSession, 0, QByteArray(), 0);
+}
+
+bool FtpClient::isFtpMessage(quint32 msgId)
+{
+    return msgId == MsgFileTransferProtocol;
+}
+
+void FtpClient::handleMessage(quint8 sysid, quint8 compid, quint32 msgId, const char *payload, int payloadLen)
+{
+    if (!busy() || msgId != MsgFileTransferProtocol
+        || sysid != m_targetSystem || compid != m_targetComponent) {
+        return;
+    }
+
+    // MAVLink 2.0 обрезает нули в конце payload - восстанавливаем полную длину
+    char buffer[FtpOffset + FtpPayloadLen] = {};
+    memcpy(buffer, payload, qMin(payloadLen, int(sizeof(buffer))));
+
+    const quint8 targetSystem = static_cast<quint8>(buffer[1]);
+    if (targetSystem != Mavlink::GcsSystemId && targetSystem != 0) {
+        return;
+    }
+
+    const char *ftp = buffer + FtpOffset;
+    const quint8 session = static_cast<quint8>(ftp[2]);
+    const quint8 opcode = static_cast<quint8>(ftp[3]);
+    const int size = qMin(int(static_cast<quint8>(ftp[4])), MaxDataLen);
+    const quint8 reqOpcode = static_cast<quint8>(ftp[5]);
+    const bool burstComplete = ftp[6] != 0;
+    const quint32 offset = Mavlink::readField<quint32>(ftp, FtpHeaderLen, 8);
+    const char *data = ftp + FtpHeaderLen;
+
+    // Ответы чужой (например, прошлой) сессии не учитываем
+    if (reqOpcode != OpOpenFileRO && reqOpcode != OpResetSessions && session != m_session) {
+        return;
+    }
+
+    m_lastActivityNs = m_clock.nsecsElapsed();
+    if (opcode == OpAck) {
+        handleAck(reqOpcode, session, offset, data, size, burstComplete);
+    } else if (opcode == OpNak) {
+        handleNak(reqOpcode, offset, size > 0 ? static_cast<quint8>(data[0]) : quint8(ErrFail));
+    }
+}
+
+void FtpClient::handleAck(quint8 reqOpcode, quint8 session, quint32 offset, const char *data, int size,
+                          bool burstComplete)
+{
+    switch (reqOpcode) {
+    case OpResetSessions:
+        if (m_state == State::Opening) {
+            sendOpen();
+        }
+        break;
+
+    case OpOpenFileRO: {
+        // Запоздавший ответ на повтор открытия не должен подменять сессию передачи
+        if (m_state != State::Opening) {
+            return;
+        }
+        m_session = session;
+        if (m_controlAttempts == 1) {
+            m_rtt.sample(m_clock.nsecsElapsed() - m_controlSentNs);
+        }
+        m_fileSize = Mavlink::readField<quint32>(data, size, 0);
+        m_controlAttempts = 0;
+        qDebug() << "📥 Opened" << m_remotePath << m_fileSize << "bytes, session" << m_session;
+
+        if (m_fileSize > 0) {
+            if (!m_output.resize(m_fileSize)) {
+                sendTerminate();
+                finish(false, QString("Cannot allocate %1: %2").arg(m_output.fileName(), m_output.errorString()));
+                return;
+            }
+            // Без отображения (например, 32-битная система) пишем через seek/write
+            m_map = m_output.map(0, m_fileSize);
+        }
+        emit progressChanged();
+        continueTransfer();
+        break;
+    }
+
+    case OpBurstReadFile:
+        if (m_state != State::Bursting) {
+            return;
+        }
+        m_lastBurstNs = m_clock.nsecsElapsed();
+        if (size > 0) {
+            const quint64 before = m_received.coveredBytes();
+            storeData(offset, data, size);
+            if (m_received.coveredBytes() > before) {
+                m_controlAttempts = 0;
+            }
+        }
+        if (burstComplete) {
+            continueTransfer();
+        }
+        break;
+
+    case OpReadFile: {
+        auto it = m_pending.find(offset);
+        if (it != m_pending.end()) {
+            if (it.value().attempts == 1) {
+                m_rtt.sample(m_clock.nsecsElapsed() - it.value().sentNs);
+            }
+            m_pending.erase(it);
+        }
+        storeData(offset, data, size);
+        if (m_state == State::FillingGaps) {
+            fillGaps();
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void FtpClient::handleNak(quint8 reqOpcode, quint32 offset, quint8 error)
+{
+    switch (reqOpcode) {
+    case OpOpenFileRO:
+        if (m_state != State::Opening) {
+            return;
+        }
+        // Сессии заняты (например, оборванной прошлой загрузкой) - сбрасываем один раз
+        if (error == ErrNoSessionsAvailable && !m_sessionsReset) {
+            m_sessionsReset = true;
+            sendResetSessions();
+            return;
+        }
+        finish(false, QString("Cannot open %1: %2").arg(m_remotePath, nakName(error)));
+        break;
+
+    case OpBurstReadFile:
+        if (m_state != State::Bursting) {
+            return;
+        }
+        if (error == ErrEof) {
+            continueTransfer();
+            return;
+        }
+        // Борт без BurstReadFile - весь файл читается окном ReadFile
+        qDebug() << "📥 BurstReadFile rejected:" << nakName(error) << "- falling back to ReadFile";
+        m_burstSupported = false;
+        continueTransfer();
+        break;
+
+    case OpReadFile:
+        if (!m_pending.contains(offset)) {
+            return;
+        }
+        sendTerminate();
+        finish(false, QString("Reading %1 at offset %2 failed: %3").arg(m_remotePath).arg(offset).arg(nakName(error)));
+        break;
+
+    default:
+        break;
+    }
+}
+
+void FtpClient::storeData(quint32 offset, const char *data, int size)
+{
+    if (offset >= m_fileSize) {
+        return;
+    }
+    size = int(qMin<quint64>(quint64(size), quint64(m_fileSize) - offset));
+
+    if (m_map) {
+        memcpy(m_map + offset, data, size_t(size));
+    } else {
+        m_output.seek(offset);
+        m_output.write(data, size);
+    }
+
+    const quint64 added = m_received.insert(offset, quint64(offset) + size);
+    m_duplicateBytes += quint64(size) - added;
+    m_progressDirty = true;
+}
@@ -0,0 +1,136 @@
+#ifndef FTPCLIENT_H
+#define FTPCLIENT_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QtQml/qqmlregistration.h>
+#include "intervalset.h"
+#include "rttestimator.h"
+#include "scheduler.h"
+
+// Скачивание файлов с борта по MAVLink FTP (FILE_TRANSFER_PROTOCOL).
+// Файл читается потоком BurstReadFile: борт шлет пакеты подряд без запросов
+// на каждый. Принятые участки учитываются в IntervalSet; потерянные пакеты
+// в середине файла дочитываются окном запросов ReadFile (как элементы миссии
+// в MissionTransfer), оборванный поток продолжается новым burst с места обрыва.
+// Данные пишутся прямо в отображенный в память выходной файл.
+class FtpClient : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Provided by MavlinkHandler.ftp")
+
+    Q_PROPERTY(bool busy READ busy NOTIFY stateChanged)
+    Q_PROPERTY(QString state READ stateName NOTIFY stateChanged)
+    Q_PROPERTY(QString remotePath READ remotePath NOTIFY stateChanged)
+    Q_PROPERTY(double fileSize READ fileSize NOTIFY progressChanged)
+    Q_PROPERTY(double bytesReceived READ bytesReceived NOTIFY progressChanged)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(double bytesPerSecond READ bytesPerSecond NOTIFY progressChanged)
+    Q_PROPERTY(int retransmissions READ retransmissions NOTIFY progressChanged)
+
+public:
+    enum class State {
+        Idle,
+        Opening,
+        Bursting,
+        FillingGaps,
+        Completed,
+        Failed
+    };
+
+    explicit FtpClient(QObject *parent = nullptr);
+    ~FtpClient();
+
+    bool busy() const;
+    State state() const;
+    QString stateName() const;
+    QString remotePath() const;
+    double fileSize() const;
+    double bytesReceived() const;
+    double progress() const;
+    double bytesPerSecond() const;
+    int retransmissions() const;
+
+    // Начальная оценка RTT (например, из TIMESYNC), пока нет своих замеров
+    void setInitialRtt(double rttMs);
+
+    bool download(quint8 targetSystem, quint8 targetComponent, const QString &remotePath, const QString &localPath);
+    Q_INVOKABLE void cancel();
+
+    static bool isFtpMessage(quint32 msgId);
+    void handleMessage(quint8 sysid, quint8 compid, quint32 msgId, const char *payload, int payloadLen);
+
+signals:
+    void frameReady(const QByteArray &frame);
+    void stateChanged();
+    void progressChanged();
+    void finished(bool success, const QString &message);
+
+private:
+    // Запрос ReadFile для участка в середине файла
+    struct Pending {
+        quint32 size = 0;
+        qint64 sentNs = 0;
+        int attempts = 0;
+    };
+
+    void setState(State state);
+    void finish(bool success, const QString &message);
+    void service();
+    void continueTransfer();
+    void fillGaps();
+
+    void sendOpen();
+    void sendResetSessions();
+    void sendBurst(quint32 offset);
+    void sendRead(quint32 offset, quint32 size);
+    void sendTerminate();
+    void sendRequest(quint8 opcode, quint32 offset, const QByteArray &data, quint8 size);
+
+    void handleAck(quint8 reqOpcode, quint8 session, quint32 offset, const char *data, int size, bool burstComplete);
+    void handleNak(quint8 reqOpcode, quint32 offset, quint8 error);
+    void storeData(quint32 offset, const char *data, int size);
+
+    State m_state;
+    quint8 m_targetSystem;
+    quint8 m_targetComponent;
+    QString m_remotePath;
+
+    // Сессия на борту
+    quint16 m_seq;
+    quint8 m_session;
+    quint32 m_fileSize;
+    bool m_sessionsReset;
+    bool m_burstSupported;
+
+    // Выходной файл, отображенный в память
+    QFile m_output;
+    uchar *m_map;
+
+    // Принятые участки файла
+    IntervalSet m_received;
+    quint64 m_duplicateBytes;
+
+    // Открытие файла и текущий поток BurstReadFile
+    qint64 m_controlSentNs;
+    int m_controlAttempts;
+    qint64 m_lastBurstNs;
+
+    // Окно ReadFile для дыр: смещение -> запрос
+    QHash<quint32, Pending> m_pending;
+    int m_retransmissions;
+
+    RttEstimator m_rtt;
+
+    qint64 m_startNs;
+    qint64 m_lastActivityNs;
+    bool m_progressDirty;
+
+    QElapsedTimer m_clock;
+    Scheduler::TaskId m_serviceTask;
+};
+
+#endif // FTPCLIENT_H
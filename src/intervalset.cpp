@@ -0,0 +1,89 @@
+#include "intervalset.h"
+#include <iterator>
+
+quint64 IntervalSet::insert(quint64 begin, quint64 end)
+{
+    if (begin >= end) {
+        return 0;
+    }
+
+    // Первый интервал, который может пересекаться с новым или касаться его
+    auto it = m_ranges.upper_bound(begin);
+    if (it != m_ranges.begin() && std::prev(it)->second >= begin) {
+        --it;
+    }
+
+    quint64 mergedBegin = begin;
+    quint64 mergedEnd = end;
+    quint64 removed = 0;
+    while (it != m_ranges.end() && it->first <= end) {
+        mergedBegin = qMin(mergedBegin, it->first);
+        mergedEnd = qMax(mergedEnd, it->second);
+        removed += it->second - it->first;
+        it = m_ranges.erase(it);
+    }
+    m_ranges.emplace(mergedBegin, mergedEnd);
+
+    const quint64 added = (mergedEnd - mergedBegin) - removed;
+    m_covered += added;
+    return added;
+}
+
+bool IntervalSet::contains(quint64 begin, quint64 end) const
+{
+    if (begin >= end) {
+        return true;
+    }
+    auto it = m_ranges.upper_bound(begin);
+    if (it == m_ranges.begin()) {
+        return false;
+    }
+    --it;
+    return it->first <= begin && it->second >= end;
+}
+
+quint64 IntervalSet::coveredBytes() const
+{
+    return m_covered;
+}
+
+quint64 IntervalSet::upperBound() const
+{
+    return m_ranges.empty() ? 0 : m_ranges.rbegin()->second;
+}
+
+int IntervalSet::rangeCount() const
+{
+    return int(m_ranges.size());
+}
+
+QList<IntervalSet::Range> IntervalSet::gaps(quint64 begin, quint64 end, int maxCount) const
+{
+    QList<Range> result;
+    quint64 position = begin;
+
+    auto it = m_ranges.upper_bound(begin);
+    if (it != m_ranges.begin() && std::prev(it)->second > begin) {
+        --it;
+    }
+
+    for (; it != m_ranges.end() && position < end; ++it) {
+        if (maxCount >= 0 && result.size() >= maxCount) {
+            return result;
+        }
+        if (it->first > position) {
+            result.append(qMakePair(position, qMin(it->first, end)));
+        }
+        position = qMax(position, it->second);
+    }
+    if (position < end && (maxCount < 0 || result.size() < maxCount)) {
+        result.append(qMakePair(position, end));
+    }
+    return result;
+}
+
+void IntervalSet::clear()
+{
+    m_ranges.clear();
+    m_covered = 0;
+}
@@ -0,0 +1,35 @@
+#ifndef INTERVALSET_H
+#define INTERVALSET_H
+
+#include <QtGlobal>
+#include <QList>
+#include <QPair>
+#include <map>
+
+// Множество непересекающихся полуинтервалов [begin, end).
+// Соседние и пересекающиеся интервалы сливаются, поэтому при приеме файла
+// кусками число записей равно числу "дыр" плюс один, а не числу пакетов.
+class IntervalSet
+{
+public:
+    typedef QPair<quint64, quint64> Range;
+
+    // Возвращает число байтов, которых еще не было в множестве
+    quint64 insert(quint64 begin, quint64 end);
+
+    bool contains(quint64 begin, quint64 end) const;
+    quint64 coveredBytes() const;
+    quint64 upperBound() const;     // конец последнего интервала, 0 если пусто
+    int rangeCount() const;
+
+    // Недостающие участки внутри [begin, end), не больше maxCount
+    QList<Range> gaps(quint64 begin, quint64 end, int maxCount = -1) const;
+
+    void clear();
+
+private:
+    std::map<quint64, quint64> m_ranges; // begin -> end
+    quint64 m_covered = 0;
+};
+
+#endif // INTERVALSET_H
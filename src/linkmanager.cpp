@@ -0,0 +1,445 @@
+#include "linkmanager.h"
+#include <QDebug>
+#include <QVariantMap>
+#include <cmath>
+
+namespace {
+
+constexpr double LossSmoothing = 0.02;
+constexpr double DelaySmoothing = 0.05;
+constexpr double IntervalSmoothing = 0.1;
+constexpr int LinksChangedEvery = 25; // обновление статистики в QML: 25 * 20 мс
+
+} // namespace
+
+LinkManager::LinkManager(QObject *parent)
+    : MavlinkSource(parent)
+    , m_active(-1)
+    , m_failovers(0)
+    , m_connected(false)
+    , m_serviceCount(0)
+    , m_serviceTask(0)
+    , m_crcFailuresMetric(Metrics::counter("mavlink_crc_failures_total", "Frames dropped because of a CRC mismatch"))
+    , m_duplicatesMetric(Metrics::counter("mavlink_link_duplicates_dropped_total", "Frames dropped as copies already received on another link"))
+    , m_failoversMetric(Metrics::counter("mavlink_link_failovers_total", "Switches of the outbound link"))
+{
+    m_clock.start();
+    m_out.reserve(4096);
+}
+
+LinkManager::~LinkManager()
+{
+    Scheduler::instance()->cancel(m_serviceTask);
+    // Каналы удаляются вместе с нами: их сигналы при закрытии уже не нужны
+    for (const LinkState &state : m_links) {
+        state.link->disconnect(this);
+    }
+}
+
+bool LinkManager::addLink(const QString &name, MavlinkLink *link)
+{
+    if (!link || name.isEmpty() || this->link(name)) {
+        return false;
+    }
+
+    link->setParent(this);
+
+    LinkState state;
+    state.name = name;
+    state.link = link;
+    state.buffer.reserve(4096);
+    state.framesMetric = Metrics::counter("mavlink_link_frames_received_total", "Valid frames received per link",
+                                          "link=\"" + name.toUtf8() + "\"");
+    state.duplicatesMetric = Metrics::counter("mavlink_link_duplicate_frames_total", "Frames that arrived after a copy from another link",
+                                              "link=\"" + name.toUtf8() + "\"");
+    m_links.append(state);
+
+    connect(link, &MavlinkSource::dataReceived, this, [this, link](const QByteArray &data) {
+        onLinkData(link, data);
+    });
+    connect(link, &MavlinkLink::connectedChanged, this, [this]() {
+        onLinkConnectedChanged();
+    });
+    connect(link, &MavlinkLink::statusChanged, this, [this]() {
+        emit statusChanged(status());
+    });
+
+    qDebug() << "🔗 Link added:" << name;
+    onLinkConnectedChanged();
+    emit linksChanged();
+    return true;
+}
+
+void LinkManager::removeLink(const QString &name)
+{
+    for (int i = 0; i < m_links.size(); i++) {
+        if (m_links[i].name != name) {
+            continue;
+        }
+        MavlinkLink *link = m_links[i].link;
+        link->disconnect(this);
+        link->disconnectFromFC();
+        link->deleteLater();
+        m_links.removeAt(i);
+
+        // Номера каналов сдвинулись: таблица повторов и выбор канала заново
+        m_dedup.clear();
+        m_active = -1;
+        qDebug() << "🔗 Link removed:" << name;
+        onLinkConnectedChanged();
+        selectActiveLink("link removed");
+        emit linksChanged();
+        emit statusChanged(status());
+        return;
+    }
+}
+
+MavlinkLink *LinkManager::link(const QString &name) const
+{
+    for (const LinkState &state : m_links) {
+        if (state.name == name) {
+            return state.link;
+        }
+    }
+    return nullptr;
+}
+
+QStringList LinkManager::linkNames() const
+{
+    QStringList names;
+    for (const LinkState &state : m_links) {
+        names.append(state.name);
+    }
+    return names;
+}
+
+bool LinkManager::connected() const
+{
+    return m_connected;
+}
+
+QString LinkManager::status() const
+{
+    if (m_links.isEmpty()) {
+        return "Disconnected";
+    }
+    if (m_links.size() == 1) {
+        return m_links.first().link->status();
+    }
+
+    // Несколько каналов: состояние активного, иначе первого подключенного
+    int index = m_active;
+    for (int i = 0; index < 0 && i < m_links.size(); i++) {
+        if (m_links[i].link->connected()) {
+            index = i;
+        }
+    }
+    if (index < 0) {
+        index = 0;
+    }
+    return QString("[%1] %2").arg(m_links[index].name, m_links[index].link->status());
+}
+
+QString LinkManager::activeLinkName() const
+{
+    return m_active >= 0 ? m_links[m_active].name : QString();
+}
+
+int LinkManager::failovers() const
+{
+    return m_failovers;
+}
+
+QVariantList LinkManager::links() const
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    QVariantList result;
+    for (int i = 0; i < m_links.size(); i++) {
+        const LinkState &state = m_links[i];
+        QVariantMap entry;
+        entry["name"] = state.name;
+        entry["status"] = state.link->status();
+        entry["connected"] = state.link->connected();
+        entry["active"] = (i == m_active);
+        entry["healthy"] = isHealthy(state, now);
+        entry["lossPercent"] = state.loss * 100.0;
+        entry["delayMs"] = state.delayMs;
+        entry["silentMs"] = state.lastRxNs > 0 ? double(now - state.lastRxNs) / 1e6 : -1.0;
+        entry["frames"] = double(state.frames);
+        entry["duplicates"] = double(state.duplicates);
+        entry["lost"] = double(state.lost);
+        result.append(entry);
+    }
+    return result;
+}
+
+void LinkManager::sendData(const QByteArray &data)
+{
+    if (m_active >= 0) {
+        m_links[m_active].link->sendData(data);
+        return;
+    }
+
+    // Здорового канала нет (старт или все молчат) - отправляем во все
+    for (const LinkState &state : m_links) {
+        if (state.link->connected()) {
+            state.link->sendData(data);
+        }
+    }
+}
+
+void LinkManager::disconnectAll()
+{
+    for (const LinkState &state : m_links) {
+        state.link->disconnectFromFC();
+    }
+}
+
+int LinkManager::indexOf(const MavlinkLink *link) const
+{
+    for (int i = 0; i < m_links.size(); i++) {
+        if (m_links[i].link == link) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool LinkManager::endsAtBoundary(const QByteArray &buffer, int end)
+{
+    if (end >= buffer.size()) {
+        return true;
+    }
+    const quint8 next = quint8(buffer[end]);
+    return next == Mavlink::StxV1 || next == Mavlink::StxV2;
+}
+
+void LinkManager::onLinkData(MavlinkLink *link, const QByteArray &data)
+{
+    const int index = indexOf(link);
+    if (index < 0) {
+        return;
+    }
+
+    const qint64 rxNs = m_clock.nsecsElapsed();
+    QByteArray &buffer = m_links[index].buffer;
+    buffer.append(data);
+
+    // Кадры собираются отдельно по каждому каналу: порции разных каналов
+    // перемешивать нельзя, последовательный порт режет кадры где угодно
+    m_out.resize(0);
+    Mavlink::FrameInfo frame;
+    int i = 0;
+    while (i < buffer.size()) {
+        const char *start = buffer.constData() + i;
+        const Mavlink::FrameStatus result = Mavlink::parseFrame(start, int(buffer.size()) - i, &frame);
+        if (result == Mavlink::FrameStatus::Incomplete) {
+            break; // Ждем остаток кадра
+        }
+        // Без CRC_EXTRA кадр не проверить: на шумном последовательном канале
+        // это может быть ложный стартовый байт со случайной длиной, и принять
+        // его - потерять настоящие кадры внутри. Такой кадр принимается, только
+        // если за ним сразу идет следующий кадр или конец порции; иначе ищем
+        // дальше, как при неверной CRC.
+        if (result != Mavlink::FrameStatus::Ok
+            || (frame.crc == Mavlink::CrcCheck::Unknown && !endsAtBoundary(buffer, i + frame.length))) {
+            if (result == Mavlink::FrameStatus::BadCrc) {
+                m_crcFailuresMetric->add();
+            }
+            i++;
+            continue;
+        }
+
+        if (acceptFrame(index, frame, start, rxNs)) {
+            m_out.append(start, frame.length);
+        }
+        i += frame.length;
+    }
+    buffer.remove(0, i);
+
+    if (m_active < 0) {
+        selectActiveLink("first data");
+    }
+    if (!m_out.isEmpty()) {
+        emit dataReceived(m_out);
+    }
+}
+
+bool LinkManager::acceptFrame(int index, const Mavlink::FrameInfo &frame, const char *start, qint64 rxNs)
+{
+    LinkState &state = m_links[index];
+    updateLinkStats(state, frame, rxNs);
+
+    // С одним каналом повторов не бывает
+    if (m_links.size() < 2) {
+        return true;
+    }
+
+    const quint16 checksum = Mavlink::readField<quint16>(start, frame.length, frame.headerLen + frame.payloadLen);
+    DedupSlot &slot = m_dedup[quint16(frame.sysid) << 8 | frame.compid].entries[frame.seq];
+
+    if (slot.link >= 0 && slot.link != index && slot.link < m_links.size()
+        && slot.msgId == frame.msgId && slot.checksum == checksum
+        && rxNs - slot.rxNs < qint64(DedupWindowMs) * 1000000) {
+        // Копия уже пришла по другому каналу: этот отстал на rxNs - slot.rxNs
+        const double lagMs = double(rxNs - slot.rxNs) / 1e6;
+        state.delayMs += DelaySmoothing * (lagMs - state.delayMs);
+        LinkState &first = m_links[slot.link];
+        first.delayMs -= DelaySmoothing * first.delayMs;
+
+        state.duplicates++;
+        state.duplicatesMetric->add();
+        m_duplicatesMetric->add();
+        return false;
+    }
+
+    slot.rxNs = rxNs;
+    slot.msgId = frame.msgId;
+    slot.checksum = checksum;
+    slot.link = qint8(index);
+    return true;
+}
+
+void LinkManager::updateLinkStats(LinkState &state, const Mavlink::FrameInfo &frame, qint64 rxNs)
+{
+    state.frames++;
+    state.framesMetric->add();
+
+    if (state.lastRxNs > 0) {
+        const double intervalMs = double(rxNs - state.lastRxNs) / 1e6;
+        state.intervalMs = (state.intervalMs <= 0.0)
+                               ? intervalMs
+                               : state.intervalMs + IntervalSmoothing * (intervalMs - state.intervalMs);
+    }
+    state.lastRxNs = rxNs;
+
+    // Потери на этом канале по номерам последовательности каждого компонента
+    const quint16 key = quint16(frame.sysid) << 8 | frame.compid;
+    int lost = 0;
+    auto last = state.lastSequence.find(key);
+    if (last != state.lastSequence.end()) {
+        lost = Mavlink::sequenceGap(last.value(), frame.seq);
+        if (lost < 0) {
+            return; // Повтор или опоздавший кадр - не потеря и не новый ожидаемый кадр
+        }
+        last.value() = frame.seq;
+    } else {
+        state.lastSequence.insert(key, frame.seq);
+    }
+
+    // EWMA по ожидаемым кадрам: lost единиц (потеряны), затем ноль (этот принят)
+    if (lost > 0) {
+        state.lost += quint64(lost);
+        state.loss = 1.0 - (1.0 - state.loss) * std::pow(1.0 - LossSmoothing, lost);
+    }
+    state.loss -= LossSmoothing * state.loss;
+}
+
+void LinkManager::onLinkConnectedChanged()
+{
+    int connectedLinks = 0;
+    for (LinkState &state : m_links) {
+        if (state.link->connected()) {
+            connectedLinks++;
+            continue;
+        }
+        // Отключенный канал начинает с чистой статистики
+        state.buffer.resize(0);
+        state.lastSequence.clear();
+        state.lastRxNs = 0;
+        state.loss = 0.0;
+        state.delayMs = 0.0;
+        state.intervalMs = 0.0;
+    }
+
+    selectActiveLink("link state changed");
+
+    // Выбирать есть из чего только при двух подключенных каналах; с одним
+    // периодическая проверка лишь будила бы поток 50 раз в секунду
+    const bool anyConnected = connectedLinks > 0;
+    const bool needService = connectedLinks >= 2;
+    if (needService && !m_serviceTask) {
+        m_serviceTask = Scheduler::instance()->scheduleRepeating(ServiceIntervalMs, this, [this]() {
+            service();
+        }, ServiceSlackMs);
+    } else if (!needService && m_serviceTask) {
+        Scheduler::instance()->cancel(m_serviceTask);
+        m_serviceTask = 0;
+    }
+
+    if (anyConnected != m_connected) {
+        m_connected = anyConnected;
+        if (!m_connected) {
+            m_dedup.clear();
+        }
+        emit connectedChanged(m_connected);
+    }
+    emit linksChanged();
+}
+
+void LinkManager::service()
+{
+    selectActiveLink("link health");
+    if (++m_serviceCount % LinksChangedEvery == 0) {
+        emit linksChanged();
+    }
+}
+
+bool LinkManager::isHealthy(const LinkState &state, qint64 nowNs) const
+{
+    if (!state.link->connected() || state.lastRxNs == 0) {
+        return false;
+    }
+    // Молчание дольше нескольких обычных интервалов между кадрами
+    const double silenceMs = qBound(double(MinSilenceMs), SilenceIntervals * state.intervalMs, double(MaxSilenceMs));
+    return double(nowNs - state.lastRxNs) / 1e6 <= silenceMs;
+}
+
+double LinkManager::cost(const LinkState &state) const
+{
+    // 1% потерь весит как 10 мс отставания
+    return state.loss * 100.0 + state.delayMs * 0.1;
+}
+
+void LinkManager::selectActiveLink(const char *reason)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+
+    int best = -1;
+    double bestCost = 0.0;
+    for (int i = 0; i < m_links.size(); i++) {
+        if (!isHealthy(m_links[i], now)) {
+            continue;
+        }
+        const double c = cost(m_links[i]);
+        if (best < 0 || c < bestCost) {
+            best = i;
+            bestCost = c;
+        }
+    }
+
+    // Здоровый активный канал меняем только на заметно лучший
+    int next = best;
+    if (m_active >= 0 && m_active < m_links.size() && best >= 0 && isHealthy(m_links[m_active], now)
+        && cost(m_links[m_active]) <= bestCost + SwitchMargin) {
+        next = m_active;
+    }
+    if (next == m_active) {
+        return;
+    }
+
+    const int previous = m_active;
+    m_active = next;
+    if (previous >= 0 && next >= 0) {
+        m_failovers++;
+        m_failoversMetric->add();
+    }
+
+    if (next >= 0) {
+        qDebug() << "🔀 Active link:" << m_links[next].name << "-" << reason;
+    } else {
+        qDebug() << "🔀 No healthy link, sending on all links -" << reason;
+    }
+    emit activeLinkChanged();
+    emit statusChanged(status());
+}
@@ -0,0 +1,131 @@
+#ifndef LINKMANAGER_H
+#define LINKMANAGER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QVariantList>
+#include <QtQml/qqmlregistration.h>
+#include "mavlinklink.h"
+#include "mavlinkprotocol.h"
+#include "metrics.h"
+#include "scheduler.h"
+
+// Несколько одновременных каналов к одному борту (основной и резервный радиомодем,
+// UDP + последовательный порт). Каждый канал разбирается на кадры отдельно,
+// повторы одного кадра с разных каналов отбрасываются по (sysid, compid, seq,
+// msgid, CRC) - дальше идет единый поток, в котором выигрывает первая копия.
+// Поэтому потеря одного канала на приеме не теряет ни одного кадра, пока жив
+// другой. Исходящие кадры идут через самый здоровый канал (потери и отставание
+// от самого быстрого), замолчавший канал заменяется за десятки миллисекунд.
+//
+// Дубликаты определяются только для кадров, которые борт (или маршрутизатор)
+// отдает в оба канала одинаковыми. Если у каналов свои счетчики seq,
+// повторов не будет и оба потока просто сольются.
+//
+// Кадры сообщений без известного CRC_EXTRA (см. Mavlink::crcExtra) проверить
+// нельзя: они принимаются, только если кончаются ровно перед следующим
+// стартовым байтом или в конце порции данных.
+class LinkManager : public MavlinkSource
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Provided by MavlinkHandler.links")
+
+    Q_PROPERTY(bool connected READ connected NOTIFY connectedChanged)
+    Q_PROPERTY(QString activeLink READ activeLinkName NOTIFY activeLinkChanged)
+    Q_PROPERTY(int failovers READ failovers NOTIFY activeLinkChanged)
+    Q_PROPERTY(QVariantList links READ links NOTIFY linksChanged)
+
+public:
+    static constexpr int DedupWindowMs = 500;     // меньше оборота seq даже на 500 Гц
+    static constexpr int ServiceIntervalMs = 20;  // только при двух и более каналах
+    static constexpr int ServiceSlackMs = 10;     // много меньше MinSilenceMs
+    static constexpr int MinSilenceMs = 50;       // канал молчит - не меньше этого
+    static constexpr int SilenceIntervals = 5;    // ... и не меньше 5 обычных интервалов
+    static constexpr int MaxSilenceMs = 1000;
+    static constexpr double SwitchMargin = 3.0;   // гистерезис стоимости канала
+
+    explicit LinkManager(QObject *parent = nullptr);
+    ~LinkManager();
+
+    // Канал переходит во владение LinkManager; имя должно быть уникальным
+    bool addLink(const QString &name, MavlinkLink *link);
+    void removeLink(const QString &name);
+    MavlinkLink *link(const QString &name) const;
+    QStringList linkNames() const;
+
+    bool connected() const;
+    QString status() const;
+    QString activeLinkName() const;
+    int failovers() const;
+    QVariantList links() const;
+
+public slots:
+    void sendData(const QByteArray &data);
+    void disconnectAll();
+
+signals:
+    void connectedChanged(bool connected);
+    void statusChanged(const QString &status);
+    void activeLinkChanged();
+    void linksChanged();
+
+private:
+    struct LinkState {
+        QString name;
+        MavlinkLink *link = nullptr;
+        QByteArray buffer;                  // начало неполного кадра
+        QHash<quint16, quint8> lastSequence; // (sysid << 8 | compid) -> seq
+        double loss = 0.0;                  // доля потерянных кадров (EWMA)
+        double delayMs = 0.0;               // отставание от первой копии (EWMA)
+        double intervalMs = 0.0;            // интервал между кадрами (EWMA)
+        qint64 lastRxNs = 0;
+        quint64 frames = 0;
+        quint64 duplicates = 0;
+        quint64 lost = 0;
+        Metrics::Counter *framesMetric = nullptr;
+        Metrics::Counter *duplicatesMetric = nullptr;
+    };
+
+    // Последний кадр с данным seq от компонента
+    struct DedupSlot {
+        qint64 rxNs = 0;
+        quint32 msgId = 0;
+        quint16 checksum = 0;
+        qint8 link = -1;
+    };
+    struct DedupTable {
+        DedupSlot entries[256];
+    };
+
+    int indexOf(const MavlinkLink *link) const;
+    static bool endsAtBoundary(const QByteArray &buffer, int end);
+    void onLinkData(MavlinkLink *link, const QByteArray &data);
+    bool acceptFrame(int index, const Mavlink::FrameInfo &frame, const char *start, qint64 rxNs);
+    void updateLinkStats(LinkState &state, const Mavlink::FrameInfo &frame, qint64 rxNs);
+    void onLinkConnectedChanged();
+    void service();
+
+    bool isHealthy(const LinkState &state, qint64 nowNs) const;
+    double cost(const LinkState &state) const;
+    void selectActiveLink(const char *reason);
+
+    QList<LinkState> m_links;
+    QHash<quint16, DedupTable> m_dedup;   // (sysid << 8 | compid) -> таблица по seq
+    QByteArray m_out;                     // принятые кадры одной порции
+    int m_active;                         // -1: нет здорового канала, отправка во все
+    int m_failovers;
+    bool m_connected;
+    int m_serviceCount;
+
+    QElapsedTimer m_clock;
+    Scheduler::TaskId m_serviceTask;
+
+    Metrics::Counter *m_crcFailuresMetric;
+    Metrics::Counter *m_duplicatesMetric;
+    Metrics::Counter *m_failoversMetric;
+};
+
+#endif // LINKMANAGER_H
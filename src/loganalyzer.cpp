@@ -0,0 +1,519 @@
+#include "loganalyzer.h"
+#include "flightarchive.h"
+#include "workstealingpool.h"
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr int TlogTimestampLen = 8;
+// Самая длинная запись .tlog: время + кадр MAVLink 2.0 с подписью
+constexpr int MaxTlogRecord = TlogTimestampLen + Mavlink::HeaderLenV2 + 255 + Mavlink::ChecksumLen + Mavlink::SignatureLen;
+
+constexpr double RadToDeg = 180.0 / M_PI;
+
+} // namespace
+
+struct LogAnalyzer::FileJob {
+    QString path;
+    QString format;
+    QString error;
+    std::vector<Segment> segments;
+};
+
+LogAnalyzer::LogAnalyzer(const Options &options)
+    : m_options(options)
+    , m_pool(nullptr)
+    , m_stolen(0)
+{
+}
+
+QStringList LogAnalyzer::findLogs(const QString &path)
+{
+    if (QFileInfo(path).isFile()) {
+        return QStringList() << path;
+    }
+
+    QStringList files;
+    QDirIterator it(path, QStringList() << "*.tlog" << "*.mavarc", QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        files.append(it.next());
+    }
+    files.sort();
+    return files;
+}
+
+quint64 LogAnalyzer::stolenTasks() const
+{
+    return m_stolen;
+}
+
+QList<LogAnalyzer::FlightSummary> LogAnalyzer::analyze(const QStringList &files)
+{
+    std::vector<std::unique_ptr<FileJob>> jobs;
+    jobs.reserve(files.size());
+
+    {
+        WorkStealingPool pool(m_options.threads);
+        m_pool = &pool;
+
+        // Задача файла делит его на участки и ставит их в очередь своего потока,
+        // свободные потоки забирают участки себе
+        for (const QString &path : files) {
+            jobs.push_back(std::make_unique<FileJob>());
+            FileJob *job = jobs.back().get();
+            job->path = path;
+            pool.submit([this, job]() {
+                planFile(job);
+            });
+        }
+        pool.wait();
+
+        m_stolen = pool.stolenTasks();
+        m_pool = nullptr;
+    }
+
+    QList<FlightSummary> summaries;
+    for (const auto &job : jobs) {
+        summaries.append(summarize(*job));
+    }
+    return summaries;
+}
+
+void LogAnalyzer::planFile(FileJob *job)
+{
+    if (FlightArchive::isArchiveFile(job->path)) {
+        job->format = "mavarc";
+
+        FlightArchive::Reader reader;
+        if (!reader.open(job->path)) {
+            job->error = "cannot read archive index";
+            return;
+        }
+
+        // Соседние блоки архива объединяются в участки примерно segmentBytes
+        QList<QPair<int, int>> ranges;
+        const QList<FlightArchive::ChunkInfo> &chunks = reader.chunks();
+        int first = 0;
+        qint64 rawBytes = 0;
+        for (int i = 0; i < chunks.size(); ++i) {
+            rawBytes += chunks.at(i).rawSize;
+            if (rawBytes >= m_options.segmentBytes || i == chunks.size() - 1) {
+                ranges.append(qMakePair(first, i));
+                first = i + 1;
+                rawBytes = 0;
+            }
+        }
+
+        job->segments.resize(ranges.size());
+        for (int i = 0; i < ranges.size(); ++i) {
+            const QPair<int, int> range = ranges.at(i);
+            m_pool->submit([this, job, i, range]() {
+                readArchiveSegment(job, i, range.first, range.second);
+            });
+        }
+        return;
+    }
+
+    job->format = "tlog";
+    const qint64 size = QFileInfo(job->path).size();
+    if (size <= 0) {
+        job->error = "empty or unreadable file";
+        return;
+    }
+
+    const int count = int((size + m_options.segmentBytes - 1) / m_options.segmentBytes);
+    job->segments.resize(count);
+    for (int i = 0; i < count; ++i) {
+        const qint64 begin = qint64(i) * m_options.segmentBytes;
+        const qint64 end = qMin(size, begin + m_options.segmentBytes);
+        m_pool->submit([this, job, i, begin, end]() {
+            readTlogSegment(job, i, begin, end);
+        });
+    }
+}
+
+void LogAnalyzer::readTlogSegment(FileJob *job, int index, qint64 begin, qint64 end)
+{
+    Segment &segment = job->segments[index];
+
+    QFile file(job->path);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(begin)) {
+        segment.error = file.errorString();
+        return;
+    }
+
+    // Участку принадлежат записи, начинающиеся в [begin, end).
+    // Последняя может выходить за end, поэтому читаем с запасом.
+    const QByteArray data = file.read(end - begin + MaxTlogRecord);
+    const int limit = int(end - begin);
+
+    // Участок начинается в произвольном месте записи - ищем границу
+    int pos = begin == 0 ? 0 : tlogResync(data, 0, limit);
+    Mavlink::FrameInfo frame;
+    while (pos < limit && pos + TlogTimestampLen < data.size()) {
+        const char *start = data.constData() + pos + TlogTimestampLen;
+        const Mavlink::FrameStatus status = Mavlink::parseFrame(start, data.size() - pos - TlogTimestampLen, &frame);
+        if (status == Mavlink::FrameStatus::Ok) {
+            const qint64 timestampUs = qint64(qFromBigEndian<quint64>(data.constData() + pos));
+            addFrame(segment, timestampUs, start, frame);
+            pos += TlogTimestampLen + frame.length;
+            continue;
+        }
+        if (status == Mavlink::FrameStatus::Incomplete) {
+            break; // обрезанная запись в конце файла
+        }
+        if (status == Mavlink::FrameStatus::BadCrc) {
+            segment.crcErrors++;
+        }
+        pos = tlogResync(data, pos + 1, limit);
+    }
+}
+
+int LogAnalyzer::tlogResync(const QByteArray &data, int from, int limit)
+{
+    // Граница записи: кадр с верной CRC, за которым следует еще один
+    // такой же кадр (или конец данных)
+    Mavlink::FrameInfo frame;
+    for (int pos = from; pos < limit && pos + TlogTimestampLen < data.size(); ++pos) {
+        const quint8 stx = static_cast<quint8>(data[pos + TlogTimestampLen]);
+        if (stx != Mavlink::StxV1 && stx != Mavlink::StxV2) {
+            continue;
+        }
+        const int available = data.size() - pos - TlogTimestampLen;
+        if (Mavlink::parseFrame(data.constData() + pos + TlogTimestampLen, available, &frame) != Mavlink::FrameStatus::Ok) {
+            continue;
+        }
+
+        const int next = pos + TlogTimestampLen + frame.length + TlogTimestampLen;
+        if (next < data.size()) {
+            const Mavlink::FrameStatus status = Mavlink::parseFrame(data.constData() + next, data.size() - next, &frame);
+            if (status != Mavlink::FrameStatus::Ok && status != Mavlink::FrameStatus::Incomplete) {
+                continue;
+            }
+        }
+        return pos;
+    }
+    return limit;
+}
+
+void LogAnalyzer::readArchiveSegment(FileJob *job, int index, int firstChunk, int lastChunk)
+{
+    Segment &segment = job->segments[index];
+
+    // Свой Reader в каждом потоке: QFile не разделяется между потоками
+    FlightArchive::Reader reader;
+    if (!reader.open(job->path)) {
+        segment.error = "cannot open archive";
+        return;
+    }
+
+    QByteArray raw;
+    FlightArchive::Record record;
+    Mavlink::FrameInfo frame;
+    for (int chunk = firstChunk; chunk <= lastChunk; ++chunk) {
+        if (!reader.loadChunk(chunk, &raw)) {
+            segment.error = QString("chunk %1 is corrupted").arg(chunk);
+            continue;
+        }
+        const qint64 chunkFirstUs = reader.chunks().at(chunk).firstUs;
+        int pos = 0;
+        while (FlightArchive::Reader::parseRecord(raw, &pos, chunkFirstUs, &record)) {
+            if (Mavlink::parseFrame(record.frame.constData(), record.frame.size(), &frame) == Mavlink::FrameStatus::Ok) {
+                addFrame(segment, record.timestampUs, record.frame.constData(), frame);
+            }
+        }
+    }
+}
+
+void LogAnalyzer::addFrame(Segment &segment, qint64 timestampUs, const char *frame, const Mavlink::FrameInfo &info) const
+{
+    if (segment.firstUs < 0) {
+        segment.firstUs = timestampUs;
+    }
+    segment.lastUs = qMax(segment.lastUs, timestampUs);
+    segment.frames++;
+    segment.bytes += info.length;
+    segment.messages[info.msgId]++;
+
+    // Потери по номерам последовательности каждого компонента
+    const quint16 key = quint16(info.sysid) << 8 | info.compid;
+    auto sequence = segment.sequences.find(key);
+    if (sequence == segment.sequences.end()) {
+        SequenceState state;
+        state.first = info.seq;
+        state.last = info.seq;
+        state.received = 1;
+        segment.sequences.insert(key, state);
+    } else {
+        // Повтор или переупорядочивание - не потеря
+        const int lost = Mavlink::sequenceGap(sequence.value().last, info.seq);
+        if (lost >= 0) {
+            sequence.value().lost += lost;
+            sequence.value().last = info.seq;
+        }
+        sequence.value().received++;
+    }
+
+    // Разрывы связи - по кадрам борта, исходящие кадры станции в .tlog не считаются
+    if (info.sysid != Mavlink::GcsSystemId) {
+        if (segment.linkLastUs >= 0 && timestampUs - segment.linkLastUs > m_options.outageUs) {
+            segment.outages.append(qMakePair(segment.linkLastUs, timestampUs));
+        }
+        if (segment.linkFirstUs < 0) {
+            segment.linkFirstUs = timestampUs;
+        }
+        segment.linkLastUs = timestampUs;
+    }
+
+    if (info.msgId == Mavlink::MsgAttitude) {
+        const char *payload = frame + info.headerLen;
+        const float roll = Mavlink::readField<float>(payload, info.payloadLen, 4);
+        const float pitch = Mavlink::readField<float>(payload, info.payloadLen, 8);
+        const float rate = std::max({ std::fabs(Mavlink::readField<float>(payload, info.payloadLen, 16)),
+                                      std::fabs(Mavlink::readField<float>(payload, info.payloadLen, 20)),
+                                      std::fabs(Mavlink::readField<float>(payload, info.payloadLen, 24)) });
+        if (segment.attitudeFrames == 0) {
+            segment.rollMin = segment.rollMax = roll;
+            segment.pitchMin = segment.pitchMax = pitch;
+        }
+        segment.rollMin = qMin(segment.rollMin, roll);
+        segment.rollMax = qMax(segment.rollMax, roll);
+        segment.pitchMin = qMin(segment.pitchMin, pitch);
+        segment.pitchMax = qMax(segment.pitchMax, pitch);
+        segment.maxRate = qMax(segment.maxRate, rate);
+        segment.attitudeFrames++;
+        segment.attitudePerSecond[timestampUs / 1000000]++;
+    }
+}
+
+void LogAnalyzer::mergeSegment(Segment &into, const Segment &next) const
+{
+    if (!next.error.isEmpty() && into.error.isEmpty()) {
+        into.error = next.error;
+    }
+    if (next.frames == 0) {
+        return;
+    }
+
+    if (into.firstUs < 0) {
+        into.firstUs = next.firstUs;
+    }
+    into.lastUs = qMax(into.lastUs, next.lastUs);
+    into.frames += next.frames;
+    into.bytes += next.bytes;
+    into.crcErrors += next.crcErrors;
+    for (auto it = next.messages.constBegin(); it != next.messages.constEnd(); ++it) {
+        into.messages[it.key()] += it.value();
+    }
+
+    // Номера последовательности сшиваются на границе участков
+    for (auto it = next.sequences.constBegin(); it != next.sequences.constEnd(); ++it) {
+        auto sequence = into.sequences.find(it.key());
+        if (sequence == into.sequences.end()) {
+            into.sequences.insert(it.key(), it.value());
+            continue;
+        }
+        sequence.value().lost += qMax(Mavlink::sequenceGap(sequence.value().last, it.value().first), 0)
+                                 + it.value().lost;
+        sequence.value().last = it.value().last;
+        sequence.value().received += it.value().received;
+    }
+
+    // Разрыв мог прийтись на границу участков
+    if (into.linkLastUs >= 0 && next.linkFirstUs >= 0 && next.linkFirstUs - into.linkLastUs > m_options.outageUs) {
+        into.outages.append(qMakePair(into.linkLastUs, next.linkFirstUs));
+    }
+    into.outages.append(next.outages);
+    if (into.linkFirstUs < 0) {
+        into.linkFirstUs = next.linkFirstUs;
+    }
+    if (next.linkLastUs >= 0) {
+        into.linkLastUs = next.linkLastUs;
+    }
+
+    if (next.attitudeFrames > 0) {
+        if (into.attitudeFrames == 0) {
+            into.rollMin = next.rollMin;
+            into.rollMax = next.rollMax;
+            into.pitchMin = next.pitchMin;
+            into.pitchMax = next.pitchMax;
+        }
+        into.rollMin = qMin(into.rollMin, next.rollMin);
+        into.rollMax = qMax(into.rollMax, next.rollMax);
+        into.pitchMin = qMin(into.pitchMin, next.pitchMin);
+        into.pitchMax = qMax(into.pitchMax, next.pitchMax);
+        into.maxRate = qMax(into.maxRate, next.maxRate);
+        into.attitudeFrames += next.attitudeFrames;
+        for (auto it = next.attitudePerSecond.constBegin(); it != next.attitudePerSecond.constEnd(); ++it) {
+            into.attitudePerSecond[it.key()] += it.value();
+        }
+    }
+}
+
+LogAnalyzer::FlightSummary LogAnalyzer::summarize(const FileJob &job) const
+{
+    FlightSummary summary;
+    summary.path = job.path;
+    summary.format = job.format;
+    summary.error = job.error;
+    summary.segments = int(job.segments.size());
+
+    Segment total;
+    for (const Segment &segment : job.segments) {
+        mergeSegment(total, segment);
+    }
+    if (summary.error.isEmpty()) {
+        summary.error = total.error;
+    }
+    if (total.frames == 0) {
+        if (summary.error.isEmpty()) {
+            summary.error = "no MAVLink frames";
+        }
+        return summary;
+    }
+
+    summary.startUs = total.firstUs;
+    summary.endUs = total.lastUs;
+    summary.durationSec = (total.lastUs - total.firstUs) / 1e6;
+    summary.frames = total.frames;
+    summary.bytes = total.bytes;
+    summary.crcErrors = total.crcErrors;
+    for (auto it = total.messages.constBegin(); it != total.messages.constEnd(); ++it) {
+        summary.messages.insert(it.key(), it.value());
+    }
+
+    quint64 received = 0;
+    for (const SequenceState &sequence : total.sequences) {
+        received += sequence.received;
+        summary.lostMessages += sequence.lost;
+    }
+    summary.lossPercent = 100.0 * summary.lostMessages / (received + summary.lostMessages);
+
+    summary.outages = total.outages.size();
+    for (const QPair<qint64, qint64> &outage : total.outages) {
+        const double seconds = (outage.second - outage.first) / 1e6;
+        summary.outageSec += seconds;
+        summary.longestOutageSec = qMax(summary.longestOutageSec, seconds);
+    }
+
+    summary.attitudeFrames = total.attitudeFrames;
+    if (total.attitudeFrames > 0) {
+        summary.attitudeHz = summary.durationSec > 0.0 ? total.attitudeFrames / summary.durationSec : 0.0;
+        summary.rollMin = total.rollMin * RadToDeg;
+        summary.rollMax = total.rollMax * RadToDeg;
+        summary.pitchMin = total.pitchMin * RadToDeg;
+        summary.pitchMax = total.pitchMax * RadToDeg;
+        summary.maxRateDps = total.maxRate * RadToDeg;
+
+        // Первая и последняя секунды неполные и не учитываются.
+        // Секунды без ATTITUDE (в том числе при разрыве связи) - ниже порога.
+        const qint64 first = total.attitudePerSecond.firstKey() + 1;
+        const qint64 last = total.attitudePerSecond.lastKey() - 1;
+        if (last >= first) {
+            qint64 good = 0;
+            for (auto it = total.attitudePerSecond.lowerBound(first);
+                 it != total.attitudePerSecond.constEnd() && it.key() <= last; ++it) {
+                if (it.value() >= m_options.minAttitudeHz) {
+                    good++;
+                }
+            }
+            summary.attitudeLowSec = double(last - first + 1 - good);
+        }
+    }
+    return summary;
+}
+
+QString LogAnalyzer::formatSummary(const FlightSummary &summary, int minAttitudeHz)
+{
+    QString text = QString("%1  [%2, %3 segments]\n").arg(summary.path, summary.format).arg(summary.segments);
+    if (summary.frames == 0) {
+        return text + QString("  error: %1\n").arg(summary.error);
+    }
+    if (!summary.error.isEmpty()) {
+        text += QString("  warning: %1\n").arg(summary.error);
+    }
+
+    text += QString("  duration %1 s, %2 frames, %3 MB\n")
+                .arg(summary.durationSec, 0, 'f', 1)
+                .arg(summary.frames)
+                .arg(summary.bytes / 1e6, 0, 'f', 1);
+    text += QString("  loss %1% (%2 messages), CRC errors %3\n")
+                .arg(summary.lossPercent, 0, 'f', 2)
+                .arg(summary.lostMessages)
+                .arg(summary.crcErrors);
+    text += QString("  link outages: %1, total %2 s, longest %3 s\n")
+                .arg(summary.outages)
+                .arg(summary.outageSec, 0, 'f', 1)
+                .arg(summary.longestOutageSec, 0, 'f', 1);
+
+    if (summary.attitudeFrames > 0) {
+        text += QString("  ATTITUDE: %1 Hz, below %2 Hz for %3 s, roll %4..%5 deg, pitch %6..%7 deg, max rate %8 deg/s\n")
+                    .arg(summary.attitudeHz, 0, 'f', 1)
+                    .arg(minAttitudeHz)
+                    .arg(summary.attitudeLowSec, 0, 'f', 0)
+                    .arg(summary.rollMin, 0, 'f', 1)
+                    .arg(summary.rollMax, 0, 'f', 1)
+                    .arg(summary.pitchMin, 0, 'f', 1)
+                    .arg(summary.pitchMax, 0, 'f', 1)
+                    .arg(summary.maxRateDps, 0, 'f', 0);
+    } else {
+        text += "  ATTITUDE: none\n";
+    }
+
+    QStringList rates;
+    for (auto it = summary.messages.constBegin(); it != summary.messages.constEnd(); ++it) {
+        const double hz = summary.durationSec > 0.0 ? it.value() / summary.durationSec : 0.0;
+        rates << QString("%1:%2").arg(it.key()).arg(hz, 0, 'f', hz < 10.0 ? 2 : 1);
+    }
+    text += QString("  rates (msgid:Hz): %1\n").arg(rates.join(' '));
+    return text;
+}
+
+QByteArray LogAnalyzer::csvHeader()
+{
+    return "file,format,duration_s,frames,bytes,lost_messages,loss_percent,crc_errors,"
+           "outages,outage_s,longest_outage_s,attitude_hz,attitude_low_s,"
+           "roll_min,roll_max,pitch_min,pitch_max,max_rate_dps,rates,error\n";
+}
+
+QByteArray LogAnalyzer::csvRow(const FlightSummary &summary)
+{
+    auto quoted = [](QString value) {
+        return "\"" + value.replace('"', "\"\"") + "\"";
+    };
+
+    QStringList rates;
+    for (auto it = summary.messages.constBegin(); it != summary.messages.constEnd(); ++it) {
+        const double hz = summary.durationSec > 0.0 ? it.value() / summary.durationSec : 0.0;
+        rates << QString("%1:%2").arg(it.key()).arg(hz, 0, 'f', 2);
+    }
+
+    QStringList fields;
+    fields << quoted(summary.path)
+           << summary.format
+           << QString::number(summary.durationSec, 'f', 1)
+           << QString::number(summary.frames)
+           << QString::number(summary.bytes)
+           << QString::number(summary.lostMessages)
+           << QString::number(summary.lossPercent, 'f', 3)
+           << QString::number(summary.crcErrors)
+           << QString::number(summary.outages)
+           << QString::number(summary.outageSec, 'f', 2)
+           << QString::number(summary.longestOutageSec, 'f', 2)
+           << QString::number(summary.attitudeHz, 'f', 2)
+           << QString::number(summary.attitudeLowSec, 'f', 0)
+           << QString::number(summary.rollMin, 'f', 1)
+           << QString::number(summary.rollMax, 'f', 1)
+           << QString::number(summary.pitchMin, 'f', 1)
+           << QString::number(summary.pitchMax, 'f', 1)
+           << QString::number(summary.maxRateDps, 'f', 0)
+           << quoted(rates.join(' '))
+           << quoted(summary.error);
+    return fields.join(',').toUtf8() + "\n";
+}
@@ -0,0 +1,120 @@
+#ifndef LOGANALYZER_H
+#define LOGANALYZER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include "mavlinkprotocol.h"
+
+class WorkStealingPool;
+
+// Пакетный анализ логов полетов: .tlog (8 байт времени big endian + кадр)
+// и архивы FlightArchive (.mavarc). Файлы делятся на участки, которые
+// разбираются параллельно тем же Mavlink::parseFrame, что и в MavlinkHandler.
+// Результаты участков сливаются по порядку в сводку полета.
+class LogAnalyzer
+{
+public:
+    struct Options {
+        qint64 outageUs = 1000000;      // пауза в кадрах борта, считающаяся разрывом связи
+        int minAttitudeHz = 25;
+        int segmentBytes = 8 * 1024 * 1024;
+        int threads = 0;                // 0 - по числу ядер
+    };
+
+    struct FlightSummary {
+        QString path;
+        QString format;
+        QString error;
+        int segments = 0;
+
+        qint64 startUs = 0;
+        qint64 endUs = 0;
+        double durationSec = 0.0;
+
+        quint64 frames = 0;
+        quint64 bytes = 0;
+        quint64 crcErrors = 0;
+        quint64 lostMessages = 0;
+        double lossPercent = 0.0;
+        QMap<quint32, quint64> messages;    // msgid -> количество
+
+        int outages = 0;
+        double outageSec = 0.0;
+        double longestOutageSec = 0.0;
+
+        quint64 attitudeFrames = 0;
+        double attitudeHz = 0.0;
+        double attitudeLowSec = 0.0;        // секунды с ATTITUDE ниже minAttitudeHz
+        double rollMin = 0.0;
+        double rollMax = 0.0;
+        double pitchMin = 0.0;
+        double pitchMax = 0.0;
+        double maxRateDps = 0.0;            // наибольшая угловая скорость, град/с
+    };
+
+    explicit LogAnalyzer(const Options &options);
+
+    // Файлы логов в каталоге (рекурсивно) или сам файл
+    static QStringList findLogs(const QString &path);
+
+    QList<FlightSummary> analyze(const QStringList &files);
+
+    quint64 stolenTasks() const;
+
+    static QString formatSummary(const FlightSummary &summary, int minAttitudeHz);
+    static QByteArray csvHeader();
+    static QByteArray csvRow(const FlightSummary &summary);
+
+private:
+    struct SequenceState {
+        quint8 first = 0;
+        quint8 last = 0;
+        quint64 received = 0;
+        quint64 lost = 0;
+    };
+
+    // Промежуточный результат одного участка файла
+    struct Segment {
+        QString error;
+        qint64 firstUs = -1;
+        qint64 lastUs = -1;
+        qint64 linkFirstUs = -1;        // только кадры борта (без наземной станции)
+        qint64 linkLastUs = -1;
+        quint64 frames = 0;
+        quint64 bytes = 0;
+        quint64 crcErrors = 0;
+        QHash<quint32, quint64> messages;
+        QHash<quint16, SequenceState> sequences;   // (sysid << 8 | compid)
+        QList<QPair<qint64, qint64>> outages;
+
+        quint64 attitudeFrames = 0;
+        QMap<qint64, int> attitudePerSecond;
+        float rollMin = 0.0f;
+        float rollMax = 0.0f;
+        float pitchMin = 0.0f;
+        float pitchMax = 0.0f;
+        float maxRate = 0.0f;
+    };
+
+    struct FileJob;
+
+    void planFile(FileJob *job);
+    void readTlogSegment(FileJob *job, int index, qint64 begin, qint64 end);
+    void readArchiveSegment(FileJob *job, int index, int firstChunk, int lastChunk);
+    void addFrame(Segment &segment, qint64 timestampUs, const char *frame, const Mavlink::FrameInfo &info) const;
+    void mergeSegment(Segment &into, const Segment &next) const;
+    FlightSummary summarize(const FileJob &job) const;
+
+    static int tlogResync(const QByteArray &data, int from, int limit);
+
+    Options m_options;
+    WorkStealingPool *m_pool;   // только на время analyze()
+    quint64 m_stolen;
+};
+
+#endif // LOGANALYZER_H
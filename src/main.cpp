@@ -1,20 +1,123 @@
 #include <QtGui/QGuiApplication>
 #include <QtQml/QQmlApplicationEngine>
 #include <QtQml/QQmlContext>
+#include <QtQuick/QQuickWindow>
+#include <QtCore/QCommandLineParser>
 #include <QtCore/QDebug>
 #include <QtCore/QDir>
+#include <QtCore/QLoggingCategory>
+#include <cstdio>
 #include "mavlinkhandler.h"
+#include "pipelineprofiler.h"
+#include "metricsserver.h"
+#include "startuptimer.h"
+#include "receivebenchmark.h"
+#include "allocationcounter.h"
 
 int main(int argc, char *argv[])
 {
+    StartupTimer::mark("main entered");
+
     QGuiApplication app(argc, argv);
 
     app.setApplicationName("MAVLink Reader");
     app.setApplicationVersion("1.0.0");
     app.setOrganizationName("SpeedyBee");
 
-    // Регистрируем тип в QML системе
-    qmlRegisterType<MavlinkHandler>("MavlinkReader", 1, 0, "MavlinkHandler");
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption startupReportOption("startup-report",
+        "Print startup phase timings to stdout once the first telemetry arrives.");
+    QCommandLineOption startupExitOption("startup-exit",
+        "Exit right after the startup report (for startup benchmarks).");
+    QCommandLineOption profileOption("profile",
+        "Enable the pipeline profiler (receive -> frame -> decode -> publish -> render).");
+    QCommandLineOption traceOutOption("trace-out",
+        "Write the pipeline trace in Chrome trace format to <file> on exit (implies --profile).",
+        "file");
+    QCommandLineOption metricsOption("metrics",
+        "Serve Prometheus metrics at http://<address>:<port>/metrics (address defaults to localhost).",
+        "[address:]port");
+    QCommandLineOption missionDownloadOption("mission-download",
+        "Download the mission to <file> (QGC WPL 110) once the link is up.", "file");
+    QCommandLineOption missionUploadOption("mission-upload",
+        "Upload the mission from <file> (QGC WPL 110) once the link is up.", "file");
+    QCommandLineOption missionWindowOption("mission-window",
+        "Maximum number of outstanding mission item requests (1 = stop-and-wait).", "n", "16");
+    QCommandLineOption ftpGetOption("ftp-get",
+        "Download <path> from the vehicle over MAVLink FTP once the link is up.", "path");
+    QCommandLineOption ftpOutOption("ftp-out",
+        "Local file for --ftp-get (defaults to the remote file name).", "file");
+    QCommandLineOption udpAllowOption("udp-allow",
+        "Accept UDP datagrams only from <rules>: comma-separated <addr>[/prefix][:port[-port]], "
+        "IPv6 in brackets, * for any address. Default: 192.168.1.0/24 and the vehicle address.", "rules");
+    QCommandLineOption udpPeerOnlyOption("udp-peer-only",
+        "Connect the UDP socket to the vehicle address and port; the kernel drops everything else.");
+    QCommandLineOption linkBudgetOption("link-budget",
+        "Telemetry bandwidth budget in bytes/s shared by the requested streams "
+        "(0 = fixed rates without the controller).", "bytes", "5000");
+    QCommandLineOption linkOption("link",
+        "Open an additional link to the vehicle: udp:<ip>:<port>:<local port> or "
+        "serial:<device>[:<baud>]. Can be repeated; traffic is deduplicated across links.", "spec");
+    QCommandLineOption allocBenchmarkOption("alloc-benchmark",
+        "Feed <frames> synthetic frames through the receive path, report heap allocations "
+        "per frame and exit (nonzero if the steady state allocates).", "frames");
+    QCommandLineOption recordOption("record",
+        "Record received frames to the flight archive <file>.", "file");
+    QCommandLineOption replayOption("replay",
+        "Replay the flight archive <file> instead of the live link.", "file");
+    QCommandLineOption replayFromOption("replay-from",
+        "Start the replay <seconds> after the beginning of the archive.", "seconds", "0");
+    QCommandLineOption replaySpeedOption("replay-speed",
+        "Replay speed factor (0 = as fast as possible).", "factor", "1");
+    QCommandLineOption replayMessagesOption("replay-messages",
+        "Replay only these message IDs (comma separated).", "ids");
+    parser.addOption(startupReportOption);
+    parser.addOption(startupExitOption);
+    parser.addOption(profileOption);
+    parser.addOption(traceOutOption);
+    parser.addOption(metricsOption);
+    parser.addOption(missionDownloadOption);
+    parser.addOption(missionUploadOption);
+    parser.addOption(missionWindowOption);
+    parser.addOption(ftpGetOption);
+    parser.addOption(ftpOutOption);
+    parser.addOption(udpAllowOption);
+    parser.addOption(udpPeerOnlyOption);
+    parser.addOption(linkBudgetOption);
+    parser.addOption(linkOption);
+    parser.addOption(allocBenchmarkOption);
+    parser.addOption(recordOption);
+    parser.addOption(replayOption);
+    parser.addOption(replayFromOption);
+    parser.addOption(replaySpeedOption);
+    parser.addOption(replayMessagesOption);
+    parser.process(app);
+
+    const bool startupReport = parser.isSet(startupReportOption) || parser.isSet(startupExitOption);
+    const bool startupExit = parser.isSet(startupExitOption);
+    const QString traceOut = parser.value(traceOutOption);
+
+    if (parser.isSet(profileOption) || !traceOut.isEmpty()) {
+        PipelineProfiler::instance()->setEnabled(true);
+    }
+    if (!traceOut.isEmpty()) {
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, &app, [traceOut]() {
+            PipelineProfiler::instance()->exportChromeTrace(traceOut);
+        });
+    }
+
+    if (parser.isSet(metricsOption)) {
+        QHostAddress metricsAddress;
+        quint16 metricsPort = 0;
+        if (!MetricsServer::parseListenAddress(parser.value(metricsOption), &metricsAddress, &metricsPort)) {
+            qCritical() << "Invalid --metrics value:" << parser.value(metricsOption);
+            return -1;
+        }
+        MetricsServer *metricsServer = new MetricsServer(&app);
+        metricsServer->listen(metricsAddress, metricsPort);
+    }
 
     QQmlApplicationEngine engine;
 
@@ -22,11 +125,156 @@ int main(int argc, char *argv[])
     QString applicationDirPath = QDir::currentPath();
     engine.rootContext()->setContextProperty("applicationDirPath", applicationDirPath);
 
-    // Создаем и регистрируем MAVLink handler
+    // Создаем MAVLink handler, в QML он доступен как singleton MavlinkHandler
     MavlinkHandler* mavlinkHandler = new MavlinkHandler(&app);
-    engine.rootContext()->setContextProperty("mavlinkHandler", mavlinkHandler);
+    MavlinkHandler::setInstance(mavlinkHandler);
+
+    // Проверка пути приема на выделения памяти: без сети и без QML
+    if (parser.isSet(allocBenchmarkOption)) {
+        QLoggingCategory::setFilterRules("mavlink.packets.debug=false");
+        const ReceiveBenchmark::Result result =
+            ReceiveBenchmark::run(mavlinkHandler, qMax(1, parser.value(allocBenchmarkOption).toInt()));
+        fprintf(stdout, "Receive path: %llu frames in %llu datagrams, %.0f ns/frame\n",
+                static_cast<unsigned long long>(result.frames), static_cast<unsigned long long>(result.datagrams),
+                result.nsPerFrame);
+        if (!result.complete()) {
+            // Кадры на границах датаграмм теряются - замер не про весь поток
+            fprintf(stdout, "Lost frames: only %llu of %llu reached the parser\n",
+                    static_cast<unsigned long long>(result.parsed), static_cast<unsigned long long>(result.frames));
+            return 1;
+        }
+        if (!AllocationCounter::isAvailable()) {
+            fprintf(stdout, "Allocations: not counted (build with -DMAVLINKREADER_COUNT_ALLOCATIONS=ON)\n");
+            return 0;
+        }
+        fprintf(stdout, "Allocations: %llu (%.3f per frame, %llu bytes), buffer pool misses: %llu\n",
+                static_cast<unsigned long long>(result.allocations), result.allocationsPerFrame(),
+                static_cast<unsigned long long>(result.allocatedBytes),
+                static_cast<unsigned long long>(result.poolMisses));
+        return result.allocations == 0 ? 0 : 1;
+    }
+
+    // Фильтр источников UDP - до открытия каналов
+    if (parser.isSet(udpAllowOption) && !mavlinkHandler->setUdpSourceFilter(parser.value(udpAllowOption))) {
+        qCritical() << "Invalid --udp-allow value:" << parser.value(udpAllowOption);
+        return -1;
+    }
+    mavlinkHandler->setUdpConnectToPeer(parser.isSet(udpPeerOnlyOption));
+
+    // Бюджет полосы для частот потоков
+    bool budgetOk = false;
+    const int linkBudget = parser.value(linkBudgetOption).toInt(&budgetOk);
+    if (!budgetOk || linkBudget < 0) {
+        qCritical() << "Invalid --link-budget value:" << parser.value(linkBudgetOption);
+        return -1;
+    }
+    mavlinkHandler->streams()->setEnabled(linkBudget > 0);
+    if (linkBudget > 0) {
+        mavlinkHandler->streams()->setBudget(linkBudget);
+    }
 
-    // Загружаем основной QML файл из модуля MavlinkReader
+    // Резервные каналы из командной строки
+    for (const QString &spec : parser.values(linkOption)) {
+        const QStringList parts = spec.split(':');
+        bool ok = false;
+        if (parts.size() == 4 && parts[0] == "udp") {
+            ok = mavlinkHandler->addUdpLink(parts[1], parts[2].toInt(), parts[3].toInt());
+        } else if (parts.size() >= 2 && parts[0] == "serial") {
+            bool hasBaud = false;
+            const int baud = parts.size() > 2 ? parts.last().toInt(&hasBaud) : 0;
+            const QString device = hasBaud ? parts.mid(1, parts.size() - 2).join(':') : parts.mid(1).join(':');
+            ok = mavlinkHandler->addSerialLink(device, hasBaud ? baud : 57600);
+        } else {
+            qCritical() << "Invalid --link value:" << spec;
+            return -1;
+        }
+        if (!ok) {
+            qWarning() << "❌ Link not connected:" << spec;
+        }
+    }
+
+    // Передача миссии из командной строки: старт после подключения, прогресс в stdout
+    MissionTransfer *mission = mavlinkHandler->mission();
+    mission->setMaxWindow(parser.value(missionWindowOption).toInt());
+    const QString missionDownload = parser.value(missionDownloadOption);
+    const QString missionUpload = parser.value(missionUploadOption);
+    if (!missionDownload.isEmpty() || !missionUpload.isEmpty()) {
+        QObject::connect(mavlinkHandler, &MavlinkHandler::connectedChanged, &app, [=](bool connected) {
+            if (!connected || mission->busy()) {
+                return;
+            }
+            if (!missionDownload.isEmpty()) {
+                mavlinkHandler->downloadMission(missionDownload);
+            } else {
+                mavlinkHandler->uploadMission(missionUpload);
+            }
+        });
+        QObject::connect(mission, &MissionTransfer::progressChanged, &app, [mission]() {
+            fprintf(stdout, "\rMission: %d/%d items, %.1f items/s, window %d, rtt %.0f ms   ",
+                    mission->transferredItems(), mission->totalItems(), mission->itemsPerSecond(),
+                    mission->window(), mission->rttMs());
+            fflush(stdout);
+        });
+        QObject::connect(mission, &MissionTransfer::finished, &app, [](bool, const QString &message) {
+            fprintf(stdout, "\n%s\n", qPrintable(message));
+            fflush(stdout);
+        });
+    }
+
+    // Скачивание файла по MAVLink FTP из командной строки
+    if (parser.isSet(ftpGetOption)) {
+        FtpClient *ftp = mavlinkHandler->ftp();
+        const QString remotePath = parser.value(ftpGetOption);
+        const QString localPath = parser.isSet(ftpOutOption)
+                                      ? parser.value(ftpOutOption)
+                                      : remotePath.section('/', -1);
+        QObject::connect(mavlinkHandler, &MavlinkHandler::connectedChanged, &app, [=](bool connected) {
+            if (connected && !ftp->busy()) {
+                mavlinkHandler->downloadFile(remotePath, localPath);
+            }
+        });
+        QObject::connect(ftp, &FtpClient::progressChanged, &app, [ftp]() {
+            fprintf(stdout, "\rFTP: %.0f/%.0f bytes, %.1f KB/s, %s, %d retransmissions   ",
+                    ftp->bytesReceived(), ftp->fileSize(), ftp->bytesPerSecond() / 1024.0,
+                    qPrintable(ftp->stateName()), ftp->retransmissions());
+            fflush(stdout);
+        });
+        QObject::connect(ftp, &FtpClient::finished, &app, [](bool, const QString &message) {
+            fprintf(stdout, "\n%s\n", qPrintable(message));
+            fflush(stdout);
+        });
+    }
+
+    // Архив полета: запись живого канала или воспроизведение вместо него
+    if (parser.isSet(replayOption)) {
+        QList<int> replayMessages;
+        for (const QString &id : parser.value(replayMessagesOption).split(',', Qt::SkipEmptyParts)) {
+            replayMessages.append(id.trimmed().toInt());
+        }
+        if (!mavlinkHandler->startReplay(parser.value(replayOption), parser.value(replayFromOption).toDouble(),
+                                         parser.value(replaySpeedOption).toDouble(), replayMessages)) {
+            qCritical() << "Cannot replay" << parser.value(replayOption);
+            return -1;
+        }
+    } else if (parser.isSet(recordOption)) {
+        mavlinkHandler->startRecording(parser.value(recordOption));
+    }
+
+    // Первая телеметрия - последняя фаза запуска
+    QObject::connect(mavlinkHandler, &MavlinkHandler::attitudeChanged, &app, [&]() {
+        if (StartupTimer::mark("first telemetry")) {
+            qInfo().noquote() << StartupTimer::report();
+            if (startupReport) {
+                fputs(qPrintable(StartupTimer::report()), stdout);
+                fflush(stdout);
+            }
+            if (startupExit) {
+                QCoreApplication::quit();
+            }
+        }
+    }, Qt::SingleShotConnection);
+
+    // Загружаем основной QML файл из модуля MavlinkReader (панели создаются асинхронно)
     engine.loadFromModule("MavlinkReader", "Main");
 
     if (engine.rootObjects().isEmpty()) {
@@ -34,6 +282,29 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    StartupTimer::mark("engine ready");
+
+    if (auto *window = qobject_cast<QQuickWindow *>(engine.rootObjects().first())) {
+        // Первый кадр (сигнал приходит из потока рендера)
+        QObject::connect(window, &QQuickWindow::frameSwapped, window, []() {
+            StartupTimer::mark("first frame");
+        }, static_cast<Qt::ConnectionType>(Qt::DirectConnection | Qt::SingleShotConnection));
+
+        // Стадия render профилировщика отмечается прямо в потоке рендера
+        QObject::connect(window, &QQuickWindow::frameSwapped, window, []() {
+            Trace::rendered();
+        }, Qt::DirectConnection);
+
+        // Перед синхронизацией кадра - прогноз ориентации к моменту его вывода
+        QObject::connect(window, &QQuickWindow::afterAnimating,
+                         mavlinkHandler, &MavlinkHandler::updateDisplayAttitude);
+
+        // Кадр выведен на экран - для измерения задержки "борт -> экран"
+        QObject::connect(window, &QQuickWindow::frameSwapped,
+                         mavlinkHandler, &MavlinkHandler::notifyFrameRendered,
+                         Qt::QueuedConnection);
+    }
+
     qDebug() << "✅ MAVLink Reader application started successfully";
 
     return app.exec();
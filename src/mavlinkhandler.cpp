@@ -2,52 +2,172 @@
 #include <QDebug>
 #include <QtEndian>
 #include <QDateTime>
+#include <QPointer>
+#include <QMetaMethod>
+#include "mavlinkprotocol.h"
+#include "mavlinkmessages.h"
+#include "pipelineprofiler.h"
+#include "archivereplay.h"
+#include "seriallink.h"
+#include <QVariantMap>
+#include <QJSEngine>
+#include <cmath>
+
+namespace {
+
+constexpr quint8 ResultDenied = 2;          // MAV_RESULT_DENIED
+constexpr quint8 ResultUnsupported = 3;     // MAV_RESULT_UNSUPPORTED
+
+} // namespace
 
 MavlinkHandler::MavlinkHandler(QObject *parent)
     : QObject(parent)
+    , m_links(new LinkManager(this))
     , m_networkManager(new NetworkManager(this))
-    , m_rawData("No data received")
+    , m_udpConnectToPeer(false)
+    , m_attitudeCount(0)
     , m_attitudeFrequency(0)
     , m_lastAttitudeTime(0)
-    , m_retryCount(0)
+    , m_frequencyTask(0)
+    , m_streamStartTask(0)
+    , m_streamRequestTask(0)
+    , m_timeSync(new TimeSync(this))
+    , m_attitudeSysId(1)
+    , m_attitudePendingDisplay(false)
+    , m_attitudeLatency(0.0)
+    , m_predictionEnabled(false)
+    , m_attitudeSampleNs(0)
+    , m_predictionMs(0.0)
+    , m_frameIntervalMs(1000.0 / 60.0)
+    , m_lastSwapNs(0)
+    , m_commands(new CommandManager(this))
+    , m_attitudeRequestsPending(0)
+    , m_attitudeStreamAccepted(false)
+    , m_mission(new MissionTransfer(this))
+    , m_ftp(new FtpClient(this))
+    , m_inspector(new MessageInspector(this))
+    , m_streams(new StreamController(m_commands, m_inspector, this))
+    , m_bus(new MessageBus(this))
+    , m_archiveEpochUs(0)
+    , m_replay(nullptr)
+    , m_framesV1Metric(Metrics::counter("mavlink_frames_received_total", "MAVLink frames with valid CRC", "version=\"1\""))
+    , m_framesV2Metric(Metrics::counter("mavlink_frames_received_total", "MAVLink frames with valid CRC", "version=\"2\""))
+    , m_crcFailuresMetric(Metrics::counter("mavlink_crc_failures_total", "Frames dropped because of a CRC mismatch"))
+    , m_unsignedRejectsMetric(Metrics::counter("mavlink_signing_rejects_total", "Frames dropped by MAVLink2 signing checks", "reason=\"unsigned\""))
+    , m_badSignatureMetric(Metrics::counter("mavlink_signing_rejects_total", "Frames dropped by MAVLink2 signing checks", "reason=\"bad_signature\""))
+    , m_replayRejectsMetric(Metrics::counter("mavlink_signing_rejects_total", "Frames dropped by MAVLink2 signing checks", "reason=\"replay\""))
+    , m_sequenceGapsMetric(Metrics::counter("mavlink_sequence_gaps_total", "Discontinuities in per-component sequence numbers"))
+    , m_messagesLostMetric(Metrics::counter("mavlink_messages_lost_total", "Messages missing according to sequence numbers"))
+    , m_bufferBytesMetric(Metrics::gauge("mavlink_parse_buffer_bytes", "Unparsed bytes waiting in the receive buffer"))
+    , m_attitudeFrequencyMetric(Metrics::gauge("mavlink_attitude_frequency_hz", "ATTITUDE messages per second"))
+    , m_parseTimeMetric(Metrics::timing("mavlink_parse_duration_seconds", "Time spent parsing received datagrams"))
 {
-    connect(m_networkManager, &NetworkManager::dataReceived,
+    // Буфер разбора не перевыделяется на каждой датаграмме
+    m_buffer.reserve(2 * 4096);
+
+    // Все каналы идут через LinkManager, основной UDP - один из них
+    m_links->addLink("udp", m_networkManager);
+    connect(m_links, &MavlinkSource::dataReceived,
             this, &MavlinkHandler::onNetworkDataReceived);
-    connect(m_networkManager, &NetworkManager::connectedChanged,
+    connect(m_links, &LinkManager::connectedChanged,
             this, &MavlinkHandler::onNetworkConnectedChanged);
-    connect(m_networkManager, &NetworkManager::statusChanged,
+    connect(m_links, &LinkManager::statusChanged,
             this, &MavlinkHandler::onNetworkStatusChanged);
 
-    // Таймер для расчета частоты обновления
-    m_frequencyTimer = new QTimer(this);
-    connect(m_frequencyTimer, &QTimer::timeout, this, &MavlinkHandler::updateFrequency);
-    m_frequencyTimer->start(1000);
+    // Расчет частоты обновления раз в секунду через общий планировщик.
+    // Частота нормируется на фактический интервал, поэтому допуск не искажает замер.
+    m_frequencyClock.start();
+    m_frequencyTask = Scheduler::instance()->scheduleRepeating(1000, this, [this]() {
+        updateFrequency();
+    }, 100);
 
-    // Таймер для повторных запросов потока данных
-    m_streamRequestTimer = new QTimer(this);
-    connect(m_streamRequestTimer, &QTimer::timeout, this, &MavlinkHandler::ensureAttitudeStream);
-    m_streamRequestTimer->setInterval(2000); // Увеличили частоту проверок
+    // TIMESYNC: исходящие запросы и ответы идут через общий sendFrame
+    connect(m_timeSync, &TimeSync::frameReady, this, [this](const QByteArray &frame) {
+        sendFrame(frame);
+    });
+    connect(m_commands, &CommandManager::frameReady, this, [this](const QByteArray &frame) {
+        sendFrame(frame);
+    });
+    connect(m_mission, &MissionTransfer::frameReady, this, [this](const QByteArray &frame) {
+        sendFrame(frame);
+    });
+    connect(m_mission, &MissionTransfer::finished, this, [this](bool success, const QString &message) {
+        // Путь задан только для скачивания
+        if (success && !m_missionPath.isEmpty()) {
+            QString error;
+            if (!MissionTransfer::saveWaypoints(m_missionPath, m_mission->items(), &error)) {
+                qWarning() << "❌ Failed to save mission:" << m_missionPath << error;
+            }
+        }
+        m_missionPath.clear();
+        emit newMessage(message);
+    });
+    connect(m_ftp, &FtpClient::frameReady, this, [this](const QByteArray &frame) {
+        sendFrame(frame);
+    });
+    connect(m_ftp, &FtpClient::finished, this, [this](bool, const QString &message) {
+        emit newMessage(message);
+    });
+    connect(m_timeSync, &TimeSync::synchronizedChanged, this, [this](quint8 sysid, bool) {
+        if (sysid == m_attitudeSysId) {
+            emit timeSynchronizedChanged();
+        }
+    });
 }
 
 MavlinkHandler::~MavlinkHandler()
 {
+    stopReplay();
+    stopRecording();
     disconnectFromFC();
 }
 
+namespace {
+QPointer<MavlinkHandler> s_instance;
+
+// Дальше прогноз не ведется: поток прерван, экстраполяция только уведет углы
+constexpr double MaxPredictionMs = 200.0;
+// Интервалы между кадрами длиннее - паузы без перерисовки, не период вывода
+constexpr double MaxFrameIntervalMs = 50.0;
+}
+
+void MavlinkHandler::setInstance(MavlinkHandler *handler)
+{
+    s_instance = handler;
+}
+
+MavlinkHandler *MavlinkHandler::create(QQmlEngine *qmlEngine, QJSEngine *jsEngine)
+{
+    Q_UNUSED(qmlEngine)
+    Q_UNUSED(jsEngine)
+
+    if (!s_instance) {
+        s_instance = new MavlinkHandler();
+    }
+    // Объектом владеет приложение, а не движок QML
+    QJSEngine::setObjectOwnership(s_instance, QJSEngine::CppOwnership);
+    return s_instance;
+}
+
 // Добавляем свойство для частоты
 int MavlinkHandler::attitudeFrequency() const
 {
     return m_attitudeFrequency;
 }
 
+bool MavlinkHandler::signingEnabled() const
+{
+    return m_signing.hasKey();
+}
+
 bool MavlinkHandler::connected() const
 {
-    return m_networkManager->connected();
+    return m_links->connected();
 }
 
 QString MavlinkHandler::status() const
 {
-    return m_networkManager->status();
+    return m_links->status();
 }
 
 MavlinkAttitude MavlinkHandler::attitude() const
@@ -55,9 +175,38 @@ MavlinkAttitude MavlinkHandler::attitude() const
     return m_currentAttitude;
 }
 
+MavlinkAttitude MavlinkHandler::displayAttitude() const
+{
+    return m_displayAttitude;
+}
+
+bool MavlinkHandler::predictionEnabled() const
+{
+    return m_predictionEnabled;
+}
+
+void MavlinkHandler::setPredictionEnabled(bool enabled)
+{
+    if (m_predictionEnabled == enabled) {
+        return;
+    }
+    m_predictionEnabled = enabled;
+    updateDisplayAttitude();
+    emit predictionEnabledChanged(enabled);
+}
+
+double MavlinkHandler::predictionMs() const
+{
+    return m_predictionMs;
+}
+
 QString MavlinkHandler::rawData() const
 {
-    return m_rawData;
+    // Строка собирается только по запросу (QML), а не на каждую датаграмму
+    if (m_lastDatagram.isNull()) {
+        return "No data received";
+    }
+    return QString::fromLatin1(m_lastDatagram.toHex(' '));
 }
 
 
@@ -65,13 +214,37 @@ QString MavlinkHandler::rawData() const
 void MavlinkHandler::connectToFC(const QString &ip, int port)
 {
     int actualPort = (port == 5760) ? 14550 : port;
+    stopReplay();
     m_networkManager->connectToFC(ip, actualPort);
+    startSession();
+}
 
+void MavlinkHandler::startSession()
+{
     // Запускаем таймер для обеспечения потока данных
-    QTimer::singleShot(2000, this, [this]() {
+    // Через 2 секунды запрашиваем поток и периодически проверяем его частоту
+    Scheduler *scheduler = Scheduler::instance();
+    scheduler->cancel(m_streamStartTask);
+    scheduler->cancel(m_streamRequestTask);
+    m_streamStartTask = scheduler->schedule(2000, this, [this]() {
+        if (m_streams->enabled()) {
+            // Частоты ведет StreamController в пределах бюджета канала
+            if (m_timeSync->isSynchronized(m_attitudeSysId)) {
+                m_commands->setInitialRtt(m_timeSync->rttMs(m_attitudeSysId));
+            }
+            m_streams->start(m_attitudeSysId, 1);
+            return;
+        }
         requestAttitudeStream();
-        m_streamRequestTimer->start();
-    });
+        m_streamRequestTask = Scheduler::instance()->scheduleRepeating(2000, this, [this]() {
+            ensureAttitudeStream();
+        }, 200); // Увеличили частоту проверок
+    }, 100);
+
+    m_timeSync->clear();
+    m_lastSequence.clear();
+    m_attitudeStreamAccepted = false;
+    m_timeSync->start();
 }
 
 // void MavlinkHandler::connectToFC(const QString &ip, int port)
@@ -85,32 +258,139 @@ void MavlinkHandler::connectToFC(const QString &ip, int port)
 
 void MavlinkHandler::disconnectFromFC()
 {
-    m_streamRequestTimer->stop();
-    m_networkManager->disconnectFromFC();
+    Scheduler::instance()->cancel(m_streamStartTask);
+    Scheduler::instance()->cancel(m_streamRequestTask);
+    m_streamStartTask = 0;
+    m_streamRequestTask = 0;
+    m_timeSync->stop();
+    m_streams->stop();
+    m_commands->cancelAll();
+    m_mission->cancel();
+    m_ftp->cancel();
+    m_links->disconnectAll();
 }
 
 void MavlinkHandler::clearData()
 {
-    m_rawData.clear();
-    emit rawDataChanged(m_rawData);
+    m_lastDatagram.resize(0);
+    m_inspector->clear();
+    emit rawDataChanged(QString());
+}
+
+void MavlinkHandler::setSigningPassphrase(const QString &passphrase)
+{
+    if (passphrase.isEmpty()) {
+        disableSigning();
+        return;
+    }
+
+    m_signing.setPassphrase(passphrase);
+    emit signingEnabledChanged(true);
+    emit newMessage("MAVLink2 signing enabled");
+}
+
+void MavlinkHandler::setSigningKeyHex(const QString &hexKey)
+{
+    if (!m_signing.setKey(QByteArray::fromHex(hexKey.toLatin1()))) {
+        emit newMessage("Invalid signing key: expected 64 hex characters");
+        return;
+    }
+
+    emit signingEnabledChanged(true);
+    emit newMessage("MAVLink2 signing enabled");
+}
+
+void MavlinkHandler::disableSigning()
+{
+    if (!m_signing.hasKey()) {
+        return;
+    }
+
+    m_signing.clearKey();
+    emit signingEnabledChanged(false);
+    emit newMessage("MAVLink2 signing disabled");
+}
+
+void MavlinkHandler::setAcceptUnsignedMessages(bool accept)
+{
+    m_signing.setAcceptUnsigned(accept);
+}
+
+void MavlinkHandler::sendFrame(QByteArray frame)
+{
+    // При включенной подписи подписываем все исходящие кадры MAVLink 2.0
+    if (m_signing.hasKey() && !frame.isEmpty()
+        && static_cast<quint8>(frame[0]) == Mavlink::StxV2) {
+        m_signing.signFrame(frame);
+    }
+
+    m_links->sendData(frame);
+}
+
+bool MavlinkHandler::checkFrameSignature(const char *frame, int frameLen, bool isSigned, quint32 msgId)
+{
+    if (!isSigned) {
+        if (m_signing.acceptsUnsignedMessage(msgId)) {
+            return true;
+        }
+        m_unsignedRejectsMetric->add();
+        qDebug() << "🔒 Dropped unsigned message, ID:" << msgId;
+        return false;
+    }
+
+    // Ключ не задан - подписанные кадры принимаем без проверки
+    if (!m_signing.hasKey()) {
+        return true;
+    }
+
+    switch (m_signing.verifyFrame(frame, frameLen)) {
+    case MavlinkSigning::Result::Ok:
+    case MavlinkSigning::Result::NoKey:
+        return true;
+    case MavlinkSigning::Result::BadSignature:
+        m_badSignatureMetric->add();
+        qDebug() << "❌ Bad MAVLink2 signature, ID:" << msgId
+                 << "total failures:" << m_signing.signatureFailures();
+        return false;
+    case MavlinkSigning::Result::Replay:
+    case MavlinkSigning::Result::Stale:
+        m_replayRejectsMetric->add();
+        qDebug() << "⚠️ Rejected replayed MAVLink2 frame, ID:" << msgId
+                 << "total rejections:" << m_signing.replayRejections();
+        return false;
+    }
+    return false;
 }
 
 void MavlinkHandler::onNetworkDataReceived(const QByteArray &data)
 {
-    // Add to buffer for parsing
+    // Add to buffer for parsing. Емкость зарезервирована заранее: append
+    // копирует байты, а не разделяет буфер датаграммы из пула.
     m_buffer.append(data);
 
-    // Update raw data display
-    m_rawData = QString::fromLatin1(data.toHex(' '));
-    emit rawDataChanged(m_rawData);
+    // Update raw data display: копия в собственный буфер, hex - в rawData()
+    m_lastDatagram.resize(data.size());
+    memcpy(m_lastDatagram.data(), data.constData(), size_t(data.size()));
+    emit rawDataChanged(QString());
 
     // Parse MAVLink messages
     parseMavlinkMessage(m_buffer);
 
-    // Keep buffer reasonable size
+    // Keep buffer reasonable size (сдвиг на месте, без нового буфера)
     if (m_buffer.size() > 4096) {
-        m_buffer = m_buffer.right(2048);
+        m_buffer.remove(0, m_buffer.size() - 2048);
     }
+    m_bufferBytesMetric->set(m_buffer.size());
+}
+
+void MavlinkHandler::feedData(const QByteArray &data)
+{
+    emit m_networkManager->dataReceived(data);
+}
+
+quint64 MavlinkHandler::framesParsed() const
+{
+    return m_framesV1Metric->value() + m_framesV2Metric->value();
 }
 
 void MavlinkHandler::onNetworkConnectedChanged(bool connected)
@@ -125,149 +405,547 @@ void MavlinkHandler::onNetworkStatusChanged(const QString &status)
 
 void MavlinkHandler::parseMavlinkMessage(const QByteArray &data)
 {
-    qDebug() << "🔍 Parsing" << data.size() << "bytes of data";
+    qCDebug(lcMavlinkPackets) << "🔍 Parsing" << data.size() << "bytes of data";
+    qCDebug(lcMavlinkPackets) << "📊 Data hex preview:" << data.left(16).toHex(' ');
 
-    if (data.size() > 0) {
-        QByteArray hexPreview = data.left(16).toHex(' ');
-        qDebug() << "📊 Data hex preview:" << hexPreview;
-    }
+    // Время приема для оценки задержки канала
+    const qint64 rx_ns = TimeSync::hostNowNs();
+    const quint32 flow = Trace::currentFlow();
+    const qint64 rx_us = m_archiveEpochUs + rx_ns / 1000;
 
+    Mavlink::FrameInfo frame;
     int i = 0;
     while (i < data.size()) {
-        quint8 start_byte = static_cast<quint8>(data[i]);
-
-        // MAVLink 2.0
-        if (start_byte == 0xFD && (i + 12) < data.size()) {
-            quint8 payload_len = static_cast<quint8>(data[i + 1]);
-            quint8 incompat_flags = static_cast<quint8>(data[i + 2]);
-            quint8 compat_flags = static_cast<quint8>(data[i + 3]);
-            quint8 seq = static_cast<quint8>(data[i + 4]);
-            quint8 sysid = static_cast<quint8>(data[i + 5]);
-            quint8 compid = static_cast<quint8>(data[i + 6]);
-
-            // Message ID - 3 bytes little endian
-            quint32 msg_id = static_cast<quint32>(data[i + 7]) |
-                             (static_cast<quint32>(data[i + 8]) << 8) |
-                             (static_cast<quint32>(data[i + 9]) << 16);
-
-            int total_len = 10 + payload_len + 2; // Header + payload + checksum
-
-            // Проверяем, что сообщение полностью в буфере
-            if (i + total_len <= data.size()) {
-                qDebug() << "🎯 MAVLink 2.0 message - ID:" << msg_id << "Length:" << payload_len;
-
-                if (msg_id == 30) { // ATTITUDE
-                    qDebug() << "🎉 Found ATTITUDE message!";
-                    MavlinkAttitude attitude = parseAttitudeMessage(data, i + 10);
-                    if (attitude.timestamp != 0) {
-                        m_currentAttitude = attitude;
-                        emit attitudeChanged(m_currentAttitude);
-
-                        QString msg = QString("ATTITUDE: Roll=%1°, Pitch=%2°, Yaw=%3°")
-                                          .arg(attitude.roll, 0, 'f', 2)
-                                          .arg(attitude.pitch, 0, 'f', 2)
-                                          .arg(attitude.yaw, 0, 'f', 2);
-                        emit newMessage(msg);
-                        qDebug() << msg;
-                    }
-                } else if (msg_id == 0) { // HEARTBEAT
-                    qDebug() << "💓 HEARTBEAT from system" << sysid;
-                } else if (msg_id == 1) { // SYS_STATUS
-                    qDebug() << "📊 SYS_STATUS message";
-                } else {
-                    qDebug() << "📨 Other MAVLink 2.0 message, ID:" << msg_id;
-                }
-
-                i += total_len; // Переходим к следующему сообщению
-                continue;
+        const char *start = data.constData() + i;
+        const Mavlink::FrameStatus status = Mavlink::parseFrame(start, data.size() - i, &frame);
+        if (status == Mavlink::FrameStatus::Incomplete) {
+            break; // Остаток кадра придет со следующими данными
+        }
+        if (status != Mavlink::FrameStatus::Ok) {
+            if (status == Mavlink::FrameStatus::BadCrc) {
+                // Ложный стартовый байт или поврежденный кадр, ищем дальше
+                m_crcFailuresMetric->add();
             }
+            i++; // Продолжаем поиск
+            continue;
         }
-        // MAVLink 1.0
-        else if (start_byte == 0xFE && (i + 6) < data.size()) {
-            quint8 payload_len = static_cast<quint8>(data[i + 1]);
-            quint8 seq = static_cast<quint8>(data[i + 2]);
-            quint8 sysid = static_cast<quint8>(data[i + 3]);
-            quint8 compid = static_cast<quint8>(data[i + 4]);
-            quint8 msg_id = static_cast<quint8>(data[i + 5]);
-
-            int total_len = 6 + payload_len + 2; // Header + payload + checksum
-
-            if (i + total_len <= data.size()) {
-                qDebug() << "🎯 MAVLink 1.0 message - ID:" << msg_id << "Length:" << payload_len;
-
-                if (msg_id == 30) { // ATTITUDE
-                    qDebug() << "🎉 Found ATTITUDE message!";
-                    MavlinkAttitude attitude = parseAttitudeMessage(data, i + 6);
-                    if (attitude.timestamp != 0) {
-                        m_currentAttitude = attitude;
-                        emit attitudeChanged(m_currentAttitude);
-
-                        QString msg = QString("ATTITUDE: Roll=%1°, Pitch=%2°, Yaw=%3°")
-                                          .arg(attitude.roll, 0, 'f', 2)
-                                          .arg(attitude.pitch, 0, 'f', 2)
-                                          .arg(attitude.yaw, 0, 'f', 2);
-                        emit newMessage(msg);
-                        qDebug() << msg;
-                    }
-                }
 
-                i += total_len;
-                continue;
-            }
+        // Кадры архива проверены при записи, их подпись уже "повторная".
+        // MAVLink 1.0 не поддерживает подпись.
+        if (!m_replay && !checkFrameSignature(start, frame.length, frame.isSigned, frame.msgId)) {
+            i += frame.length;
+            continue;
         }
 
-        i++; // Продолжаем поиск
+        qCDebug(lcMavlinkPackets) << "🎯 MAVLink" << (frame.version == 2 ? "2.0" : "1.0") << "message - ID:" << frame.msgId
+                 << "Length:" << frame.payloadLen << (frame.isSigned ? "(signed)" : "");
+
+        (frame.version == 2 ? m_framesV2Metric : m_framesV1Metric)->add();
+        countFrame(frame.sysid, frame.compid, frame.seq, frame.msgId);
+        m_inspector->record(frame.sysid, frame.compid, frame.msgId, start + frame.headerLen, frame.payloadLen,
+                            frame.length, rx_ns);
+        if (m_archive.isOpen()) {
+            m_archive.append(rx_us, frame.sysid, frame.compid, frame.msgId, start, frame.length);
+        }
+        Trace::point(Trace::Frame, flow);
+        handleMessage(data, i + frame.headerLen, frame.payloadLen, frame.sysid, frame.compid, frame.msgId, rx_ns);
+
+        i += frame.length; // Переходим к следующему сообщению
     }
 
-    // Сохраняем необработанные данные для следующего вызова
-    if (i < data.size()) {
-        m_buffer = data.mid(i);
+    // Сохраняем необработанные данные для следующего вызова (data - это m_buffer)
+    m_buffer.remove(0, i);
+
+    m_parseTimeMetric->observeNs(TimeSync::hostNowNs() - rx_ns);
+}
+
+void MavlinkHandler::countFrame(quint8 sysid, quint8 compid, quint8 seq, quint32 msgId)
+{
+    // Пропуски в номерах последовательности отдельно для каждого компонента
+    const quint16 key = quint16(sysid) << 8 | compid;
+    auto last = m_lastSequence.find(key);
+    if (last != m_lastSequence.end()) {
+        // Повтор или переупорядочивание - не потеря
+        const int lost = Mavlink::sequenceGap(last.value(), seq);
+        if (lost > 0) {
+            m_sequenceGapsMetric->add();
+            m_messagesLostMetric->add(lost);
+        }
+        if (lost >= 0) {
+            last.value() = seq;
+        }
+        m_streams->recordFrame(sysid, qMax(lost, 0));
     } else {
-        m_buffer.clear();
+        m_lastSequence.insert(key, seq);
     }
+
+    Metrics::Counter *&counter = m_messageMetrics[msgId];
+    if (!counter) {
+        counter = Metrics::counter("mavlink_messages_received_total", "Received messages by message ID",
+                                   "msgid=\"" + QByteArray::number(msgId) + "\"");
+    }
+    counter->add();
 }
 
 
 
 
 
-// В методе parseAttitudeMessage добавляем подсчет частоты
-MavlinkAttitude MavlinkHandler::parseAttitudeMessage(const QByteArray &data, int startPos)
+void MavlinkHandler::handleMessage(const QByteArray &data, int payloadPos, int payloadLen,
+                                   quint8 sysid, quint8 compid, quint32 msgId, qint64 rxNs)
 {
-    MavlinkAttitude attitude;
+    const char *payload = data.constData() + payloadPos;
+
+    // Сообщения с time_boot_ms в начале payload - измеряем задержку "борт -> прием"
+    switch (msgId) {
+    case Mavlink::MsgScaledPressure:
+    case Mavlink::MsgAttitude:
+    case Mavlink::MsgAttitudeQuaternion:
+    case Mavlink::MsgLocalPositionNed:
+    case Mavlink::MsgGlobalPositionInt:
+    case Mavlink::MsgRcChannels:
+        m_timeSync->recordLatency(sysid, msgId, Mavlink::readField<quint32>(payload, payloadLen, 0), rxNs);
+        break;
+    default:
+        break;
+    }
 
-    if (startPos + 28 <= data.size()) { // ATTITUDE message is 28 bytes
-        // Parse time_boot_ms (uint32_t, bytes 0-3)
-        attitude.timestamp = qFromLittleEndian<quint32>(
-            reinterpret_cast<const uchar*>(data.constData() + startPos));
-
-        // Parse roll (float, bytes 4-7)
-        float roll = 0.0f;
-        memcpy(&roll, data.constData() + startPos + 4, sizeof(float));
-        attitude.roll = static_cast<double>(qFromLittleEndian<float>(roll)) * 180.0 / M_PI;
-
-        // Parse pitch (float, bytes 8-11)
-        float pitch = 0.0f;
-        memcpy(&pitch, data.constData() + startPos + 8, sizeof(float));
-        attitude.pitch = static_cast<double>(qFromLittleEndian<float>(pitch)) * 180.0 / M_PI;
-
-        // Parse yaw (float, bytes 12-15)
-        float yaw = 0.0f;
-        memcpy(&yaw, data.constData() + startPos + 12, sizeof(float));
-        attitude.yaw = static_cast<double>(qFromLittleEndian<float>(yaw)) * 180.0 / M_PI;
-
-        // Подсчитываем частоту
-        m_attitudeCount++;
-        qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-
-        // Логируем только каждое 30-е сообщение чтобы не засорять консоль
-        if (m_attitudeCount % 30 == 0) {
-            qDebug() << "✅ ATTITUDE #" << m_attitudeCount << "roll=" << attitude.roll
-                     << "pitch=" << attitude.pitch << "yaw=" << attitude.yaw
-                     << "freq=" << m_attitudeFrequency << "Hz";
+    // Подписчики шины - раньше собственной обработки; без них одна проверка флага
+    if (m_bus->hasSubscribers(msgId)) {
+        MessageEnvelope envelope;
+        envelope.sysid = sysid;
+        envelope.compid = compid;
+        envelope.msgId = msgId;
+        envelope.rxNs = rxNs;
+        m_bus->publish(envelope, payload, payloadLen);
+    }
+
+    if (msgId == Mavlink::MsgAttitude) {
+        qCDebug(lcMavlinkPackets) << "🎉 Found ATTITUDE message!";
+        MavlinkAttitude attitude = parseAttitudeMessage(payload, payloadLen);
+        Trace::point(Trace::Decode, Trace::currentFlow());
+        if (attitude.timestamp != 0) {
+            attitude.hostTimestamp = m_timeSync->vehicleToHostEpochMs(sysid, attitude.timestamp);
+            // Момент измерения по часам борта; без синхронизации - момент приема
+            const qint64 sampleNs = m_timeSync->vehicleToHostNs(sysid, attitude.timestamp);
+            m_attitudeSampleNs = sampleNs >= 0 ? sampleNs : rxNs;
+            m_currentAttitude = attitude;
+            m_attitudeSysId = sysid;
+            m_attitudePendingDisplay = true;
+            emit attitudeChanged(m_currentAttitude);
+            updateDisplayAttitude();
+            Trace::point(Trace::Publish, Trace::currentFlow());
+            Trace::published(Trace::currentFlow());
+
+            // Текст собирается, только если его кто-то читает
+            if (isSignalConnected(QMetaMethod::fromSignal(&MavlinkHandler::newMessage))
+                || lcMavlinkPackets().isDebugEnabled()) {
+                QString msg = QString("ATTITUDE: Roll=%1°, Pitch=%2°, Yaw=%3°")
+                                  .arg(attitude.roll, 0, 'f', 2)
+                                  .arg(attitude.pitch, 0, 'f', 2)
+                                  .arg(attitude.yaw, 0, 'f', 2);
+                emit newMessage(msg);
+                qCDebug(lcMavlinkPackets) << msg;
+            }
         }
+    } else if (msgId == Mavlink::MsgHeartbeat) {
+        qCDebug(lcMavlinkPackets) << "💓 HEARTBEAT from system" << sysid;
+    } else if (msgId == Mavlink::MsgSysStatus) {
+        qCDebug(lcMavlinkPackets) << "📊 SYS_STATUS message";
+    } else if (msgId == Mavlink::MsgTimesync) {
+        m_timeSync->handleTimesync(sysid, payload, payloadLen, rxNs);
+    } else if (CommandManager::isCommandMessage(msgId)) {
+        m_commands->handleMessage(sysid, compid, msgId, payload, payloadLen);
+    } else if (MissionTransfer::isMissionMessage(msgId)) {
+        m_mission->handleMessage(sysid, compid, msgId, payload, payloadLen);
+    } else if (FtpClient::isFtpMessage(msgId)) {
+        m_ftp->handleMessage(sysid, compid, msgId, payload, payloadLen);
     } else {
-        qDebug() << "❌ ATTITUDE message too short:" << (data.size() - startPos) << "bytes";
+        qCDebug(lcMavlinkPackets) << "📨 Other MAVLink message, ID:" << msgId;
+    }
+}
+
+void MavlinkHandler::notifyFrameRendered()
+{
+    // Период вывода кадров - на столько вперед прогнозируется ориентация
+    const qint64 now = TimeSync::hostNowNs();
+    if (m_lastSwapNs > 0) {
+        const double intervalMs = double(now - m_lastSwapNs) / 1e6;
+        if (intervalMs < MaxFrameIntervalMs) {
+            m_frameIntervalMs += 0.1 * (intervalMs - m_frameIntervalMs);
+        }
+    }
+    m_lastSwapNs = now;
+
+    // Первый кадр после нового ATTITUDE - задержка "борт -> экран"
+    if (!m_attitudePendingDisplay) {
+        return;
+    }
+    m_attitudePendingDisplay = false;
+
+    const qint64 vehicleNs = m_timeSync->vehicleToHostNs(m_attitudeSysId, m_currentAttitude.timestamp);
+    if (vehicleNs < 0) {
+        return;
+    }
+
+    const double latencyMs = double(now - vehicleNs) / 1e6;
+    m_attitudeLatency = (m_attitudeLatency <= 0.0)
+                            ? latencyMs
+                            : m_attitudeLatency + 0.1 * (latencyMs - m_attitudeLatency);
+}
+
+void MavlinkHandler::updateDisplayAttitude()
+{
+    if (m_currentAttitude.timestamp == 0) {
+        return;
+    }
+
+    MavlinkAttitude display = m_currentAttitude;
+    double horizonMs = 0.0;
+    if (m_predictionEnabled) {
+        // Собираемый сейчас кадр появится на экране примерно через период вывода;
+        // возраст измерения включает задержку канала (по TIMESYNC)
+        const qint64 targetNs = TimeSync::hostNowNs() + qint64(m_frameIntervalMs * 1e6);
+        horizonMs = qBound(0.0, double(targetNs - m_attitudeSampleNs) / 1e6, MaxPredictionMs);
+        display = predictAttitude(horizonMs);
+    }
+
+    // Сигнал - только при новых углах: горизонт растет с каждым кадром, но
+    // при нулевых скоростях или прерванном потоке прогноз не меняется,
+    // и окно не перерисовывается ради него
+    m_predictionMs = horizonMs;
+    if (display.timestamp == m_displayAttitude.timestamp && display.roll == m_displayAttitude.roll
+        && display.pitch == m_displayAttitude.pitch && display.yaw == m_displayAttitude.yaw) {
+        return;
+    }
+    m_displayAttitude = display;
+    emit displayAttitudeChanged();
+}
+
+MavlinkAttitude MavlinkHandler::predictAttitude(double horizonMs) const
+{
+    // Скорости ATTITUDE - в осях корпуса (p, q, r); производные углов Эйлера
+    // через кинематические уравнения, иначе при крене рыскание уходит в тангаж
+    MavlinkAttitude predicted = m_currentAttitude;
+    const double dt = horizonMs / 1000.0;
+    const double phi = m_currentAttitude.roll * M_PI / 180.0;
+    const double theta = m_currentAttitude.pitch * M_PI / 180.0;
+    const double cosTheta = qMax(std::cos(theta), 0.05); // у ±90° тангажа крен и рыскание вырождены
+
+    const double p = m_currentAttitude.rollspeed;
+    const double q = m_currentAttitude.pitchspeed;
+    const double r = m_currentAttitude.yawspeed;
+    const double qr = q * std::sin(phi) + r * std::cos(phi);
+
+    predicted.roll = std::remainder(m_currentAttitude.roll + (p + qr * std::sin(theta) / cosTheta) * dt, 360.0);
+    predicted.pitch = qBound(-90.0, m_currentAttitude.pitch + (q * std::cos(phi) - r * std::sin(phi)) * dt, 90.0);
+    predicted.yaw = std::remainder(m_currentAttitude.yaw + qr / cosTheta * dt, 360.0);
+    return predicted;
+}
+
+double MavlinkHandler::attitudeLatency() const
+{
+    return m_attitudeLatency;
+}
+
+bool MavlinkHandler::timeSynchronized() const
+{
+    return m_timeSync->isSynchronized(m_attitudeSysId);
+}
+
+MissionTransfer *MavlinkHandler::mission() const
+{
+    return m_mission;
+}
+
+CommandManager *MavlinkHandler::commands() const
+{
+    return m_commands;
+}
+
+bool MavlinkHandler::downloadMission(const QString &path)
+{
+    if (!connected() || m_mission->busy()) {
+        return false;
+    }
+
+    // Пока нет своих замеров, таймауты считаются по RTT из TIMESYNC
+    if (m_timeSync->isSynchronized(m_attitudeSysId)) {
+        m_mission->setInitialRtt(m_timeSync->rttMs(m_attitudeSysId));
+    }
+    m_missionPath = path;
+    return m_mission->startDownload(m_attitudeSysId, 1); // MAV_COMP_ID_AUTOPILOT1
+}
+
+bool MavlinkHandler::uploadMission(const QString &path)
+{
+    if (!connected() || m_mission->busy()) {
+        return false;
+    }
+
+    QList<MissionItem> items;
+    QString error;
+    if (!MissionTransfer::loadWaypoints(path, &items, &error)) {
+        qWarning() << "❌ Failed to load mission:" << path << error;
+        emit newMessage(QString("Failed to load mission: %1").arg(error));
+        return false;
+    }
+
+    if (m_timeSync->isSynchronized(m_attitudeSysId)) {
+        m_mission->setInitialRtt(m_timeSync->rttMs(m_attitudeSysId));
+    }
+    m_missionPath.clear();
+    return m_mission->startUpload(m_attitudeSysId, 1, items);
+}
+
+FtpClient *MavlinkHandler::ftp() const
+{
+    return m_ftp;
+}
+
+LinkManager *MavlinkHandler::links() const
+{
+    return m_links;
+}
+
+MessageInspector *MavlinkHandler::inspector() const
+{
+    return m_inspector;
+}
+
+StreamController *MavlinkHandler::streams() const
+{
+    return m_streams;
+}
+
+MessageBus *MavlinkHandler::bus() const
+{
+    return m_bus;
+}
+
+bool MavlinkHandler::addUdpLink(const QString &ip, int port, int localPort)
+{
+    const QString name = QString("udp:%1").arg(localPort);
+    if (m_links->link(name)) {
+        return false;
+    }
+
+    const bool wasConnected = connected();
+    NetworkManager *link = new NetworkManager();
+    link->setLocalPort(quint16(localPort));
+    link->setSourceFilter(m_udpSourceFilter);
+    link->setConnectToPeer(m_udpConnectToPeer);
+    m_links->addLink(name, link);
+    link->connectToFC(ip, port);
+
+    if (!wasConnected && connected()) {
+        stopReplay();
+        startSession();
+    }
+    return link->connected();
+}
+
+bool MavlinkHandler::addSerialLink(const QString &portName, int baudRate)
+{
+    const QString name = QString("serial:%1").arg(portName);
+    if (m_links->link(name)) {
+        return false;
+    }
+
+    const bool wasConnected = connected();
+    SerialLink *link = new SerialLink();
+    m_links->addLink(name, link);
+    link->connectToPort(portName, baudRate);
+
+    if (!wasConnected && connected()) {
+        stopReplay();
+        startSession();
+    }
+    return link->connected();
+}
+
+void MavlinkHandler::removeLink(const QString &name)
+{
+    // Основной канал UDP управляется connectToFC/disconnectFromFC
+    if (name != "udp") {
+        m_links->removeLink(name);
+    }
+}
+
+bool MavlinkHandler::setUdpSourceFilter(const QString &spec)
+{
+    SourceFilter filter;
+    QString error;
+    if (!filter.parse(spec, &error)) {
+        qWarning() << "❌ Invalid UDP source filter:" << error;
+        return false;
+    }
+
+    m_udpSourceFilter = filter;
+    for (const QString &name : m_links->linkNames()) {
+        if (NetworkManager *link = qobject_cast<NetworkManager *>(m_links->link(name))) {
+            link->setSourceFilter(filter);
+        }
+    }
+    return true;
+}
+
+void MavlinkHandler::setUdpConnectToPeer(bool enabled)
+{
+    m_udpConnectToPeer = enabled;
+    for (const QString &name : m_links->linkNames()) {
+        if (NetworkManager *link = qobject_cast<NetworkManager *>(m_links->link(name))) {
+            link->setConnectToPeer(enabled);
+        }
+    }
+}
+
+bool MavlinkHandler::downloadFile(const QString &remotePath, const QString &localPath)
+{
+    if (!connected() || m_ftp->busy()) {
+        return false;
+    }
+
+    if (m_timeSync->isSynchronized(m_attitudeSysId)) {
+        m_ftp->setInitialRtt(m_timeSync->rttMs(m_attitudeSysId));
+    }
+    return m_ftp->download(m_attitudeSysId, 1, remotePath, localPath); // MAV_COMP_ID_AUTOPILOT1
+}
+
+bool MavlinkHandler::recording() const
+{
+    return m_archive.isOpen();
+}
+
+bool MavlinkHandler::replaying() const
+{
+    return m_replay != nullptr;
+}
+
+bool MavlinkHandler::startRecording(const QString &path)
+{
+    // Воспроизводимый архив повторно не записываем
+    if (m_replay) {
+        return false;
+    }
+
+    stopRecording();
+    m_archiveEpochUs = QDateTime::currentMSecsSinceEpoch() * 1000 - TimeSync::hostNowNs() / 1000;
+    if (!m_archive.open(path)) {
+        emit newMessage(QString("Cannot create flight archive: %1").arg(path));
+        return false;
+    }
+
+    emit recordingChanged(true);
+    emit newMessage(QString("Recording to %1").arg(path));
+    return true;
+}
+
+void MavlinkHandler::stopRecording()
+{
+    if (!m_archive.isOpen()) {
+        return;
+    }
+
+    const quint64 frames = m_archive.framesWritten();
+    m_archive.close();
+    emit recordingChanged(false);
+    emit newMessage(QString("Recording stopped: %1 frames").arg(frames));
+}
+
+bool MavlinkHandler::startReplay(const QString &path, double fromSeconds, double speed, const QList<int> &messageIds)
+{
+    stopReplay();
+    stopRecording();
+
+    auto *replay = new ArchiveReplay(this);
+    if (!replay->open(path)) {
+        delete replay;
+        emit newMessage(QString("Cannot open flight archive: %1").arg(path));
+        return false;
+    }
+
+    // Живой канал не смешиваем с архивом
+    disconnectFromFC();
+    m_buffer.resize(0);
+    m_lastSequence.clear();
+
+    QSet<quint32> filter;
+    for (int msgId : messageIds) {
+        filter.insert(quint32(msgId));
+    }
+    replay->setMessageFilter(filter);
+    replay->setSpeed(speed);
+    if (fromSeconds > 0.0) {
+        replay->seek(replay->startUs() + qint64(fromSeconds * 1000000));
+    }
+
+    m_replay = replay;
+    connect(m_replay, &MavlinkSource::dataReceived, this, &MavlinkHandler::onNetworkDataReceived);
+    connect(m_replay, &ArchiveReplay::finished, this, [this]() {
+        stopReplay();
+        emit newMessage("Replay finished");
+    });
+    m_replay->start();
+
+    emit replayingChanged(true);
+    emit newMessage(QString("Replaying %1").arg(path));
+    return true;
+}
+
+void MavlinkHandler::stopReplay()
+{
+    if (!m_replay) {
+        return;
+    }
+
+    m_replay->stop();
+    m_replay->deleteLater();
+    m_replay = nullptr;
+    m_buffer.resize(0);
+    emit replayingChanged(false);
+}
+
+QVariantMap MavlinkHandler::messageLatencies() const
+{
+    QVariantMap result;
+    const QHash<quint32, TimeSync::Latency> latencies = m_timeSync->latencies();
+    for (auto it = latencies.constBegin(); it != latencies.constEnd(); ++it) {
+        QVariantMap entry;
+        entry["last"] = it.value().lastMs;
+        entry["avg"] = it.value().avgMs;
+        entry["min"] = it.value().minMs;
+        entry["max"] = it.value().maxMs;
+        entry["samples"] = it.value().samples;
+        result[QString::number(it.key())] = entry;
+    }
+    return result;
+}
+
+// В методе parseAttitudeMessage добавляем подсчет частоты
+MavlinkAttitude MavlinkHandler::parseAttitudeMessage(const char *payload, int payloadLen)
+{
+    // MAVLink2 отбрасывает нулевые байты в конце payload - decode дополняет их нулями
+    const Mavlink::Attitude decoded = Mavlink::Attitude::decode(payload, payloadLen);
+    const double toDegrees = 180.0 / M_PI;
+    MavlinkAttitude attitude;
+    attitude.timestamp = decoded.timeBootMs;
+    attitude.roll = decoded.roll * toDegrees;
+    attitude.pitch = decoded.pitch * toDegrees;
+    attitude.yaw = decoded.yaw * toDegrees;
+    attitude.rollspeed = decoded.rollspeed * toDegrees;
+    attitude.pitchspeed = decoded.pitchspeed * toDegrees;
+    attitude.yawspeed = decoded.yawspeed * toDegrees;
+
+    // Подсчитываем частоту
+    m_attitudeCount++;
+
+    // Логируем только каждое 30-е сообщение чтобы не засорять консоль
+    if (m_attitudeCount % 30 == 0) {
+        qCDebug(lcMavlinkPackets) << "✅ ATTITUDE #" << m_attitudeCount << "roll=" << attitude.roll
+                 << "pitch=" << attitude.pitch << "yaw=" << attitude.yaw
+                 << "rates=" << attitude.rollspeed << attitude.pitchspeed << attitude.yawspeed
+                 << "freq=" << m_attitudeFrequency << "Hz";
     }
 
     return attitude;
@@ -315,55 +993,47 @@ MavlinkAttitude MavlinkHandler::parseAttitudeMessage(const QByteArray &data, int
 void MavlinkHandler::requestAttitudeStream()
 {
     // Запрашиваем ATTITUDE с частотой 30 Гц (33333 микросекунды)
-    QByteArray command;
-
-    // MAVLink 2.0 заголовок
-    command.append(char(0xFD)); // start byte
-    command.append(char(20));   // payload length
-    command.append(char(0));    // incompat flags
-    command.append(char(0));    // compat flags
-
-    static quint8 sequence = 0;
-    command.append(char(sequence++)); // sequence
-
-    command.append(char(0xFF)); // system ID (GCS)
-    command.append(char(0x01)); // component ID
-
-    // Message ID: 511 (MAV_CMD_SET_MESSAGE_INTERVAL)
-    command.append(char(0xFF)); // 511 = 0x01FF little endian
-    command.append(char(0x01));
-    command.append(char(0x00));
-
-    // Payload: message_id, interval_us, target_system, target_component
-    quint32 message_id = 30; // ATTITUDE
-    float interval_us = 33333.0f; // 30 Hz (33333 microseconds)
-    quint8 target_system = 1;
-    quint8 target_component = 1;
-
-    // Добавляем данные (little endian)
-    command.append(reinterpret_cast<const char*>(&message_id), 4);
-    command.append(reinterpret_cast<const char*>(&interval_us), 4);
-    command.append(target_system);
-    command.append(target_component);
-
-    // Заполняем остальные параметры нулями
-    for (int i = 0; i < 8; i++) {
-        command.append(char(0));
-    }
-
-    // Checksum (упрощённо)
-    command.append(char(0));
-    command.append(char(0));
-
-    m_networkManager->sendData(command);
+    requestAttitudeInterval(33333);
     qDebug() << "📡 Requested ATTITUDE stream at 30 Hz";
 
-    // Также отправляем команду для отключения оптимизации (если поддерживается)
+    // Также запрашиваем SYS_STATUS для поддержания активности
     sendStreamOptimizationCommand();
 
     emit newMessage("Requested ATTITUDE data stream at 30 Hz");
 }
 
+void MavlinkHandler::requestAttitudeInterval(qint32 intervalUs)
+{
+    // Пока нет своих замеров, таймауты считаются по RTT из TIMESYNC
+    if (m_timeSync->isSynchronized(m_attitudeSysId)) {
+        m_commands->setInitialRtt(m_timeSync->rttMs(m_attitudeSysId));
+    }
+
+    m_attitudeRequestsPending++;
+    m_commands->setMessageInterval(m_attitudeSysId, 1, Mavlink::MsgAttitude, intervalUs)
+        .then(this, [this, intervalUs](CommandResult result) {
+            m_attitudeRequestsPending--;
+            if (result.result == CommandResult::Cancelled) {
+                return;
+            }
+            m_attitudeStreamAccepted = result.accepted();
+            const QString rate = QString::number(1e6 / intervalUs, 'f', 0);
+            if (result.accepted()) {
+                qDebug() << "✅ ATTITUDE interval" << intervalUs << "us accepted, RTT" << result.rttMs << "ms";
+                emit newMessage(QString("Vehicle accepted ATTITUDE at %1 Hz").arg(rate));
+            } else {
+                emit newMessage(QString("ATTITUDE at %1 Hz: %2").arg(rate, result.resultName()));
+                // Прошивка без SET_MESSAGE_INTERVAL - частота ATTITUDE через SR1_EXTRA1
+                // (остальные потоки SR1 не трогаем). TEMPORARILY_REJECTED и таймаут
+                // повторяет ensureAttitudeStream.
+                if (result.result == ResultUnsupported || result.result == ResultDenied) {
+                    setParameter("SR1_EXTRA1", qRound(1e6 / intervalUs));
+                    emit newMessage(QString("Set ArduPilot param: SR1_EXTRA1=%1").arg(rate));
+                }
+            }
+        });
+}
+
 // void MavlinkHandler::requestAttitudeStream()
 // {
 //     // MAVLink команда для запроса потока данных
@@ -417,155 +1087,62 @@ void MavlinkHandler::requestAttitudeStream()
 // Добавляем метод для расчета частоты
 void MavlinkHandler::updateFrequency()
 {
-    m_attitudeFrequency = m_attitudeCount;
+    const qint64 elapsedMs = qMax<qint64>(1, m_frequencyClock.restart());
+    m_attitudeFrequency = qRound(m_attitudeCount * 1000.0 / elapsedMs);
     m_attitudeCount = 0;
+    m_attitudeFrequencyMetric->set(m_attitudeFrequency);
     emit attitudeFrequencyChanged(m_attitudeFrequency);
-
-    // Если частота низкая, увеличиваем счетчик повторных запросов
-    if (m_attitudeFrequency < 25 && connected()) {
-        m_retryCount++;
-        if (m_retryCount >= 3) {
-            qDebug() << "⚠️ Low attitude frequency (" << m_attitudeFrequency << "Hz), re-requesting stream...";
-            requestAttitudeStream();
-            m_retryCount = 0;
-        }
-    } else {
-        m_retryCount = 0;
-    }
+    emit latencyChanged();
 }
 
 void MavlinkHandler::ensureAttitudeStream()
 {
-    if (connected()) {
-        if (m_attitudeFrequency < 25) {
-            qDebug() << "🔄 Low frequency (" << m_attitudeFrequency << "Hz), re-requesting streams...";
-            requestAllStreams();
-
-            // Если частота очень низкая, попробуем более агрессивные настройки
-            if (m_attitudeFrequency < 10) {
-                qDebug() << "🚀 Very low frequency, enabling high rate mode";
-                enableHighRateMode();
-            }
-        }
+    // Включенный на ходу StreamController сам повторяет пропавшие потоки
+    if (!connected() || m_attitudeFrequency >= 25 || m_streams->enabled()) {
+        return;
     }
-}
-
-void MavlinkHandler::sendStreamOptimizationCommand()
-{
-    // Команда для отключения оптимизации потоков данных
-    // MAV_CMD_SET_MESSAGE_INTERVAL для других важных сообщений
-
-    // Запрашиваем также SYS_STATUS для поддержания активности
-    QByteArray sysStatusCommand;
-
-    sysStatusCommand.append(char(0xFD)); // start byte
-    sysStatusCommand.append(char(20));   // payload length
-    sysStatusCommand.append(char(0));    // incompat flags
-    sysStatusCommand.append(char(0));    // compat flags
-
-    static quint8 sequence = 0;
-    sysStatusCommand.append(char(sequence++)); // sequence
-
-    sysStatusCommand.append(char(0xFF)); // system ID (GCS)
-    sysStatusCommand.append(char(0x01)); // component ID
-
-    // Message ID: 511 (MAV_CMD_SET_MESSAGE_INTERVAL)
-    sysStatusCommand.append(char(0xFF)); // 511 = 0x01FF little endian
-    sysStatusCommand.append(char(0x01));
-    sysStatusCommand.append(char(0x00));
 
-    // Запрашиваем SYS_STATUS с частотой 5 Гц
-    quint32 sys_status_id = 1; // SYS_STATUS
-    float sys_status_interval = 200000.0f; // 5 Hz
-    quint8 target_system = 1;
-    quint8 target_component = 1;
-
-    sysStatusCommand.append(reinterpret_cast<const char*>(&sys_status_id), 4);
-    sysStatusCommand.append(reinterpret_cast<const char*>(&sys_status_interval), 4);
-    sysStatusCommand.append(target_system);
-    sysStatusCommand.append(target_component);
+    // Запрос еще ждет COMMAND_ACK (повторы ведет CommandManager)
+    if (m_attitudeRequestsPending > 0) {
+        return;
+    }
 
-    for (int i = 0; i < 8; i++) {
-        sysStatusCommand.append(char(0));
+    // Борт подтвердил интервал, а частота ниже: ее ограничивает канал или
+    // прошивка, повтор не поможет. Повторяем, только если поток почти
+    // пропал - перезагрузка борта сбрасывает интервалы.
+    if (m_attitudeStreamAccepted && m_attitudeFrequency >= 10) {
+        return;
     }
 
-    sysStatusCommand.append(char(0));
-    sysStatusCommand.append(char(0));
+    qDebug() << "🔄 Low frequency (" << m_attitudeFrequency << "Hz), re-requesting streams...";
+    requestAllStreams();
+}
 
-    m_networkManager->sendData(sysStatusCommand);
+void MavlinkHandler::sendStreamOptimizationCommand()
+{
+    // Запрашиваем также SYS_STATUS с частотой 5 Гц для поддержания активности
+    m_commands->setMessageInterval(m_attitudeSysId, 1, Mavlink::MsgSysStatus, 200000);
     qDebug() << "⚙️ Requested SYS_STATUS stream at 5 Hz to maintain connection";
 }
 
 void MavlinkHandler::setStreamRates(int attitudeHz, int sysStatusHz)
 {
-    qDebug() << "🔄 Setting stream rates - ATTITUDE:" << attitudeHz << "Hz, SYS_STATUS:" << sysStatusHz << "Hz";
-
-    // Устанавливаем частоту для ATTITUDE
-    QByteArray attitudeCommand;
-    attitudeCommand.append(char(0xFD));
-    attitudeCommand.append(char(20));
-    attitudeCommand.append(char(0));
-    attitudeCommand.append(char(0));
-
-    static quint8 sequence = 0;
-    attitudeCommand.append(char(sequence++));
-
-    attitudeCommand.append(char(0xFF));
-    attitudeCommand.append(char(0x01));
-    attitudeCommand.append(char(0xFF));
-    attitudeCommand.append(char(0x01));
-    attitudeCommand.append(char(0x00));
-
-    quint32 attitude_msg_id = 30;
-    float attitude_interval = 1000000.0f / attitudeHz; // Convert Hz to microseconds
-    quint8 target_system = 1;
-    quint8 target_component = 1;
-
-    attitudeCommand.append(reinterpret_cast<const char*>(&attitude_msg_id), 4);
-    attitudeCommand.append(reinterpret_cast<const char*>(&attitude_interval), 4);
-    attitudeCommand.append(target_system);
-    attitudeCommand.append(target_component);
-
-    for (int i = 0; i < 8; i++) {
-        attitudeCommand.append(char(0));
+    if (attitudeHz <= 0 || sysStatusHz <= 0) {
+        return;
     }
+    qDebug() << "🔄 Setting stream rates - ATTITUDE:" << attitudeHz << "Hz, SYS_STATUS:" << sysStatusHz << "Hz";
 
-    attitudeCommand.append(char(0));
-    attitudeCommand.append(char(0));
-
-    m_networkManager->sendData(attitudeCommand);
-
-    // Устанавливаем частоту для SYS_STATUS
-    QByteArray sysStatusCommand;
-    sysStatusCommand.append(char(0xFD));
-    sysStatusCommand.append(char(20));
-    sysStatusCommand.append(char(0));
-    sysStatusCommand.append(char(0));
-
-    sysStatusCommand.append(char(sequence++));
-
-    sysStatusCommand.append(char(0xFF));
-    sysStatusCommand.append(char(0x01));
-    sysStatusCommand.append(char(0xFF));
-    sysStatusCommand.append(char(0x01));
-    sysStatusCommand.append(char(0x00));
-
-    quint32 sys_status_msg_id = 1;
-    float sys_status_interval = 1000000.0f / sysStatusHz;
-
-    sysStatusCommand.append(reinterpret_cast<const char*>(&sys_status_msg_id), 4);
-    sysStatusCommand.append(reinterpret_cast<const char*>(&sys_status_interval), 4);
-    sysStatusCommand.append(target_system);
-    sysStatusCommand.append(target_component);
-
-    for (int i = 0; i < 8; i++) {
-        sysStatusCommand.append(char(0));
+    if (m_streams->enabled()) {
+        // Верхние границы; фактические частоты - по бюджету канала
+        m_streams->setMaxRate(Mavlink::MsgAttitude, attitudeHz);
+        m_streams->setMaxRate(Mavlink::MsgSysStatus, sysStatusHz);
+        emit newMessage(QString("Stream limits: ATTITUDE=%1Hz, SYS_STATUS=%2Hz").arg(attitudeHz).arg(sysStatusHz));
+        return;
     }
 
-    sysStatusCommand.append(char(0));
-    sysStatusCommand.append(char(0));
-
-    m_networkManager->sendData(sysStatusCommand);
+    // Интервалы в микросекундах; результат ATTITUDE приходит в newMessage
+    requestAttitudeInterval(qRound(1000000.0 / attitudeHz));
+    m_commands->setMessageInterval(m_attitudeSysId, 1, Mavlink::MsgSysStatus, qRound(1000000.0 / sysStatusHz));
 
     emit newMessage(QString("Set stream rates: ATTITUDE=%1Hz, SYS_STATUS=%2Hz").arg(attitudeHz).arg(sysStatusHz));
 }
@@ -585,41 +1162,18 @@ void MavlinkHandler::setArduPilotParameters(int sr1_ext_stat, int sr1_extra1, in
 
 void MavlinkHandler::setParameter(const QString &paramName, float value)
 {
-    QByteArray paramSet;
-
-    paramSet.append(char(0xFD));
-    paramSet.append(char(25));
-    paramSet.append(char(0));
-    paramSet.append(char(0));
-
-    static quint8 sequence = 0;
-    paramSet.append(char(sequence++));
-
-    paramSet.append(char(0xFF));
-    paramSet.append(char(0x01));
-    paramSet.append(char(0x17));
-    paramSet.append(char(0x00));
-    paramSet.append(char(0x00));
-
-    paramSet.append(char(0x01));
-    paramSet.append(char(0x01));
-
-    // Parameter ID (16 bytes)
-    QByteArray paramId = paramName.toUtf8();
-    paramId.resize(16);
-    paramSet.append(paramId);
-
-    // Parameter value
-    paramSet.append(reinterpret_cast<const char*>(&value), 4);
-
-    // Parameter type (MAV_PARAM_TYPE_REAL32 = 9)
-    paramSet.append(char(9));
-
-    // Checksum
-    paramSet.append(char(0));
-    paramSet.append(char(0));
-
-    m_networkManager->sendData(paramSet);
+    // PARAM_SET, 23 байта: param_value, target_system, target_component,
+    // param_id[16] (без завершающего нуля при длине 16), param_type
+    QByteArray payload;
+    Mavlink::appendField<float>(payload, value);
+    payload.append(char(m_attitudeSysId));
+    payload.append(char(1)); // MAV_COMP_ID_AUTOPILOT1
+    QByteArray paramId = paramName.toLatin1();
+    paramId.resize(16, '\0');
+    payload.append(paramId);
+    payload.append(char(9)); // MAV_PARAM_TYPE_REAL32
+
+    sendFrame(Mavlink::packMessage(Mavlink::MsgParamSet, payload));
 
     qDebug() << "📝 Set parameter" << paramName << "to" << value;
 }
@@ -628,14 +1182,19 @@ void MavlinkHandler::enableHighRateMode()
 {
     qDebug() << "🚀 Enabling high rate mode";
 
-    // Aggressive stream rates
-    setStreamRates(50, 10); // 50 Hz attitude, 10 Hz sys_status
-
-    // Set ArduPilot parameters for high rates
-    setArduPilotParameters(10, 50, 20, 10); // High rates for all streams
-
-    // Request multiple data streams
-    requestAllStreams();
+    // Aggressive stream rates: 50 Hz attitude, 10 Hz for the rest.
+    // С контроллером это только верхние границы: параметры SRx_ подняли бы
+    // все потоки SR1 сразу, в обход бюджета канала
+    if (m_streams->enabled()) {
+        m_streams->setMaxRate(Mavlink::MsgAttitude, 50);
+        for (quint32 msgId : {Mavlink::MsgSysStatus, Mavlink::MsgGlobalPositionInt, Mavlink::MsgVfrHud}) {
+            m_streams->setMaxRate(msgId, 10);
+        }
+    } else {
+        // Set ArduPilot parameters for high rates
+        setArduPilotParameters(10, 50, 20, 10); // High rates for all streams
+        requestAllStreams(20000);
+    }
 
     emit newMessage("Enabled high rate mode (50Hz ATTITUDE)");
 }
@@ -645,52 +1204,25 @@ void MavlinkHandler::resetStreamingToDefaults()
     qDebug() << "🔄 Resetting streaming to defaults";
 
     setStreamRates(30, 5);
-    setArduPilotParameters(5, 10, 5, 2);
+    if (!m_streams->enabled()) {
+        setArduPilotParameters(5, 10, 5, 2);
+    }
 
     emit newMessage("Reset streaming to defaults");
 }
 
-void MavlinkHandler::requestAllStreams()
+void MavlinkHandler::requestAllStreams(qint32 attitudeIntervalUs)
 {
-    // Request multiple data streams to ensure constant data flow
-    QVector<uint32_t> streamIds = {30, 1, 33, 74}; // ATTITUDE, SYS_STATUS, GLOBAL_POSITION, VFR_HUD
-
-    foreach (uint32_t streamId, streamIds) {
-        QByteArray command;
-        command.append(char(0xFD));
-        command.append(char(20));
-        command.append(char(0));
-        command.append(char(0));
-
-        static quint8 sequence = 0;
-        command.append(char(sequence++));
-
-        command.append(char(0xFF));
-        command.append(char(0x01));
-        command.append(char(0xFF));
-        command.append(char(0x01));
-        command.append(char(0x00));
-
-        float interval = 100000.0f; // 10 Hz for other streams
-
-        if (streamId == 30) { // ATTITUDE gets higher rate
-            interval = 33333.0f; // 30 Hz
-        }
-
-        command.append(reinterpret_cast<const char*>(&streamId), 4);
-        command.append(reinterpret_cast<const char*>(&interval), 4);
-        command.append(char(0x01)); // target_system
-        command.append(char(0x01)); // target_component
-
-        for (int i = 0; i < 8; i++) {
-            command.append(char(0));
-        }
-
-        command.append(char(0));
-        command.append(char(0));
-
-        m_networkManager->sendData(command);
+    // ATTITUDE (по умолчанию 30 Гц), остальные потоки 10 Гц
+    requestAttitudeInterval(attitudeIntervalUs);
+    for (quint32 msgId : {Mavlink::MsgSysStatus, Mavlink::MsgGlobalPositionInt, Mavlink::MsgVfrHud}) {
+        m_commands->setMessageInterval(m_attitudeSysId, 1, msgId, 100000);
     }
 
     qDebug() << "📡 Requested multiple data streams";
 }
+
+void MavlinkHandler::sendMavlinkCommand(uint16_t command, const QVector<float> &params)
+{
+    m_commands->sendCommandLong(m_attitudeSysId, 1, command, params);
+}
@@ -2,50 +2,137 @@
 #define MAVLINKHANDLER_H
 
 #include <QObject>
-#include <QTimer>
+#include <QtQml/qqmlregistration.h>
+#include <QElapsedTimer>
+#include <QVariantMap>
 #include "networkmanager.h"
+#include "linkmanager.h"
+#include "mavlinksigning.h"
+#include "timesync.h"
+#include "scheduler.h"
+#include "metrics.h"
+#include "missiontransfer.h"
+#include "commandmanager.h"
+#include "ftpclient.h"
+#include "flightarchive.h"
+#include "messageinspector.h"
+#include "streamcontroller.h"
+#include "messagebus.h"
+
+class ArchiveReplay;
 
 // Simple MAVLink structures
 struct MavlinkAttitude {
     Q_GADGET
+    QML_VALUE_TYPE(mavlinkAttitude)
     Q_PROPERTY(double roll MEMBER roll)
     Q_PROPERTY(double pitch MEMBER pitch)
     Q_PROPERTY(double yaw MEMBER yaw)
+    Q_PROPERTY(double rollspeed MEMBER rollspeed)
+    Q_PROPERTY(double pitchspeed MEMBER pitchspeed)
+    Q_PROPERTY(double yawspeed MEMBER yawspeed)
     Q_PROPERTY(quint32 timestamp MEMBER timestamp)
+    Q_PROPERTY(qint64 hostTimestamp MEMBER hostTimestamp)
 
 public:
     double roll = 0.0;
     double pitch = 0.0;
     double yaw = 0.0;
-    quint32 timestamp = 0;
+    double rollspeed = 0.0;     // угловые скорости в осях корпуса, град/с
+    double pitchspeed = 0.0;
+    double yawspeed = 0.0;
+    quint32 timestamp = 0;      // time_boot_ms борта
+    qint64 hostTimestamp = 0;   // то же время в Unix ms хоста (0 - нет синхронизации)
 };
 
 Q_DECLARE_METATYPE(MavlinkAttitude)
 
+class QQmlEngine;
+class QJSEngine;
+
 class MavlinkHandler : public QObject
 {
     Q_OBJECT
+    QML_ELEMENT
+    QML_SINGLETON
 
 public:
     explicit MavlinkHandler(QObject *parent = nullptr);
     ~MavlinkHandler();
 
+    // Экземпляр приложения, который QML получает как singleton.
+    // Типизированный доступ позволяет qmlcachegen компилировать привязки в C++.
+    static void setInstance(MavlinkHandler *handler);
+    static MavlinkHandler *create(QQmlEngine *qmlEngine, QJSEngine *jsEngine);
+
     Q_PROPERTY(bool connected READ connected NOTIFY connectedChanged)
     Q_PROPERTY(QString status READ status NOTIFY statusChanged)
     Q_PROPERTY(MavlinkAttitude attitude READ attitude NOTIFY attitudeChanged)
+    Q_PROPERTY(MavlinkAttitude displayAttitude READ displayAttitude NOTIFY displayAttitudeChanged)
+    Q_PROPERTY(bool predictionEnabled READ predictionEnabled WRITE setPredictionEnabled NOTIFY predictionEnabledChanged)
+    Q_PROPERTY(double predictionMs READ predictionMs NOTIFY displayAttitudeChanged)
     Q_PROPERTY(QString rawData READ rawData NOTIFY rawDataChanged)
     Q_PROPERTY(int attitudeFrequency READ attitudeFrequency NOTIFY attitudeFrequencyChanged)
+    Q_PROPERTY(bool signingEnabled READ signingEnabled NOTIFY signingEnabledChanged)
+    Q_PROPERTY(double attitudeLatency READ attitudeLatency NOTIFY latencyChanged)
+    Q_PROPERTY(QVariantMap messageLatencies READ messageLatencies NOTIFY latencyChanged)
+    Q_PROPERTY(bool timeSynchronized READ timeSynchronized NOTIFY timeSynchronizedChanged)
+    Q_PROPERTY(MissionTransfer *mission READ mission CONSTANT)
+    Q_PROPERTY(CommandManager *commands READ commands CONSTANT)
+    Q_PROPERTY(FtpClient *ftp READ ftp CONSTANT)
+    Q_PROPERTY(LinkManager *links READ links CONSTANT)
+    Q_PROPERTY(MessageInspector *inspector READ inspector CONSTANT)
+    Q_PROPERTY(StreamController *streams READ streams CONSTANT)
+    Q_PROPERTY(bool recording READ recording NOTIFY recordingChanged)
+    Q_PROPERTY(bool replaying READ replaying NOTIFY replayingChanged)
 
     bool connected() const;
     QString status() const;
     MavlinkAttitude attitude() const;
+    MavlinkAttitude displayAttitude() const;
+    bool predictionEnabled() const;
+    void setPredictionEnabled(bool enabled);
+    double predictionMs() const;
     QString rawData() const;
     int attitudeFrequency() const;
+    bool signingEnabled() const;
+    double attitudeLatency() const;
+    QVariantMap messageLatencies() const;
+    bool timeSynchronized() const;
+    MissionTransfer *mission() const;
+    CommandManager *commands() const;
+    FtpClient *ftp() const;
+    LinkManager *links() const;
+    MessageInspector *inspector() const;
+    StreamController *streams() const;
+
+    // Декодированные сообщения для компонентов приложения (см. MessageBus)
+    MessageBus *bus() const;
+    bool recording() const;
+    bool replaying() const;
+
+    // Байты "как из канала" мимо сокета: датаграмма основного UDP-канала,
+    // дальше тем же путем (LinkManager -> разбор). Прогон в --alloc-benchmark.
+    void feedData(const QByteArray &data);
+
+    // Кадры с верной CRC, дошедшие до разбора (v1 + v2)
+    quint64 framesParsed() const;
 
 public slots:
     void connectToFC(const QString &ip, int port = 5760);
     void disconnectFromFC();
     void clearData();
+
+    // Резервные каналы к тому же борту: прием со всех сразу без повторов,
+    // отправка через самый здоровый (см. LinkManager)
+    bool addUdpLink(const QString &ip, int port, int localPort);
+    bool addSerialLink(const QString &portName, int baudRate = 57600);
+    void removeLink(const QString &name);
+
+    // Разрешенные источники для всех UDP-каналов (формат SourceFilter,
+    // пусто - по умолчанию) и connect() сокета к борту. С нового подключения.
+    bool setUdpSourceFilter(const QString &spec);
+    void setUdpConnectToPeer(bool enabled);
     void requestAttitudeStream();
 
     // Новые методы для настройки параметров
@@ -54,13 +141,48 @@ public slots:
     void enableHighRateMode();
     void resetStreamingToDefaults();
 
+    // Подпись MAVLink2
+    void setSigningPassphrase(const QString &passphrase);
+    void setSigningKeyHex(const QString &hexKey);
+    void disableSigning();
+    void setAcceptUnsignedMessages(bool accept);
+
+    // Миссия: скачивание в файл QGC WPL 110 и выгрузка из него
+    bool downloadMission(const QString &path);
+    bool uploadMission(const QString &path);
+
+    // MAVLink FTP: скачивание файла с борта (логи, параметры, terrain)
+    bool downloadFile(const QString &remotePath, const QString &localPath);
+
+    // Архив полета: запись принятых кадров и воспроизведение вместо канала.
+    // messageIds - только эти сообщения (пусто - все), speed <= 0 - без пауз.
+    bool startRecording(const QString &path);
+    void stopRecording();
+    bool startReplay(const QString &path, double fromSeconds = 0.0, double speed = 1.0,
+                     const QList<int> &messageIds = QList<int>());
+    void stopReplay();
+
+    // Вызывается после вывода кадра на экран (QQuickWindow::frameSwapped)
+    void notifyFrameRendered();
+
+    // Вызывается перед синхронизацией кадра (QQuickWindow::afterAnimating):
+    // при включенном прогнозе displayAttitude экстраполируется к выводу кадра
+    void updateDisplayAttitude();
+
 signals:
     void connectedChanged(bool connected);
     void statusChanged(const QString &status);
     void attitudeChanged(const MavlinkAttitude &attitude);
+    void displayAttitudeChanged();
+    void predictionEnabledChanged(bool enabled);
     void rawDataChanged(const QString &rawData);
     void newMessage(const QString &message);
     void attitudeFrequencyChanged(int frequency);
+    void signingEnabledChanged(bool enabled);
+    void latencyChanged();
+    void timeSynchronizedChanged();
+    void recordingChanged(bool recording);
+    void replayingChanged(bool replaying);
 
 private slots:
     void onNetworkDataReceived(const QByteArray &data);
@@ -70,27 +192,97 @@ private slots:
     void ensureAttitudeStream();
 
 private:
+    void startSession();
     void parseMavlinkMessage(const QByteArray &data);
-    MavlinkAttitude parseAttitudeMessage(const QByteArray &data, int startPos);
+    void handleMessage(const QByteArray &data, int payloadPos, int payloadLen,
+                       quint8 sysid, quint8 compid, quint32 msgId, qint64 rxNs);
+    MavlinkAttitude parseAttitudeMessage(const char *payload, int payloadLen);
+    MavlinkAttitude predictAttitude(double horizonMs) const;
     void sendStreamOptimizationCommand();
+    void requestAttitudeInterval(qint32 intervalUs);
+    void sendFrame(QByteArray frame);
+    bool checkFrameSignature(const char *frame, int frameLen, bool isSigned, quint32 msgId);
+    void countFrame(quint8 sysid, quint8 compid, quint8 seq, quint32 msgId);
 
     // Новые методы для работы с параметрами
     void setParameter(const QString &paramName, float value);
-    void requestAllStreams();
+    void requestAllStreams(qint32 attitudeIntervalUs = 33333);
     void sendMavlinkCommand(uint16_t command, const QVector<float> &params);
 
-    NetworkManager *m_networkManager;
+    LinkManager *m_links;
+    NetworkManager *m_networkManager;   // основной канал UDP ("udp")
+    SourceFilter m_udpSourceFilter;
+    bool m_udpConnectToPeer;
     MavlinkAttitude m_currentAttitude;
-    QString m_rawData;
+    QByteArray m_lastDatagram; // для rawData, null - еще ничего не принято
     QByteArray m_buffer;
+    MavlinkSigning m_signing;
 
     // Для подсчета частоты
-    QTimer *m_frequencyTimer;
-    QTimer *m_streamRequestTimer;
+    QElapsedTimer m_frequencyClock;
     int m_attitudeCount;
     int m_attitudeFrequency;
-    int m_retryCount;
     qint64 m_lastAttitudeTime;
+
+    // Задачи общего планировщика
+    Scheduler::TaskId m_frequencyTask;
+    Scheduler::TaskId m_streamStartTask;
+    Scheduler::TaskId m_streamRequestTask;
+
+    // Синхронизация часов и задержка канала
+    TimeSync *m_timeSync;
+    quint8 m_attitudeSysId;
+    bool m_attitudePendingDisplay;
+    double m_attitudeLatency;
+
+    // Прогноз ориентации к моменту вывода кадра
+    bool m_predictionEnabled;
+    MavlinkAttitude m_displayAttitude;
+    qint64 m_attitudeSampleNs;  // момент измерения m_currentAttitude на часах хоста
+    double m_predictionMs;
+    double m_frameIntervalMs;   // сглаженный период вывода кадров
+    qint64 m_lastSwapNs;
+
+    // Команды с подтверждением COMMAND_ACK
+    CommandManager *m_commands;
+    int m_attitudeRequestsPending;  // SET_MESSAGE_INTERVAL для ATTITUDE без ответа
+    bool m_attitudeStreamAccepted;  // борт подтвердил интервал ATTITUDE
+
+    // Протокол миссий
+    MissionTransfer *m_mission;
+    QString m_missionPath;
+
+    // MAVLink FTP
+    FtpClient *m_ftp;
+
+    // Частота и полоса по типам сообщений
+    MessageInspector *m_inspector;
+
+    // Частоты потоков в пределах полосы канала
+    StreamController *m_streams;
+
+    // Подписки на принятые сообщения
+    MessageBus *m_bus;
+
+    // Архив полета
+    FlightArchive::Writer m_archive;
+    qint64 m_archiveEpochUs;    // Unix мкс минус монотонное время хоста
+    ArchiveReplay *m_replay;
+
+    // Метрики канала и парсера (выгружаются через MetricsServer)
+    Metrics::Counter *m_framesV1Metric;
+    Metrics::Counter *m_framesV2Metric;
+    Metrics::Counter *m_crcFailuresMetric;
+    Metrics::Counter *m_unsignedRejectsMetric;
+    Metrics::Counter *m_badSignatureMetric;
+    Metrics::Counter *m_replayRejectsMetric;
+    Metrics::Counter *m_sequenceGapsMetric;
+    Metrics::Counter *m_messagesLostMetric;
+    Metrics::Gauge *m_bufferBytesMetric;
+    Metrics::Gauge *m_attitudeFrequencyMetric;
+    Metrics::Timing *m_parseTimeMetric;
+    QHash<quint32, Metrics::Counter *> m_messageMetrics;
+    QHash<quint16, quint8> m_lastSequence; // (sysid << 8 | compid) -> seq
 };
 
 #endif // MAVLINKHANDLER_H
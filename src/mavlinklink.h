@@ -0,0 +1,33 @@
+#ifndef MAVLINKLINK_H
+#define MAVLINKLINK_H
+
+#include "mavlinksource.h"
+#include <QString>
+
+// Канал связи с бортом: источник байтов MAVLink, через который можно и
+// отправлять (UDP - NetworkManager, последовательный порт - SerialLink).
+// Несколько каналов к одному борту одновременно объединяет LinkManager.
+class MavlinkLink : public MavlinkSource
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool connected READ connected NOTIFY connectedChanged)
+    Q_PROPERTY(QString status READ status NOTIFY statusChanged)
+
+public:
+    using MavlinkSource::MavlinkSource;
+
+    virtual bool connected() const = 0;
+    virtual QString status() const = 0;
+
+public slots:
+    virtual void sendData(const QByteArray &data) = 0;
+    virtual void disconnectFromFC() = 0;
+
+signals:
+    void connectedChanged(bool connected);
+    void statusChanged(const QString &status);
+    void errorOccurred(const QString &error);
+};
+
+#endif // MAVLINKLINK_H
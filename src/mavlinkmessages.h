@@ -0,0 +1,168 @@
+#ifndef MAVLINKMESSAGES_H
+#define MAVLINKMESSAGES_H
+
+#include "mavlinkprotocol.h"
+
+// Декодированные сообщения для MessageBus: POD в единицах протокола
+// (радианы, мм, сантиградусы), поля по common.xml. Смещения - по
+// порядку полей в кадре (сначала широкие), недостающие байты обрезанного
+// MAVLink2 payload читаются как нули.
+namespace Mavlink {
+
+struct Heartbeat {
+    static constexpr quint32 Id = MsgHeartbeat;
+
+    quint32 customMode = 0;
+    quint8 type = 0;
+    quint8 autopilot = 0;
+    quint8 baseMode = 0;
+    quint8 systemStatus = 0;
+    quint8 mavlinkVersion = 0;
+
+    static Heartbeat decode(const char *payload, int payloadLen)
+    {
+        Heartbeat m;
+        m.customMode = readField<quint32>(payload, payloadLen, 0);
+        m.type = readField<quint8>(payload, payloadLen, 4);
+        m.autopilot = readField<quint8>(payload, payloadLen, 5);
+        m.baseMode = readField<quint8>(payload, payloadLen, 6);
+        m.systemStatus = readField<quint8>(payload, payloadLen, 7);
+        m.mavlinkVersion = readField<quint8>(payload, payloadLen, 8);
+        return m;
+    }
+};
+
+struct SysStatus {
+    static constexpr quint32 Id = MsgSysStatus;
+
+    quint32 sensorsPresent = 0;
+    quint32 sensorsEnabled = 0;
+    quint32 sensorsHealth = 0;
+    quint16 load = 0;               // 0.1 %
+    quint16 voltageBattery = 0;     // мВ
+    qint16 currentBattery = 0;      // 10 мА, -1 - нет данных
+    quint16 dropRateComm = 0;       // 0.01 %
+    quint16 errorsComm = 0;
+    qint8 batteryRemaining = 0;     // %, -1 - нет данных
+
+    static SysStatus decode(const char *payload, int payloadLen)
+    {
+        SysStatus m;
+        m.sensorsPresent = readField<quint32>(payload, payloadLen, 0);
+        m.sensorsEnabled = readField<quint32>(payload, payloadLen, 4);
+        m.sensorsHealth = readField<quint32>(payload, payloadLen, 8);
+        m.load = readField<quint16>(payload, payloadLen, 12);
+        m.voltageBattery = readField<quint16>(payload, payloadLen, 14);
+        m.currentBattery = readField<qint16>(payload, payloadLen, 16);
+        m.dropRateComm = readField<quint16>(payload, payloadLen, 18);
+        m.errorsComm = readField<quint16>(payload, payloadLen, 20);
+        m.batteryRemaining = readField<qint8>(payload, payloadLen, 30);
+        return m;
+    }
+};
+
+struct Attitude {
+    static constexpr quint32 Id = MsgAttitude;
+
+    quint32 timeBootMs = 0;
+    float roll = 0.0f;              // рад
+    float pitch = 0.0f;
+    float yaw = 0.0f;
+    float rollspeed = 0.0f;         // рад/с, в осях корпуса
+    float pitchspeed = 0.0f;
+    float yawspeed = 0.0f;
+
+    static Attitude decode(const char *payload, int payloadLen)
+    {
+        Attitude m;
+        m.timeBootMs = readField<quint32>(payload, payloadLen, 0);
+        m.roll = readField<float>(payload, payloadLen, 4);
+        m.pitch = readField<float>(payload, payloadLen, 8);
+        m.yaw = readField<float>(payload, payloadLen, 12);
+        m.rollspeed = readField<float>(payload, payloadLen, 16);
+        m.pitchspeed = readField<float>(payload, payloadLen, 20);
+        m.yawspeed = readField<float>(payload, payloadLen, 24);
+        return m;
+    }
+};
+
+struct GlobalPositionInt {
+    static constexpr quint32 Id = MsgGlobalPositionInt;
+
+    quint32 timeBootMs = 0;
+    qint32 lat = 0;                 // 1e-7 град
+    qint32 lon = 0;
+    qint32 alt = 0;                 // мм над уровнем моря
+    qint32 relativeAlt = 0;         // мм над точкой взлета
+    qint16 vx = 0;                  // см/с, NED
+    qint16 vy = 0;
+    qint16 vz = 0;
+    quint16 hdg = 0;                // сантиградусы, 65535 - нет данных
+
+    static GlobalPositionInt decode(const char *payload, int payloadLen)
+    {
+        GlobalPositionInt m;
+        m.timeBootMs = readField<quint32>(payload, payloadLen, 0);
+        m.lat = readField<qint32>(payload, payloadLen, 4);
+        m.lon = readField<qint32>(payload, payloadLen, 8);
+        m.alt = readField<qint32>(payload, payloadLen, 12);
+        m.relativeAlt = readField<qint32>(payload, payloadLen, 16);
+        m.vx = readField<qint16>(payload, payloadLen, 20);
+        m.vy = readField<qint16>(payload, payloadLen, 22);
+        m.vz = readField<qint16>(payload, payloadLen, 24);
+        m.hdg = readField<quint16>(payload, payloadLen, 26);
+        return m;
+    }
+};
+
+struct VfrHud {
+    static constexpr quint32 Id = MsgVfrHud;
+
+    float airspeed = 0.0f;          // м/с
+    float groundspeed = 0.0f;
+    float alt = 0.0f;               // м
+    float climb = 0.0f;             // м/с
+    qint16 heading = 0;             // град
+    quint16 throttle = 0;           // %
+
+    static VfrHud decode(const char *payload, int payloadLen)
+    {
+        VfrHud m;
+        m.airspeed = readField<float>(payload, payloadLen, 0);
+        m.groundspeed = readField<float>(payload, payloadLen, 4);
+        m.alt = readField<float>(payload, payloadLen, 8);
+        m.climb = readField<float>(payload, payloadLen, 12);
+        m.heading = readField<qint16>(payload, payloadLen, 16);
+        m.throttle = readField<quint16>(payload, payloadLen, 18);
+        return m;
+    }
+};
+
+struct RadioStatus {
+    static constexpr quint32 Id = MsgRadioStatus;
+
+    quint16 rxErrors = 0;
+    quint16 fixed = 0;
+    quint8 rssi = 0;
+    quint8 remoteRssi = 0;
+    quint8 txBuffer = 0;            // % свободного буфера модема
+    quint8 noise = 0;
+    quint8 remoteNoise = 0;
+
+    static RadioStatus decode(const char *payload, int payloadLen)
+    {
+        RadioStatus m;
+        m.rxErrors = readField<quint16>(payload, payloadLen, 0);
+        m.fixed = readField<quint16>(payload, payloadLen, 2);
+        m.rssi = readField<quint8>(payload, payloadLen, 4);
+        m.remoteRssi = readField<quint8>(payload, payloadLen, 5);
+        m.txBuffer = readField<quint8>(payload, payloadLen, 6);
+        m.noise = readField<quint8>(payload, payloadLen, 7);
+        m.remoteNoise = readField<quint8>(payload, payloadLen, 8);
+        return m;
+    }
+};
+
+} // namespace Mavlink
+
+#endif // MAVLINKMESSAGES_H
@@ -0,0 +1,245 @@
+#include "mavlinkprotocol.h"
+#include <atomic>
+
+Q_LOGGING_CATEGORY(lcMavlinkPackets, "mavlink.packets")
+
+namespace Mavlink {
+
+namespace {
+
+struct CrcExtraEntry {
+    quint32 msgId;
+    quint8 extra;
+    const char *name;
+};
+
+// Отсортировано по msgId для бинарного поиска
+const CrcExtraEntry CrcExtraTable[] = {
+    {0, 50, "HEARTBEAT"},
+    {1, 124, "SYS_STATUS"},
+    {2, 137, "SYSTEM_TIME"},
+    {20, 214, "PARAM_REQUEST_READ"},
+    {21, 159, "PARAM_REQUEST_LIST"},
+    {22, 220, "PARAM_VALUE"},
+    {23, 168, "PARAM_SET"},
+    {24, 24, "GPS_RAW_INT"},
+    {27, 144, "RAW_IMU"},
+    {29, 115, "SCALED_PRESSURE"},
+    {30, 39, "ATTITUDE"},
+    {31, 246, "ATTITUDE_QUATERNION"},
+    {32, 185, "LOCAL_POSITION_NED"},
+    {33, 104, "GLOBAL_POSITION_INT"},
+    {36, 222, "SERVO_OUTPUT_RAW"},
+    {39, 254, "MISSION_ITEM"},
+    {40, 230, "MISSION_REQUEST"},
+    {41, 28, "MISSION_SET_CURRENT"},
+    {42, 28, "MISSION_CURRENT"},
+    {43, 132, "MISSION_REQUEST_LIST"},
+    {44, 221, "MISSION_COUNT"},
+    {45, 232, "MISSION_CLEAR_ALL"},
+    {46, 11, "MISSION_ITEM_REACHED"},
+    {47, 153, "MISSION_ACK"},
+    {51, 196, "MISSION_REQUEST_INT"},
+    {62, 183, "NAV_CONTROLLER_OUTPUT"},
+    {65, 118, "RC_CHANNELS"},
+    {66, 148, "REQUEST_DATA_STREAM"},
+    {73, 38, "MISSION_ITEM_INT"},
+    {74, 20, "VFR_HUD"},
+    {75, 158, "COMMAND_INT"},
+    {76, 152, "COMMAND_LONG"},
+    {77, 143, "COMMAND_ACK"},
+    {109, 185, "RADIO_STATUS"},
+    {110, 84, "FILE_TRANSFER_PROTOCOL"},
+    {111, 34, "TIMESYNC"},
+    {118, 56, "LOG_ENTRY"},
+    {119, 116, "LOG_REQUEST_DATA"},
+    {120, 134, "LOG_DATA"},
+    {147, 154, "BATTERY_STATUS"},
+    {148, 178, "AUTOPILOT_VERSION"},
+    {242, 104, "HOME_POSITION"},
+    {244, 95, "MESSAGE_INTERVAL"},
+    {245, 130, "EXTENDED_SYS_STATE"},
+    {253, 83, "STATUSTEXT"},
+};
+
+std::atomic<quint8> txSequence{0};
+
+const CrcExtraEntry *findEntry(quint32 msgId)
+{
+    int lo = 0;
+    int hi = int(sizeof(CrcExtraTable) / sizeof(CrcExtraTable[0])) - 1;
+
+    while (lo <= hi) {
+        const int mid = (lo + hi) / 2;
+        if (CrcExtraTable[mid].msgId == msgId) {
+            return &CrcExtraTable[mid];
+        }
+        if (CrcExtraTable[mid].msgId < msgId) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+quint16 crcAccumulate(quint8 byte, quint16 crc)
+{
+    quint8 tmp = byte ^ static_cast<quint8>(crc & 0xFF);
+    tmp ^= static_cast<quint8>(tmp << 4);
+    return static_cast<quint16>((crc >> 8) ^ (quint16(tmp) << 8) ^ (quint16(tmp) << 3) ^ (tmp >> 4));
+}
+
+quint16 crcCalculate(const char *data, int len, quint16 crc)
+{
+    for (int i = 0; i < len; ++i) {
+        crc = crcAccumulate(static_cast<quint8>(data[i]), crc);
+    }
+    return crc;
+}
+
+bool crcExtra(quint32 msgId, quint8 *extra)
+{
+    const CrcExtraEntry *entry = findEntry(msgId);
+    if (!entry) {
+        return false;
+    }
+    *extra = entry->extra;
+    return true;
+}
+
+const char *messageName(quint32 msgId)
+{
+    const CrcExtraEntry *entry = findEntry(msgId);
+    return entry ? entry->name : nullptr;
+}
+
+bool finalizeFrame(QByteArray &frame)
+{
+    if (frame.size() < HeaderLenV1 + ChecksumLen) {
+        return false;
+    }
+
+    const quint8 stx = static_cast<quint8>(frame[0]);
+    const int payloadLen = static_cast<quint8>(frame[1]);
+    int headerLen = 0;
+    quint32 msgId = 0;
+
+    if (stx == StxV2 && frame.size() >= HeaderLenV2 + ChecksumLen) {
+        headerLen = HeaderLenV2;
+        msgId = static_cast<quint8>(frame[7])
+              | (quint32(static_cast<quint8>(frame[8])) << 8)
+              | (quint32(static_cast<quint8>(frame[9])) << 16);
+    } else if (stx == StxV1) {
+        headerLen = HeaderLenV1;
+        msgId = static_cast<quint8>(frame[5]);
+    } else {
+        return false;
+    }
+
+    const int crcPos = headerLen + payloadLen;
+    quint8 extra = 0;
+    if (crcPos + ChecksumLen > frame.size() || !crcExtra(msgId, &extra)) {
+        return false;
+    }
+
+    quint16 crc = crcCalculate(frame.constData() + 1, crcPos - 1);
+    crc = crcAccumulate(extra, crc);
+    frame[crcPos] = char(crc & 0xFF);
+    frame[crcPos + 1] = char((crc >> 8) & 0xFF);
+    return true;
+}
+
+CrcCheck checkFrameCrc(const char *frame, int headerLen, int payloadLen, quint32 msgId)
+{
+    quint8 extra = 0;
+    if (!crcExtra(msgId, &extra)) {
+        return CrcCheck::Unknown;
+    }
+
+    const int crcPos = headerLen + payloadLen;
+    quint16 crc = crcCalculate(frame + 1, crcPos - 1);
+    crc = crcAccumulate(extra, crc);
+    const quint16 received = quint16(static_cast<quint8>(frame[crcPos]))
+                           | quint16(static_cast<quint8>(frame[crcPos + 1]) << 8);
+    return crc == received ? CrcCheck::Ok : CrcCheck::Bad;
+}
+
+FrameStatus parseFrame(const char *data, int available, FrameInfo *frame)
+{
+    if (available < 1) {
+        return FrameStatus::Incomplete;
+    }
+
+    const quint8 stx = static_cast<quint8>(data[0]);
+    if (stx == StxV2) {
+        if (available < HeaderLenV2) {
+            return FrameStatus::Incomplete;
+        }
+        const quint8 incompatFlags = static_cast<quint8>(data[2]);
+        // Неизвестные incompat флаги - кадр разобрать нельзя
+        if (incompatFlags & ~IncompatFlagSigned) {
+            return FrameStatus::NotFrame;
+        }
+        frame->version = 2;
+        frame->isSigned = incompatFlags & IncompatFlagSigned;
+        frame->payloadLen = static_cast<quint8>(data[1]);
+        frame->seq = static_cast<quint8>(data[4]);
+        frame->sysid = static_cast<quint8>(data[5]);
+        frame->compid = static_cast<quint8>(data[6]);
+        frame->msgId = quint32(static_cast<quint8>(data[7]))
+                     | quint32(static_cast<quint8>(data[8])) << 8
+                     | quint32(static_cast<quint8>(data[9])) << 16;
+        frame->headerLen = HeaderLenV2;
+        frame->length = HeaderLenV2 + frame->payloadLen + ChecksumLen + (frame->isSigned ? SignatureLen : 0);
+    } else if (stx == StxV1) {
+        if (available < HeaderLenV1) {
+            return FrameStatus::Incomplete;
+        }
+        frame->version = 1;
+        frame->isSigned = false;
+        frame->payloadLen = static_cast<quint8>(data[1]);
+        frame->seq = static_cast<quint8>(data[2]);
+        frame->sysid = static_cast<quint8>(data[3]);
+        frame->compid = static_cast<quint8>(data[4]);
+        frame->msgId = static_cast<quint8>(data[5]);
+        frame->headerLen = HeaderLenV1;
+        frame->length = HeaderLenV1 + frame->payloadLen + ChecksumLen;
+    } else {
+        return FrameStatus::NotFrame;
+    }
+
+    if (available < frame->length) {
+        return FrameStatus::Incomplete;
+    }
+
+    frame->crc = checkFrameCrc(data, frame->headerLen, frame->payloadLen, frame->msgId);
+    return frame->crc == CrcCheck::Bad ? FrameStatus::BadCrc : FrameStatus::Ok;
+}
+
+QByteArray packMessage(quint32 msgId, const QByteArray &payload, quint8 sysId, quint8 compId)
+{
+    QByteArray frame;
+    frame.reserve(HeaderLenV2 + payload.size() + ChecksumLen + SignatureLen);
+
+    frame.append(char(StxV2));
+    frame.append(char(payload.size()));
+    frame.append(char(0)); // incompat flags
+    frame.append(char(0)); // compat flags
+    frame.append(char(txSequence.fetch_add(1, std::memory_order_relaxed)));
+    frame.append(char(sysId));
+    frame.append(char(compId));
+    frame.append(char(msgId & 0xFF));
+    frame.append(char((msgId >> 8) & 0xFF));
+    frame.append(char((msgId >> 16) & 0xFF));
+    frame.append(payload);
+    frame.append(char(0));
+    frame.append(char(0));
+
+    finalizeFrame(frame);
+    return frame;
+}
+
+} // namespace Mavlink
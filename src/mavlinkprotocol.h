@@ -0,0 +1,132 @@
+#ifndef MAVLINKPROTOCOL_H
+#define MAVLINKPROTOCOL_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QLoggingCategory>
+#include <cstring>
+
+// Отладочный вывод по каждому пакету и кадру ("mavlink.packets").
+// Аргументы qCDebug не вычисляются, если категория выключена, поэтому
+// выключенный вывод не стоит ни строк, ни выделений памяти.
+Q_DECLARE_LOGGING_CATEGORY(lcMavlinkPackets)
+
+// Общие константы и контрольная сумма MAVLink (X.25 CRC + CRC_EXTRA)
+namespace Mavlink {
+
+constexpr quint8 StxV1 = 0xFE;
+constexpr quint8 StxV2 = 0xFD;
+
+constexpr int HeaderLenV1 = 6;
+constexpr int HeaderLenV2 = 10;
+constexpr int ChecksumLen = 2;
+constexpr int SignatureLen = 13; // link_id (1) + timestamp (6) + signature (6)
+
+constexpr quint8 IncompatFlagSigned = 0x01;
+
+// Message IDs
+constexpr quint32 MsgHeartbeat = 0;
+constexpr quint32 MsgSysStatus = 1;
+constexpr quint32 MsgParamSet = 23;
+constexpr quint32 MsgScaledPressure = 29;
+constexpr quint32 MsgAttitude = 30;
+constexpr quint32 MsgAttitudeQuaternion = 31;
+constexpr quint32 MsgLocalPositionNed = 32;
+constexpr quint32 MsgGlobalPositionInt = 33;
+constexpr quint32 MsgRcChannels = 65;
+constexpr quint32 MsgVfrHud = 74;
+constexpr quint32 MsgRadioStatus = 109;
+constexpr quint32 MsgTimesync = 111;
+
+// Идентификатор наземной станции в исходящих кадрах
+constexpr quint8 GcsSystemId = 0xFF;
+constexpr quint8 GcsComponentId = 0x01;
+
+quint16 crcAccumulate(quint8 byte, quint16 crc);
+quint16 crcCalculate(const char *data, int len, quint16 crc = 0xFFFF);
+
+// CRC_EXTRA для известных сообщений common/ardupilotmega.
+// Возвращает false, если сообщение неизвестно.
+bool crcExtra(quint32 msgId, quint8 *extra);
+
+// Имя известного сообщения ("ATTITUDE") или nullptr
+const char *messageName(quint32 msgId);
+
+// Пересчитывает контрольную сумму готового кадра (v1 или v2, без подписи).
+// Возвращает false, если CRC_EXTRA для сообщения неизвестен.
+bool finalizeFrame(QByteArray &frame);
+
+// Результат проверки CRC принятого кадра
+enum class CrcCheck {
+    Ok,
+    Bad,
+    Unknown // CRC_EXTRA сообщения неизвестен, проверить нельзя
+};
+
+// frame указывает на STX, кадр целиком в буфере
+CrcCheck checkFrameCrc(const char *frame, int headerLen, int payloadLen, quint32 msgId);
+
+// Заголовок кадра, найденного во входном потоке
+struct FrameInfo {
+    quint8 version = 0;         // 1 или 2
+    bool isSigned = false;
+    quint8 payloadLen = 0;
+    quint8 seq = 0;
+    quint8 sysid = 0;
+    quint8 compid = 0;
+    quint32 msgId = 0;
+    int headerLen = 0;
+    int length = 0;             // кадр целиком: заголовок, payload, CRC и подпись
+    CrcCheck crc = CrcCheck::Unknown;
+};
+
+enum class FrameStatus {
+    Ok,         // кадр целиком в буфере, CRC верна (или сообщение неизвестно)
+    Incomplete, // начало кадра, остальные байты еще не пришли
+    BadCrc,     // ложный стартовый байт или поврежденный кадр
+    NotFrame    // не стартовый байт или неизвестные incompat-флаги
+};
+
+// Разбор кадра, начинающегося с data[0]. Общий для MavlinkHandler
+// и пакетного анализатора логов.
+FrameStatus parseFrame(const char *data, int available, FrameInfo *frame);
+
+// Собирает кадр MAVLink 2.0 с корректной CRC.
+// Номер последовательности берется из общего счетчика исходящих кадров.
+QByteArray packMessage(quint32 msgId, const QByteArray &payload,
+                       quint8 sysId = GcsSystemId, quint8 compId = GcsComponentId);
+
+// Чтение поля little endian из payload. MAVLink 2.0 обрезает нулевые байты
+// в конце payload, поэтому поля за пределами payloadLen считаются нулевыми.
+template <typename T>
+T readField(const char *payload, int payloadLen, int offset)
+{
+    unsigned char raw[sizeof(T)] = {};
+    const int available = payloadLen - offset;
+    if (available > 0) {
+        memcpy(raw, payload + offset, available < int(sizeof(T)) ? available : sizeof(T));
+    }
+    T value;
+    memcpy(&value, raw, sizeof(T));
+    return value; // все поддерживаемые платформы little endian
+}
+
+// Число кадров, пропущенных между номерами последовательности last и seq.
+// Сравнение по арифметике серийных номеров (RFC 1982): seq не дальше
+// половины круга впереди. Повтор (seq == last) или опоздавший кадр дает -1 -
+// это не потеря, и last обновлять не нужно.
+inline int sequenceGap(quint8 last, quint8 seq)
+{
+    const quint8 gap = quint8(seq - last - 1);
+    return gap < 128 ? int(gap) : -1;
+}
+
+template <typename T>
+void appendField(QByteArray &payload, T value)
+{
+    payload.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+} // namespace Mavlink
+
+#endif // MAVLINKPROTOCOL_H
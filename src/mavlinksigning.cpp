@@ -0,0 +1,198 @@
+#include "mavlinksigning.h"
+#include "mavlinkprotocol.h"
+#include "sha256.h"
+#include <QDateTime>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+// 01.01.2015 00:00:00 UTC в миллисекундах Unix-времени
+constexpr qint64 SigningEpochMs = 1420070400000LL;
+
+// Допустимое отставание timestamp нового потока: 1 минута в единицах 10 мкс
+constexpr quint64 StaleWindow = 60ULL * 100000ULL;
+
+quint64 readTimestamp48(const char *p)
+{
+    quint64 value = 0;
+    for (int i = 5; i >= 0; --i) {
+        value = (value << 8) | static_cast<quint8>(p[i]);
+    }
+    return value;
+}
+
+} // namespace
+
+MavlinkSigning::MavlinkSigning()
+    : m_hasKey(false)
+    , m_linkId(0)
+    , m_acceptUnsigned(false)
+    , m_timestamp(0)
+    , m_signatureFailures(0)
+    , m_replayRejections(0)
+{
+    memset(m_key, 0, sizeof(m_key));
+}
+
+bool MavlinkSigning::setKey(const QByteArray &key)
+{
+    if (key.size() != int(sizeof(m_key))) {
+        qDebug() << "❌ Signing key must be 32 bytes, got" << key.size();
+        return false;
+    }
+
+    memcpy(m_key, key.constData(), sizeof(m_key));
+    m_hasKey = true;
+    m_streamTimestamps.clear();
+    qDebug() << "🔐 MAVLink signing enabled, SHA-256 backend:" << Sha256::backendName();
+    return true;
+}
+
+void MavlinkSigning::setPassphrase(const QString &passphrase)
+{
+    const QByteArray utf8 = passphrase.toUtf8();
+    quint8 digest[Sha256::DigestSize];
+    Sha256::hash(utf8.constData(), size_t(utf8.size()), digest);
+    setKey(QByteArray(reinterpret_cast<const char *>(digest), Sha256::DigestSize));
+}
+
+void MavlinkSigning::clearKey()
+{
+    memset(m_key, 0, sizeof(m_key));
+    m_hasKey = false;
+    m_streamTimestamps.clear();
+}
+
+bool MavlinkSigning::hasKey() const
+{
+    return m_hasKey;
+}
+
+void MavlinkSigning::setLinkId(quint8 linkId)
+{
+    m_linkId = linkId;
+}
+
+quint8 MavlinkSigning::linkId() const
+{
+    return m_linkId;
+}
+
+void MavlinkSigning::setAcceptUnsigned(bool accept)
+{
+    m_acceptUnsigned = accept;
+}
+
+bool MavlinkSigning::acceptUnsigned() const
+{
+    return m_acceptUnsigned;
+}
+
+bool MavlinkSigning::acceptsUnsignedMessage(quint32 msgId) const
+{
+    // RADIO_STATUS генерирует сам радиомодем, он не может его подписать
+    return !m_hasKey || m_acceptUnsigned || msgId == Mavlink::MsgRadioStatus;
+}
+
+quint64 MavlinkSigning::nextTimestamp()
+{
+    const quint64 now = quint64(QDateTime::currentMSecsSinceEpoch() - SigningEpochMs) * 100;
+    m_timestamp = qMax(m_timestamp + 1, now);
+    return m_timestamp;
+}
+
+void MavlinkSigning::computeSignature(const char *data, int len, quint8 signature[6]) const
+{
+    Sha256 sha;
+    sha.update(m_key, sizeof(m_key));
+    sha.update(data, size_t(len));
+
+    quint8 digest[Sha256::DigestSize];
+    sha.finish(digest);
+    memcpy(signature, digest, 6);
+}
+
+bool MavlinkSigning::signFrame(QByteArray &frame)
+{
+    if (!m_hasKey || frame.size() < Mavlink::HeaderLenV2 + Mavlink::ChecksumLen
+        || static_cast<quint8>(frame[0]) != Mavlink::StxV2) {
+        return false;
+    }
+
+    const int unsignedLen = Mavlink::HeaderLenV2 + static_cast<quint8>(frame[1]) + Mavlink::ChecksumLen;
+    if (frame.size() != unsignedLen) {
+        return false;
+    }
+
+    frame[2] = char(static_cast<quint8>(frame[2]) | Mavlink::IncompatFlagSigned);
+    Mavlink::finalizeFrame(frame);
+
+    const quint64 timestamp = nextTimestamp();
+    char trailer[7];
+    trailer[0] = char(m_linkId);
+    for (int i = 0; i < 6; ++i) {
+        trailer[1 + i] = char((timestamp >> (8 * i)) & 0xFF);
+    }
+    frame.append(trailer, sizeof(trailer));
+
+    quint8 signature[6];
+    computeSignature(frame.constData(), frame.size(), signature);
+    frame.append(reinterpret_cast<const char *>(signature), sizeof(signature));
+    return true;
+}
+
+MavlinkSigning::Result MavlinkSigning::verifyFrame(const char *frame, int frameLen)
+{
+    if (!m_hasKey) {
+        return Result::NoKey;
+    }
+
+    const char *trailer = frame + frameLen - Mavlink::SignatureLen;
+    quint8 expected[6];
+    computeSignature(frame, frameLen - 6, expected);
+
+    // Сравнение без раннего выхода
+    quint8 diff = 0;
+    for (int i = 0; i < 6; ++i) {
+        diff |= expected[i] ^ static_cast<quint8>(trailer[7 + i]);
+    }
+    if (diff != 0) {
+        m_signatureFailures++;
+        return Result::BadSignature;
+    }
+
+    const quint8 linkId = static_cast<quint8>(trailer[0]);
+    const quint64 timestamp = readTimestamp48(trailer + 1);
+    const quint32 stream = (quint32(static_cast<quint8>(frame[5])) << 16)
+                         | (quint32(static_cast<quint8>(frame[6])) << 8)
+                         | linkId;
+
+    auto it = m_streamTimestamps.find(stream);
+    if (it == m_streamTimestamps.end()) {
+        if (timestamp + StaleWindow < m_timestamp) {
+            m_replayRejections++;
+            return Result::Stale;
+        }
+        m_streamTimestamps.insert(stream, timestamp);
+    } else {
+        if (timestamp <= it.value()) {
+            m_replayRejections++;
+            return Result::Replay;
+        }
+        it.value() = timestamp;
+    }
+
+    m_timestamp = qMax(m_timestamp, timestamp);
+    return Result::Ok;
+}
+
+quint64 MavlinkSigning::signatureFailures() const
+{
+    return m_signatureFailures;
+}
+
+quint64 MavlinkSigning::replayRejections() const
+{
+    return m_replayRejections;
+}
@@ -0,0 +1,67 @@
+#ifndef MAVLINKSIGNING_H
+#define MAVLINKSIGNING_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+// Подпись кадров MAVLink2 (incompat_flags & 0x01).
+// signature = SHA-256(secret_key + header + payload + CRC + link_id + timestamp)[0..5]
+class MavlinkSigning
+{
+public:
+    enum class Result {
+        Ok,
+        NoKey,
+        BadSignature,
+        Replay,     // timestamp не больше последнего для этого потока
+        Stale       // новый поток с timestamp старше окна в 1 минуту
+    };
+
+    MavlinkSigning();
+
+    // Ключ - 32 байта. Пароль преобразуется в ключ через SHA-256 (как в MAVProxy/QGC)
+    bool setKey(const QByteArray &key);
+    void setPassphrase(const QString &passphrase);
+    void clearKey();
+    bool hasKey() const;
+
+    void setLinkId(quint8 linkId);
+    quint8 linkId() const;
+
+    void setAcceptUnsigned(bool accept);
+    bool acceptUnsigned() const;
+
+    // Можно ли принять неподписанное сообщение при включенной подписи
+    bool acceptsUnsignedMessage(quint32 msgId) const;
+
+    // frame - готовый неподписанный кадр MAVLink2 (header + payload + CRC).
+    // Выставляет флаг подписи, пересчитывает CRC и дописывает 13 байт подписи.
+    bool signFrame(QByteArray &frame);
+
+    // frame указывает на начало подписанного кадра, frameLen включает подпись
+    Result verifyFrame(const char *frame, int frameLen);
+
+    quint64 signatureFailures() const;
+    quint64 replayRejections() const;
+
+private:
+    quint64 nextTimestamp();
+    void computeSignature(const char *data, int len, quint8 signature[6]) const;
+
+    quint8 m_key[32];
+    bool m_hasKey;
+    quint8 m_linkId;
+    bool m_acceptUnsigned;
+
+    // Локальное время подписи в единицах 10 мкс с 01.01.2015
+    quint64 m_timestamp;
+
+    // Последний timestamp для потока (sysid, compid, link_id)
+    QHash<quint32, quint64> m_streamTimestamps;
+
+    quint64 m_signatureFailures;
+    quint64 m_replayRejections;
+};
+
+#endif // MAVLINKSIGNING_H
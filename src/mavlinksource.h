@@ -0,0 +1,21 @@
+#ifndef MAVLINKSOURCE_H
+#define MAVLINKSOURCE_H
+
+#include <QObject>
+#include <QByteArray>
+
+// Источник байтов MAVLink для MavlinkHandler: UDP-канал (NetworkManager)
+// или воспроизведение архива полета (ArchiveReplay).
+// Данные приходят блоками произвольной длины, кадры могут быть разрезаны.
+class MavlinkSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    using QObject::QObject;
+
+signals:
+    void dataReceived(const QByteArray &data);
+};
+
+#endif // MAVLINKSOURCE_H
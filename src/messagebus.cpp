@@ -0,0 +1,191 @@
+#include "messagebus.h"
+#include <algorithm>
+
+namespace {
+
+using RawHandler = std::function<void(const MessageEnvelope &, const RawMessage &)>;
+
+std::function<void(const MessageEnvelope &, const void *)> rawDelivery(QObject *context, RawHandler handler,
+                                                                       MessageBus::Delivery delivery)
+{
+    if (delivery == MessageBus::Direct) {
+        return [handler](const MessageEnvelope &envelope, const void *decoded) {
+            handler(envelope, *static_cast<const RawMessage *>(decoded));
+        };
+    }
+
+    // Буфер приема к моменту доставки уже переиспользован - payload копируется
+    QPointer<QObject> guard(context);
+    return [handler, guard](const MessageEnvelope &envelope, const void *decoded) {
+        if (!guard) {
+            return;
+        }
+        const RawMessage *raw = static_cast<const RawMessage *>(decoded);
+        const QByteArray payload(raw->payload, raw->length);
+        QMetaObject::invokeMethod(guard.data(), [handler, envelope, payload]() {
+            RawMessage copy;
+            copy.payload = payload.constData();
+            copy.length = int(payload.size());
+            handler(envelope, copy);
+        }, Qt::QueuedConnection);
+    };
+}
+
+} // namespace
+
+MessageBus::MessageBus(QObject *parent)
+    : QObject(parent)
+    , m_flags(IndexSize, 0)
+    , m_catchAll(0)
+    , m_publishing(0)
+    , m_dirty(false)
+    , m_nextId(0)
+{
+}
+
+MessageBus::~MessageBus()
+{
+}
+
+MessageBus::SubscriptionId MessageBus::subscribeRaw(quint32 msgId, QObject *context, RawHandler handler,
+                                                    Delivery delivery, quint8 sysid)
+{
+    Q_ASSERT(delivery == Direct || context);
+    Subscriber subscriber;
+    subscriber.msgId = msgId;
+    subscriber.sysid = sysid;
+    subscriber.context = context;
+    subscriber.hasContext = context != nullptr;
+    subscriber.deliver = rawDelivery(context, std::move(handler), delivery);
+    return add(std::move(subscriber));
+}
+
+MessageBus::SubscriptionId MessageBus::subscribeAll(QObject *context, RawHandler handler,
+                                                    Delivery delivery, quint8 sysid)
+{
+    Q_ASSERT(delivery == Direct || context);
+    Subscriber subscriber;
+    subscriber.all = true;
+    subscriber.sysid = sysid;
+    subscriber.context = context;
+    subscriber.hasContext = context != nullptr;
+    subscriber.deliver = rawDelivery(context, std::move(handler), delivery);
+    return add(std::move(subscriber));
+}
+
+MessageBus::SubscriptionId MessageBus::add(Subscriber subscriber)
+{
+    const SubscriptionId id = ++m_nextId;
+    subscriber.id = id;
+    if (subscriber.hasContext) {
+        subscriber.contextDestroyed = connect(subscriber.context.data(), &QObject::destroyed, this,
+                                              [this, id]() { unsubscribe(id); });
+    }
+
+    if (subscriber.all) {
+        m_catchAll++;
+    } else {
+        m_flags[subscriber.msgId & (IndexSize - 1)] = 1;
+    }
+
+    // Во время доставки список не меняется - новые подписки ждут ее конца
+    if (m_publishing > 0) {
+        m_added.push_back(std::move(subscriber));
+        m_dirty = true;
+    } else {
+        m_subscribers.push_back(std::move(subscriber));
+    }
+    return id;
+}
+
+void MessageBus::unsubscribe(SubscriptionId id)
+{
+    for (std::vector<Subscriber> *list : {&m_subscribers, &m_added}) {
+        for (Subscriber &subscriber : *list) {
+            if (subscriber.id == id && !subscriber.removed) {
+                // Иначе у долгоживущего context копятся соединения снятых подписок
+                disconnect(subscriber.contextDestroyed);
+                subscriber.removed = true;
+                m_dirty = true;
+                if (m_publishing == 0) {
+                    compact();
+                }
+                return;
+            }
+        }
+    }
+}
+
+int MessageBus::subscriberCount() const
+{
+    int count = 0;
+    for (const std::vector<Subscriber> *list : {&m_subscribers, &m_added}) {
+        for (const Subscriber &subscriber : *list) {
+            count += subscriber.removed ? 0 : 1;
+        }
+    }
+    return count;
+}
+
+void MessageBus::publish(const MessageEnvelope &envelope, const char *payload, int payloadLen)
+{
+    // Структура декодируется один раз для всех подписчиков этого типа
+    alignas(std::max_align_t) char decoded[MaxDecodedSize];
+    DecodeFn decodedWith = nullptr;
+    RawMessage raw;
+    raw.payload = payload;
+    raw.length = payloadLen;
+
+    m_publishing++;
+    const size_t count = m_subscribers.size();
+    for (size_t i = 0; i < count; i++) {
+        const Subscriber &subscriber = m_subscribers[i];
+        if (subscriber.removed || (subscriber.hasContext && !subscriber.context)
+            || (!subscriber.all && subscriber.msgId != envelope.msgId)
+            || (subscriber.sysid != AnySystem && subscriber.sysid != envelope.sysid)) {
+            continue;
+        }
+        if (!subscriber.decode) {
+            subscriber.deliver(envelope, &raw);
+            continue;
+        }
+        if (subscriber.decode != decodedWith) {
+            subscriber.decode(payload, payloadLen, decoded);
+            decodedWith = subscriber.decode;
+        }
+        subscriber.deliver(envelope, decoded);
+    }
+    m_publishing--;
+
+    if (m_publishing == 0 && m_dirty) {
+        compact();
+    }
+}
+
+void MessageBus::compact()
+{
+    m_subscribers.erase(std::remove_if(m_subscribers.begin(), m_subscribers.end(),
+                                       [](const Subscriber &subscriber) { return subscriber.removed; }),
+                        m_subscribers.end());
+    for (Subscriber &subscriber : m_added) {
+        if (!subscriber.removed) {
+            m_subscribers.push_back(std::move(subscriber));
+        }
+    }
+    m_added.clear();
+    m_dirty = false;
+    rebuildFlags();
+}
+
+void MessageBus::rebuildFlags()
+{
+    m_flags.fill(0);
+    m_catchAll = 0;
+    for (const Subscriber &subscriber : m_subscribers) {
+        if (subscriber.all) {
+            m_catchAll++;
+        } else {
+            m_flags[subscriber.msgId & (IndexSize - 1)] = 1;
+        }
+    }
+}
@@ -0,0 +1,157 @@
+#ifndef MESSAGEBUS_H
+#define MESSAGEBUS_H
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Откуда и когда пришло сообщение
+struct MessageEnvelope {
+    quint8 sysid = 0;
+    quint8 compid = 0;
+    quint32 msgId = 0;
+    qint64 rxNs = 0;    // монотонное время хоста (TimeSync::hostNowNs)
+};
+
+// Payload без декодирования; в режиме Direct указывает в буфер приема
+// и действителен только на время вызова
+struct RawMessage {
+    const char *payload = nullptr;
+    int length = 0;
+};
+
+// Шина декодированных сообщений внутри приложения.
+// Подписка - на тип из mavlinkmessages.h (по его Id) или на сырые кадры
+// одного msgid / всех сообщений, с фильтром по борту. Подписчик получает
+// const-ссылку на структуру, декодированную один раз на кадр для всех
+// подписчиков этого msgid.
+//
+// Direct - вызов сразу в потоке приема, без копий; Queued - копия
+// структуры (для сырых - payload) уходит в очередь событий потока context.
+// Сообщения без подписчиков отсекаются одной проверкой флага по msgid,
+// без декодирования и поиска.
+//
+// Подписка и отписка - из потока шины; из других потоков через
+// QMetaObject::invokeMethod. Подписка снимается сама при удалении context.
+class MessageBus : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Delivery {
+        Direct,
+        Queued
+    };
+
+    using SubscriptionId = quint64;
+
+    static constexpr quint8 AnySystem = 0;  // sysid 0 - широковещательный, источником не бывает
+    static constexpr int IndexSize = 0x10000;
+
+    explicit MessageBus(QObject *parent = nullptr);
+    ~MessageBus();
+
+    // T - структура из mavlinkmessages.h: T::Id и static T decode(payload, len)
+    template <typename T>
+    SubscriptionId subscribe(QObject *context,
+                             std::function<void(const MessageEnvelope &, const T &)> handler,
+                             Delivery delivery = Direct, quint8 sysid = AnySystem);
+
+    SubscriptionId subscribeRaw(quint32 msgId, QObject *context,
+                                std::function<void(const MessageEnvelope &, const RawMessage &)> handler,
+                                Delivery delivery = Direct, quint8 sysid = AnySystem);
+
+    // Все сообщения (например, от одного борта)
+    SubscriptionId subscribeAll(QObject *context,
+                                std::function<void(const MessageEnvelope &, const RawMessage &)> handler,
+                                Delivery delivery = Direct, quint8 sysid = AnySystem);
+
+    void unsubscribe(SubscriptionId id);
+    int subscriberCount() const;
+
+    // Горячий путь приема: без подписчиков - только эта проверка
+    bool hasSubscribers(quint32 msgId) const
+    {
+        return m_catchAll > 0 || m_flags[msgId & (IndexSize - 1)] != 0;
+    }
+
+    void publish(const MessageEnvelope &envelope, const char *payload, int payloadLen);
+
+private:
+    static constexpr int MaxDecodedSize = 64;
+
+    // Декодирование в буфер и доставка; decoded - структура типа подписки
+    // или RawMessage для сырых подписок
+    using DecodeFn = void (*)(const char *payload, int payloadLen, void *out);
+    using DeliverFn = std::function<void(const MessageEnvelope &, const void *decoded)>;
+
+    struct Subscriber {
+        SubscriptionId id = 0;
+        quint32 msgId = 0;
+        bool all = false;           // subscribeAll
+        quint8 sysid = AnySystem;
+        DecodeFn decode = nullptr;  // nullptr - сырые данные
+        DeliverFn deliver;
+        QPointer<QObject> context;
+        bool hasContext = false;    // без context подписка живет до unsubscribe
+        QMetaObject::Connection contextDestroyed;
+        bool removed = false;       // отписан во время доставки
+    };
+
+    template <typename T>
+    static void decodeInto(const char *payload, int payloadLen, void *out)
+    {
+        *static_cast<T *>(out) = T::decode(payload, payloadLen);
+    }
+
+    SubscriptionId add(Subscriber subscriber);
+    void rebuildFlags();
+    void compact();
+
+    std::vector<Subscriber> m_subscribers;  // в порядке подписки
+    std::vector<Subscriber> m_added;        // подписки во время доставки
+    QVector<quint8> m_flags;                // msgid & 0xFFFF -> есть подписчики
+    int m_catchAll;
+    int m_publishing;
+    bool m_dirty;
+    SubscriptionId m_nextId;
+};
+
+template <typename T>
+MessageBus::SubscriptionId MessageBus::subscribe(QObject *context,
+                                                 std::function<void(const MessageEnvelope &, const T &)> handler,
+                                                 Delivery delivery, quint8 sysid)
+{
+    static_assert(sizeof(T) <= MaxDecodedSize && alignof(T) <= alignof(std::max_align_t),
+                  "decoded message does not fit the dispatch buffer");
+
+    Subscriber subscriber;
+    subscriber.msgId = T::Id;
+    subscriber.sysid = sysid;
+    subscriber.decode = &MessageBus::decodeInto<T>;
+    subscriber.context = context;
+    subscriber.hasContext = context != nullptr;
+    Q_ASSERT(delivery == Direct || context);
+    if (delivery == Direct) {
+        subscriber.deliver = [handler](const MessageEnvelope &envelope, const void *decoded) {
+            handler(envelope, *static_cast<const T *>(decoded));
+        };
+    } else {
+        QPointer<QObject> guard(context);
+        subscriber.deliver = [handler, guard](const MessageEnvelope &envelope, const void *decoded) {
+            if (!guard) {
+                return;
+            }
+            const T copy = *static_cast<const T *>(decoded);
+            QMetaObject::invokeMethod(guard.data(), [handler, envelope, copy]() {
+                handler(envelope, copy);
+            }, Qt::QueuedConnection);
+        };
+    }
+    return add(std::move(subscriber));
+}
+
+#endif // MESSAGEBUS_H
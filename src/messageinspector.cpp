@@ -0,0 +1,246 @@
+#include "messageinspector.h"
+#include "mavlinkprotocol.h"
+#include "timesync.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+MessageInspector::MessageInspector(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_index(IndexSize, -1)
+    , m_totalRate(0.0)
+    , m_totalBandwidth(0.0)
+    , m_lastRefreshNs(TimeSync::hostNowNs())
+    , m_refreshTask(0)
+{
+    m_entries.reserve(128);
+    m_refreshTask = Scheduler::instance()->scheduleRepeating(RefreshIntervalMs, this, [this]() {
+        refresh();
+    }, RefreshIntervalMs / 10);
+}
+
+MessageInspector::~MessageInspector()
+{
+    Scheduler::instance()->cancel(m_refreshTask);
+}
+
+void MessageInspector::record(quint8 sysid, quint8 compid, quint32 msgId, const char *payload, int payloadLen,
+                              int frameLen, qint64 rxNs)
+{
+    const quint16 source = quint16(sysid) << 8 | compid;
+    qint32 i = find(source, msgId);
+    if (i < 0) {
+        // Новый тип от этого компонента - в модели появится на ближайшем обновлении
+        qint32 &head = m_index[int(msgId & (IndexSize - 1))];
+        Entry entry;
+        entry.source = source;
+        entry.msgId = msgId;
+        entry.next = head;
+        i = qint32(m_entries.size());
+        m_entries.append(entry);
+        head = i;
+    }
+
+    Entry &entry = m_entries[i];
+    entry.count++;
+    entry.bytes += quint64(frameLen);
+    entry.lastRxNs = rxNs;
+    entry.payloadLen = quint8(qBound(0, payloadLen, int(sizeof(entry.payload))));
+    std::memcpy(entry.payload, payload, entry.payloadLen);
+}
+
+qint32 MessageInspector::find(quint16 source, quint32 msgId) const
+{
+    qint32 i = m_index[int(msgId & (IndexSize - 1))];
+    while (i >= 0 && (m_entries[i].source != source || m_entries[i].msgId != msgId)) {
+        i = m_entries[i].next;
+    }
+    return i;
+}
+
+MessageInspector::Stats MessageInspector::stats(quint8 sysid, quint8 compid, quint32 msgId) const
+{
+    Stats stats;
+    const qint32 i = find(quint16(sysid) << 8 | compid, msgId);
+    if (i >= 0) {
+        const Entry &entry = m_entries[i];
+        stats.count = entry.count;
+        stats.rateHz = entry.rateHz;
+        stats.bytesPerSec = entry.bytesPerSec;
+        stats.frameBytes = entry.count > 0 ? double(entry.bytes) / double(entry.count) : 0.0;
+    }
+    return stats;
+}
+
+void MessageInspector::clear()
+{
+    beginResetModel();
+    m_index.fill(-1);
+    m_entries.clear();
+    m_rows.clear();
+    m_totalRate = 0.0;
+    m_totalBandwidth = 0.0;
+    endResetModel();
+    emit refreshed();
+}
+
+void MessageInspector::refresh()
+{
+    const qint64 nowNs = TimeSync::hostNowNs();
+    const double dt = double(nowNs - m_lastRefreshNs) / 1e9;
+    if (dt <= 0.0) {
+        return;
+    }
+    m_lastRefreshNs = nowNs;
+
+    // EWMA с постоянной времени, не зависящей от фактического периода таймера
+    const double alpha = 1.0 - std::exp(-dt / RateTimeConstantS);
+    m_totalRate = 0.0;
+    m_totalBandwidth = 0.0;
+    for (Entry &entry : m_entries) {
+        const double rate = double(entry.count - entry.refreshedCount) / dt;
+        const double bandwidth = double(entry.bytes - entry.refreshedBytes) / dt;
+        entry.refreshedCount = entry.count;
+        entry.refreshedBytes = entry.bytes;
+        if (entry.rateValid) {
+            entry.rateHz += alpha * (rate - entry.rateHz);
+            entry.bytesPerSec += alpha * (bandwidth - entry.bytesPerSec);
+        } else {
+            entry.rateHz = rate;
+            entry.bytesPerSec = bandwidth;
+            entry.rateValid = true;
+        }
+        m_totalRate += entry.rateHz;
+        m_totalBandwidth += entry.bytesPerSec;
+    }
+
+    if (m_rows.size() != m_entries.size()) {
+        // Появились новые типы - строки пересобираются (редко)
+        beginResetModel();
+        m_rows.resize(m_entries.size());
+        for (qint32 i = 0; i < m_rows.size(); i++) {
+            m_rows[i] = i;
+        }
+        std::sort(m_rows.begin(), m_rows.end(), [this](qint32 a, qint32 b) {
+            const Entry &x = m_entries[a];
+            const Entry &y = m_entries[b];
+            return x.source != y.source ? x.source < y.source : x.msgId < y.msgId;
+        });
+        endResetModel();
+    } else if (!m_rows.isEmpty()) {
+        emit dataChanged(index(0, CountColumn), index(m_rows.size() - 1, PayloadColumn));
+    }
+    emit refreshed();
+}
+
+double MessageInspector::totalRate() const
+{
+    return m_totalRate;
+}
+
+double MessageInspector::totalBandwidth() const
+{
+    return m_totalBandwidth;
+}
+
+int MessageInspector::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_rows.size());
+}
+
+int MessageInspector::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant MessageInspector::value(const Entry &entry, int column) const
+{
+    switch (column) {
+    case SystemColumn:
+        return entry.source >> 8;
+    case ComponentColumn:
+        return entry.source & 0xFF;
+    case MsgIdColumn:
+        return entry.msgId;
+    case NameColumn: {
+        const char *name = Mavlink::messageName(entry.msgId);
+        return name ? QString::fromLatin1(name) : QString("MSG_%1").arg(entry.msgId);
+    }
+    case CountColumn:
+        return entry.count;
+    case RateColumn:
+        return entry.rateHz;
+    case BandwidthColumn:
+        return entry.bytesPerSec;
+    case ShareColumn:
+        return m_totalBandwidth > 0.0 ? 100.0 * entry.bytesPerSec / m_totalBandwidth : 0.0;
+    case PayloadColumn:
+        return QString::fromLatin1(QByteArray::fromRawData(entry.payload, entry.payloadLen).toHex(' '));
+    default:
+        return QVariant();
+    }
+}
+
+QVariant MessageInspector::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size() || index.column() >= ColumnCount) {
+        return QVariant();
+    }
+
+    const Entry &entry = m_entries[m_rows[index.row()]];
+    if (role == ValueRole) {
+        return value(entry, index.column());
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+    case RateColumn:
+        return QString::number(entry.rateHz, 'f', 1);
+    case BandwidthColumn:
+        return QString::number(entry.bytesPerSec, 'f', 0);
+    case ShareColumn:
+        return QString::number(value(entry, ShareColumn).toDouble(), 'f', 1);
+    default:
+        return value(entry, index.column());
+    }
+}
+
+QVariant MessageInspector::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section) {
+    case SystemColumn:
+        return QString("Sys");
+    case ComponentColumn:
+        return QString("Comp");
+    case MsgIdColumn:
+        return QString("ID");
+    case NameColumn:
+        return QString("Message");
+    case CountColumn:
+        return QString("Count");
+    case RateColumn:
+        return QString("Hz");
+    case BandwidthColumn:
+        return QString("B/s");
+    case ShareColumn:
+        return QString("%");
+    case PayloadColumn:
+        return QString("Last payload");
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> MessageInspector::roleNames() const
+{
+    return {
+        {Qt::DisplayRole, "display"},
+        {ValueRole, "value"},
+    };
+}
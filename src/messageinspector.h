@@ -0,0 +1,108 @@
+#ifndef MESSAGEINSPECTOR_H
+#define MESSAGEINSPECTOR_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include <QtQml/qqmlregistration.h>
+#include "scheduler.h"
+
+// Инспектор MAVLink: по каждому типу сообщения от каждого компонента -
+// число кадров, байты (кадр целиком, как в эфире), сглаженные частота
+// и полоса, последний payload. Показывает, какие потоки съедают канал.
+//
+// Прием кадра - индекс в плоском массиве по msgid и короткая цепочка
+// источников этого msgid, без хеширования и выделений памяти (кроме
+// первого кадра нового типа). Модель для QML обновляется по таймеру
+// RefreshIntervalMs, а не на каждый кадр.
+class MessageInspector : public QAbstractTableModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Provided by MavlinkHandler.inspector")
+
+    Q_PROPERTY(double totalRate READ totalRate NOTIFY refreshed)
+    Q_PROPERTY(double totalBandwidth READ totalBandwidth NOTIFY refreshed)
+
+public:
+    enum Column {
+        SystemColumn,
+        ComponentColumn,
+        MsgIdColumn,
+        NameColumn,
+        CountColumn,
+        RateColumn,
+        BandwidthColumn,
+        ShareColumn,
+        PayloadColumn,
+        ColumnCount
+    };
+    Q_ENUM(Column)
+
+    enum Role {
+        ValueRole = Qt::UserRole    // число без форматирования (для сортировки)
+    };
+
+    static constexpr int RefreshIntervalMs = 333;       // 3 Гц
+    static constexpr double RateTimeConstantS = 2.0;    // сглаживание частоты и полосы
+    static constexpr int IndexSize = 0x10000;           // msgid выше - по остатку, с цепочкой
+
+    // Сглаженные показатели одного типа сообщения от одного компонента
+    struct Stats {
+        quint64 count = 0;
+        double rateHz = 0.0;
+        double bytesPerSec = 0.0;
+        double frameBytes = 0.0;    // средняя длина кадра
+    };
+
+    explicit MessageInspector(QObject *parent = nullptr);
+    ~MessageInspector();
+
+    // Горячий путь: один принятый кадр
+    void record(quint8 sysid, quint8 compid, quint32 msgId, const char *payload, int payloadLen,
+                int frameLen, qint64 rxNs);
+    void clear();
+
+    Stats stats(quint8 sysid, quint8 compid, quint32 msgId) const;
+    double totalRate() const;
+    double totalBandwidth() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+signals:
+    void refreshed();
+
+private:
+    struct Entry {
+        quint16 source = 0;         // sysid << 8 | compid
+        quint32 msgId = 0;
+        qint32 next = -1;           // следующая запись в той же ячейке индекса
+        quint64 count = 0;
+        quint64 bytes = 0;
+        quint64 refreshedCount = 0; // значения на прошлом обновлении
+        quint64 refreshedBytes = 0;
+        double rateHz = 0.0;
+        double bytesPerSec = 0.0;
+        bool rateValid = false;
+        qint64 lastRxNs = 0;
+        quint8 payloadLen = 0;
+        char payload[255];
+    };
+
+    void refresh();
+    qint32 find(quint16 source, quint32 msgId) const;
+    QVariant value(const Entry &entry, int column) const;
+
+    QVector<qint32> m_index;    // msgid -> первая запись, -1 - нет
+    QVector<Entry> m_entries;   // в порядке появления, индексы не меняются
+    QVector<qint32> m_rows;     // строки модели -> записи, по (sysid, compid, msgid)
+    double m_totalRate;
+    double m_totalBandwidth;
+    qint64 m_lastRefreshNs;
+    Scheduler::TaskId m_refreshTask;
+};
+
+#endif // MESSAGEINSPECTOR_H
@@ -0,0 +1,115 @@
+#include "metrics.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+namespace Metrics {
+
+namespace {
+
+QByteArray formatValue(double value)
+{
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    return QByteArray::number(value, 'g', 12);
+}
+
+QByteArray seriesName(const QByteArray &name, const QByteArray &labels)
+{
+    return labels.isEmpty() ? name : name + '{' + labels + '}';
+}
+
+} // namespace
+
+Registry &Registry::instance()
+{
+    static Registry registry;
+    return registry;
+}
+
+Registry::Entry *Registry::find(const QByteArray &name, const QByteArray &help, const QByteArray &labels, Type type)
+{
+    QMutexLocker locker(&m_mutex);
+    for (const std::unique_ptr<Entry> &entry : m_entries) {
+        if (entry->name == name && entry->labels == labels) {
+            Q_ASSERT(entry->type == type);
+            return entry.get();
+        }
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->labels = labels;
+    entry->type = type;
+    m_entries.push_back(std::move(entry));
+    return m_entries.back().get();
+}
+
+Counter *Registry::counter(const QByteArray &name, const QByteArray &help, const QByteArray &labels)
+{
+    return &find(name, help, labels, Type::Counter)->counter;
+}
+
+Gauge *Registry::gauge(const QByteArray &name, const QByteArray &help, const QByteArray &labels)
+{
+    return &find(name, help, labels, Type::Gauge)->gauge;
+}
+
+Timing *Registry::timing(const QByteArray &name, const QByteArray &help, const QByteArray &labels)
+{
+    return &find(name, help, labels, Type::Timing)->timing;
+}
+
+QByteArray Registry::exposition() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Серии одной метрики должны идти подряд под одним HELP/TYPE
+    std::vector<const Entry *> sorted;
+    sorted.reserve(m_entries.size());
+    for (const std::unique_ptr<Entry> &entry : m_entries) {
+        sorted.push_back(entry.get());
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Entry *a, const Entry *b) {
+        return a->name < b->name;
+    });
+
+    QByteArray text;
+    text.reserve(int(sorted.size()) * 96);
+    const QByteArray *previousName = nullptr;
+    for (const Entry *entry : sorted) {
+        if (!previousName || *previousName != entry->name) {
+            const char *type = entry->type == Type::Counter ? "counter"
+                             : entry->type == Type::Gauge   ? "gauge"
+                                                            : "summary";
+            text += "# HELP " + entry->name + ' ' + entry->help + '\n';
+            text += "# TYPE " + entry->name + ' ' + type + '\n';
+            previousName = &entry->name;
+        }
+
+        switch (entry->type) {
+        case Type::Counter:
+            text += seriesName(entry->name, entry->labels) + ' '
+                    + QByteArray::number(entry->counter.value()) + '\n';
+            break;
+        case Type::Gauge:
+            text += seriesName(entry->name, entry->labels) + ' '
+                    + formatValue(entry->gauge.value()) + '\n';
+            break;
+        case Type::Timing:
+            text += seriesName(entry->name + "_sum", entry->labels) + ' '
+                    + formatValue(entry->timing.sumSeconds()) + '\n';
+            text += seriesName(entry->name + "_count", entry->labels) + ' '
+                    + QByteArray::number(entry->timing.count()) + '\n';
+            break;
+        }
+    }
+    return text;
+}
+
+} // namespace Metrics
@@ -0,0 +1,104 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Реестр счетчиков и показателей канала и парсера.
+// Метрика регистрируется один раз (под мьютексом), дальше обновляется
+// через указатель атомарными операциями без блокировок.
+// Выгрузка - текстовый формат Prometheus (см. MetricsServer).
+namespace Metrics {
+
+class Counter
+{
+public:
+    void add(quint64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value{0};
+};
+
+class Gauge
+{
+public:
+    void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+    double value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> m_value{0.0};
+};
+
+// Длительности: сумма и количество (summary без квантилей)
+class Timing
+{
+public:
+    void observeNs(qint64 ns)
+    {
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sumNs.fetch_add(quint64(ns > 0 ? ns : 0), std::memory_order_relaxed);
+    }
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    double sumSeconds() const { return double(m_sumNs.load(std::memory_order_relaxed)) / 1e9; }
+
+private:
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sumNs{0};
+};
+
+class Registry
+{
+public:
+    static Registry &instance();
+
+    // labels - готовая строка меток Prometheus без фигурных скобок,
+    // например: msgid="30". Повторная регистрация возвращает ту же метрику.
+    Counter *counter(const QByteArray &name, const QByteArray &help, const QByteArray &labels = QByteArray());
+    Gauge *gauge(const QByteArray &name, const QByteArray &help, const QByteArray &labels = QByteArray());
+    Timing *timing(const QByteArray &name, const QByteArray &help, const QByteArray &labels = QByteArray());
+
+    // Текстовый формат Prometheus 0.0.4
+    QByteArray exposition() const;
+
+private:
+    enum class Type { Counter, Gauge, Timing };
+
+    struct Entry {
+        QByteArray name;
+        QByteArray help;
+        QByteArray labels;
+        Type type;
+        Counter counter;
+        Gauge gauge;
+        Timing timing;
+    };
+
+    Registry() = default;
+    Entry *find(const QByteArray &name, const QByteArray &help, const QByteArray &labels, Type type);
+
+    mutable QMutex m_mutex;
+    std::vector<std::unique_ptr<Entry>> m_entries;
+};
+
+inline Counter *counter(const QByteArray &name, const QByteArray &help, const QByteArray &labels = QByteArray())
+{
+    return Registry::instance().counter(name, help, labels);
+}
+
+inline Gauge *gauge(const QByteArray &name, const QByteArray &help, const QByteArray &labels = QByteArray())
+{
+    return Registry::instance().gauge(name, help, labels);
+}
+
+inline Timing *timing(const QByteArray &name, const QByteArray &help, const QByteArray &labels = QByteArray())
+{
+    return Registry::instance().timing(name, help, labels);
+}
+
+} // namespace Metrics
+
+#endif // METRICS_H
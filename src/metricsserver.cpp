@@ -0,0 +1,115 @@
+#include "metricsserver.h"
+#include "metrics.h"
+#include <QDebug>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+namespace {
+
+// Запрос больше 8 КБ без конца заголовков - не Prometheus, закрываем
+constexpr int MaxRequestBytes = 8192;
+
+} // namespace
+
+MetricsServer::MetricsServer(QObject *parent)
+    : QObject(parent)
+    , m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsServer::onNewConnection);
+}
+
+bool MetricsServer::listen(const QHostAddress &address, quint16 port)
+{
+    if (!m_server->listen(address, port)) {
+        qWarning() << "❌ Metrics endpoint failed to listen on" << address.toString() << port
+                   << m_server->errorString();
+        return false;
+    }
+    qDebug() << "📊 Metrics endpoint: http://" + address.toString() + ":" + QString::number(m_server->serverPort()) + "/metrics";
+    return true;
+}
+
+void MetricsServer::close()
+{
+    m_server->close();
+}
+
+bool MetricsServer::isListening() const
+{
+    return m_server->isListening();
+}
+
+quint16 MetricsServer::serverPort() const
+{
+    return m_server->serverPort();
+}
+
+bool MetricsServer::parseListenAddress(const QString &text, QHostAddress *address, quint16 *port)
+{
+    const int colon = text.lastIndexOf(':');
+    const QString host = colon >= 0 ? text.left(colon) : QString();
+    bool ok = false;
+    const uint value = text.mid(colon + 1).toUInt(&ok);
+    if (!ok || value > 65535) {
+        return false;
+    }
+
+    if (host.isEmpty()) {
+        *address = QHostAddress(QHostAddress::LocalHost);
+    } else if (!address->setAddress(host)) {
+        return false;
+    }
+    *port = quint16(value);
+    return true;
+}
+
+void MetricsServer::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            handleRequest(socket);
+        });
+    }
+}
+
+void MetricsServer::handleRequest(QTcpSocket *socket)
+{
+    // Ждем конца заголовков; тело у GET не ожидается
+    QByteArray request = socket->peek(MaxRequestBytes);
+    if (!request.contains("\r\n\r\n") && !request.contains("\n\n")) {
+        if (request.size() >= MaxRequestBytes) {
+            socket->abort();
+        }
+        return;
+    }
+    socket->readAll();
+
+    const QList<QByteArray> requestLine = request.left(request.indexOf('\n')).trimmed().split(' ');
+    if (requestLine.size() < 2) {
+        reply(socket, "400 Bad Request", "text/plain", "bad request\n");
+        return;
+    }
+
+    const QByteArray &method = requestLine.at(0);
+    const QByteArray path = requestLine.at(1).split('?').first();
+    if (method != "GET" && method != "HEAD") {
+        reply(socket, "405 Method Not Allowed", "text/plain", "only GET is supported\n");
+    } else if (path == "/metrics") {
+        reply(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+              method == "HEAD" ? QByteArray() : Metrics::Registry::instance().exposition());
+    } else {
+        reply(socket, "404 Not Found", "text/plain", "see /metrics\n");
+    }
+}
+
+void MetricsServer::reply(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType, const QByteArray &body)
+{
+    QByteArray response = "HTTP/1.0 " + status + "\r\n"
+                          "Content-Type: " + contentType + "\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                          "Connection: close\r\n\r\n";
+    response += body;
+    socket->write(response);
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,37 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QHostAddress>
+
+class QTcpServer;
+class QTcpSocket;
+
+// Минимальный HTTP/1.0 сервер: GET /metrics отдает Metrics::Registry
+// в текстовом формате Prometheus. Зависит только от QtCore/QtNetwork.
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsServer(QObject *parent = nullptr);
+
+    bool listen(const QHostAddress &address, quint16 port);
+    void close();
+    bool isListening() const;
+    quint16 serverPort() const;
+
+    // Разбор "[адрес:]порт" из командной строки; без адреса - только localhost
+    static bool parseListenAddress(const QString &text, QHostAddress *address, quint16 *port);
+
+private slots:
+    void onNewConnection();
+
+private:
+    void handleRequest(QTcpSocket *socket);
+    void reply(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType, const QByteArray &body);
+
+    QTcpServer *m_server;
+};
+
+#endif // METRICSSERVER_H
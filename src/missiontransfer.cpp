@@ -0,0 +1,683 @@
+#include "missiontransfer.h"
+#include "mavlinkprotocol.h"
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <cmath>
+
+namespace {
+
+constexpr quint32 MsgMissionRequest = 40;
+constexpr quint32 MsgMissionRequestList = 43;
+constexpr quint32 MsgMissionCount = 44;
+constexpr quint32 MsgMissionAck = 47;
+constexpr quint32 MsgMissionRequestInt = 51;
+constexpr quint32 MsgMissionItemInt = 73;
+
+constexpr quint8 MissionTypeMission = 0; // MAV_MISSION_TYPE_MISSION
+constexpr quint8 MissionAccepted = 0;    // MAV_MISSION_ACCEPTED
+constexpr quint8 MissionError = 1;       // MAV_MISSION_ERROR
+constexpr quint8 MissionOperationCancelled = 15;
+
+// Попыток на один запрос до отказа; таймаут повтора удваивается
+constexpr int MaxAttempts = 8;
+constexpr int DefaultMaxWindow = 16;
+
+// Проверка таймаутов и пополнение окна
+constexpr int ServiceIntervalMs = 20;
+
+// Масштаб x/y в MISSION_ITEM_INT зависит от системы координат
+double coordinateScale(quint8 frame)
+{
+    switch (frame) {
+    case 0:  // MAV_FRAME_GLOBAL
+    case 3:  // MAV_FRAME_GLOBAL_RELATIVE_ALT
+    case 5:  // MAV_FRAME_GLOBAL_INT
+    case 6:  // MAV_FRAME_GLOBAL_RELATIVE_ALT_INT
+    case 10: // MAV_FRAME_GLOBAL_TERRAIN_ALT
+    case 11: // MAV_FRAME_GLOBAL_TERRAIN_ALT_INT
+        return 1e7;
+    case 2:  // MAV_FRAME_MISSION - x/y это param5/param6 без масштаба
+        return 1.0;
+    default: // локальные системы, метры
+        return 1e4;
+    }
+}
+
+} // namespace
+
+MissionTransfer::MissionTransfer(QObject *parent)
+    : QObject(parent)
+    , m_state(State::Idle)
+    , m_targetSystem(1)
+    , m_targetComponent(1)
+    , m_transferred(0)
+    , m_nextSeq(0)
+    , m_window(1.0)
+    , m_maxWindow(DefaultMaxWindow)
+    , m_retransmissions(0)
+    , m_controlSentNs(0)
+    , m_controlAttempts(0)
+    , m_lastActivityNs(0)
+    , m_lastLossNs(0)
+    , m_startNs(0)
+    , m_progressDirty(false)
+    , m_serviceTask(0)
+{
+    m_clock.start();
+}
+
+bool MissionTransfer::busy() const
+{
+    return m_state == State::RequestingCount || m_state == State::Downloading || m_state == State::Uploading;
+}
+
+MissionTransfer::State MissionTransfer::state() const
+{
+    return m_state;
+}
+
+QString MissionTransfer::stateName() const
+{
+    switch (m_state) {
+    case State::Idle: return "Idle";
+    case State::RequestingCount: return "Requesting count";
+    case State::Downloading: return "Downloading";
+    case State::Uploading: return "Uploading";
+    case State::Completed: return "Completed";
+    case State::Failed: return "Failed";
+    }
+    return QString();
+}
+
+int MissionTransfer::totalItems() const
+{
+    return int(m_items.size());
+}
+
+int MissionTransfer::transferredItems() const
+{
+    return m_transferred;
+}
+
+double MissionTransfer::progress() const
+{
+    if (m_items.empty()) {
+        return m_state == State::Completed ? 1.0 : 0.0;
+    }
+    return double(m_transferred) / double(m_items.size());
+}
+
+double MissionTransfer::itemsPerSecond() const
+{
+    const qint64 elapsedNs = (busy() ? m_clock.nsecsElapsed() : m_lastActivityNs) - m_startNs;
+    if (elapsedNs <= 0) {
+        return 0.0;
+    }
+    return double(m_transferred) * 1e9 / double(elapsedNs);
+}
+
+int MissionTransfer::window() const
+{
+    return int(m_window);
+}
+
+double MissionTransfer::rttMs() const
+{
+    return m_rtt.rttMs();
+}
+
+int MissionTransfer::retransmissions() const
+{
+    return m_retransmissions;
+}
+
+void MissionTransfer::setMaxWindow(int window)
+{
+    m_maxWindow = qMax(1, window);
+    m_window = qMin(m_window, double(m_maxWindow));
+}
+
+void MissionTransfer::setInitialRtt(double rttMs)
+{
+    m_rtt.setInitialRtt(rttMs);
+}
+
+QList<MissionItem> MissionTransfer::items() const
+{
+    return QList<MissionItem>(m_items.begin(), m_items.end());
+}
+
+bool MissionTransfer::startDownload(quint8 targetSystem, quint8 targetComponent)
+{
+    if (busy()) {
+        return false;
+    }
+
+    m_targetSystem = targetSystem;
+    m_targetComponent = targetComponent;
+    m_items.clear();
+    m_received.clear();
+    m_transferred = 0;
+    m_pending.clear();
+    m_nextSeq = 0;
+    m_window = 1.0;
+    m_retransmissions = 0;
+    m_rtt.reset();
+    m_controlAttempts = 0;
+    m_startNs = m_clock.nsecsElapsed();
+    m_lastActivityNs = m_startNs;
+
+    setState(State::RequestingCount);
+    sendRequestList();
+
+    Scheduler::instance()->cancel(m_serviceTask);
+    m_serviceTask = Scheduler::instance()->scheduleRepeating(ServiceIntervalMs, this, [this]() {
+        service();
+    });
+    return true;
+}
+
+bool MissionTransfer::startUpload(quint8 targetSystem, quint8 targetComponent, const QList<MissionItem> &items)
+{
+    if (busy()) {
+        return false;
+    }
+
+    m_targetSystem = targetSystem;
+    m_targetComponent = targetComponent;
+    m_items.assign(items.begin(), items.end());
+    for (size_t i = 0; i < m_items.size(); ++i) {
+        m_items[i].seq = quint16(i);
+    }
+    m_received.assign(m_items.size(), false);
+    m_transferred = 0;
+    m_pending.clear();
+    m_retransmissions = 0;
+    m_rtt.reset();
+    m_controlAttempts = 0;
+    m_startNs = m_clock.nsecsElapsed();
+    m_lastActivityNs = m_startNs;
+
+    setState(State::Uploading);
+    sendCount();
+
+    Scheduler::instance()->cancel(m_serviceTask);
+    m_serviceTask = Scheduler::instance()->scheduleRepeating(ServiceIntervalMs, this, [this]() {
+        service();
+    });
+    return true;
+}
+
+void MissionTransfer::cancel()
+{
+    if (!busy()) {
+        return;
+    }
+    sendAck(MissionOperationCancelled);
+    finish(false, "Mission transfer cancelled");
+}
+
+void MissionTransfer::setState(State state)
+{
+    if (m_state != state) {
+        m_state = state;
+        emit stateChanged();
+    }
+}
+
+void MissionTransfer::finish(bool success, const QString &message)
+{
+    Scheduler::instance()->cancel(m_serviceTask);
+    m_serviceTask = 0;
+    m_pending.clear();
+    m_lastActivityNs = m_clock.nsecsElapsed();
+
+    setState(success ? State::Completed : State::Failed);
+    emit progressChanged();
+    m_progressDirty = false;
+
+    qDebug() << (success ? "🗺️" : "❌") << message
+             << QString("(%1 items/s, %2 retransmissions)").arg(itemsPerSecond(), 0, 'f', 1).arg(m_retransmissions);
+    emit finished(success, message);
+}
+
+void MissionTransfer::onLoss()
+{
+    // Одно уменьшение окна на RTT, даже если истекло сразу несколько запросов
+    const qint64 now = m_clock.nsecsElapsed();
+    if (now - m_lastLossNs < qint64(m_rtt.rttNs())) {
+        return;
+    }
+    m_lastLossNs = now;
+    m_window = qMax(1.0, m_window / 2.0);
+}
+
+void MissionTransfer::service()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    const qint64 rto = m_rtt.rtoNs();
+
+    if (m_state == State::RequestingCount) {
+        if (now - m_controlSentNs > rto) {
+            if (m_controlAttempts >= MaxAttempts) {
+                finish(false, "No MISSION_COUNT from vehicle");
+                return;
+            }
+            m_retransmissions++;
+            sendRequestList();
+        }
+    } else if (m_state == State::Downloading) {
+        QList<quint16> expired;
+        for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+            const qint64 timeout = qMin(RttEstimator::MaxRtoNs, rto << qMin(it.value().attempts - 1, 6));
+            if (now - it.value().sentNs > timeout) {
+                expired.append(it.key());
+            }
+        }
+        if (!expired.isEmpty()) {
+            onLoss();
+        }
+        for (quint16 seq : expired) {
+            if (m_pending.value(seq).attempts >= MaxAttempts) {
+                sendAck(MissionError);
+                finish(false, QString("Mission item %1 lost after %2 attempts").arg(seq).arg(MaxAttempts));
+                return;
+            }
+            // Перезапрашиваем только потерянный элемент
+            m_retransmissions++;
+            requestItem(seq);
+        }
+        fillWindow();
+    } else if (m_state == State::Uploading) {
+        if (m_transferred == 0) {
+            // Борт еще не начал запрашивать элементы - повторяем MISSION_COUNT
+            if (now - m_controlSentNs > rto) {
+                if (m_controlAttempts >= MaxAttempts) {
+                    finish(false, "Vehicle did not request mission items");
+                    return;
+                }
+                m_retransmissions++;
+                sendCount();
+            }
+        } else if (now - m_lastActivityNs > MaxAttempts * rto) {
+            finish(false, "Vehicle stopped requesting mission items");
+            return;
+        }
+    }
+
+    if (m_progressDirty) {
+        m_progressDirty = false;
+        emit progressChanged();
+    }
+}
+
+void MissionTransfer::fillWindow()
+{
+    const int count = int(m_items.size());
+    while (m_pending.size() < int(m_window) && m_nextSeq < count) {
+        const quint16 seq = quint16(m_nextSeq++);
+        if (!m_received[seq] && !m_pending.contains(seq)) {
+            requestItem(seq);
+        }
+    }
+}
+
+void MissionTransfer::requestItem(quint16 seq)
+{
+    Pending &pending = m_pending[seq];
+    pending.sentNs = m_clock.nsecsElapsed();
+    pending.attempts++;
+
+    QByteArray payload;
+    Mavlink::appendField<quint16>(payload, seq);
+    payload.append(char(m_targetSystem));
+    payload.append(char(m_targetComponent));
+    payload.append(char(MissionTypeMission));
+    emit frameReady(Mavlink::packMessage(MsgMissionRequestInt, payload));
+}
+
+void MissionTransfer::sendRequestList()
+{
+    m_controlSentNs = m_clock.nsecsElapsed();
+    m_controlAttempts++;
+
+    QByteArray payload;
+    payload.append(char(m_targetSystem));
+    payload.append(char(m_targetComponent));
+    payload.append(char(MissionTypeMission));
+    emit frameReady(Mavlink::packMessage(MsgMissionRequestList, payload));
+}
+
+void MissionTransfer::sendCount()
+{
+    m_controlSentNs = m_clock.nsecsElapsed();
+    m_controlAttempts++;
+
+    QByteArray payload;
+    Mavlink::appendField<quint16>(payload, quint16(m_items.size()));
+    payload.append(char(m_targetSystem));
+    payload.append(char(m_targetComponent));
+    payload.append(char(MissionTypeMission));
+    emit frameReady(Mavlink::packMessage(MsgMissionCount, payload));
+}
+
+void MissionTransfer::sendItem(quint16 seq)
+{
+    const MissionItem &item = m_items[seq];
+
+    QByteArray payload;
+    Mavlink::appendField<float>(payload, item.param1);
+    Mavlink::appendField<float>(payload, item.param2);
+    Mavlink::appendField<float>(payload, item.param3);
+    Mavlink::appendField<float>(payload, item.param4);
+    Mavlink::appendField<qint32>(payload, item.x);
+    Mavlink::appendField<qint32>(payload, item.y);
+    Mavlink::appendField<float>(payload, item.z);
+    Mavlink::appendField<quint16>(payload, seq);
+    Mavlink::appendField<quint16>(payload, item.command);
+    payload.append(char(m_targetSystem));
+    payload.append(char(m_targetComponent));
+    payload.append(char(item.frame));
+    payload.append(char(item.current));
+    payload.append(char(item.autocontinue));
+    payload.append(char(MissionTypeMission));
+    emit frameReady(Mavlink::packMessage(MsgMissionItemInt, payload));
+}
+
+void MissionTransfer::sendAck(quint8 result)
+{
+    QByteArray payload;
+    payload.append(char(m_targetSystem));
+    payload.append(char(m_targetComponent));
+    payload.append(char(result));
+    payload.append(char(MissionTypeMission));
+    emit frameReady(Mavlink::packMessage(MsgMissionAck, payload));
+}
+
+bool MissionTransfer::isMissionMessage(quint32 msgId)
+{
+    return msgId == MsgMissionRequest || msgId == MsgMissionCount || msgId == MsgMissionAck
+        || msgId == MsgMissionRequestInt || msgId == MsgMissionItemInt;
+}
+
+bool MissionTransfer::fromTarget(quint8 sysid, quint8 compid, const char *payload, int payloadLen, int targetOffset) const
+{
+    if (sysid != m_targetSystem || compid != m_targetComponent) {
+        return false;
+    }
+    // Сообщения для другой наземной станции пропускаем
+    const quint8 target = Mavlink::readField<quint8>(payload, payloadLen, targetOffset);
+    return target == 0 || target == Mavlink::GcsSystemId;
+}
+
+void MissionTransfer::handleMessage(quint8 sysid, quint8 compid, quint32 msgId, const char *payload, int payloadLen)
+{
+    if (!busy()) {
+        return;
+    }
+
+    switch (msgId) {
+    case MsgMissionCount:
+        if (fromTarget(sysid, compid, payload, payloadLen, 2)) {
+            handleCount(payload, payloadLen);
+        }
+        break;
+    case MsgMissionItemInt:
+        if (fromTarget(sysid, compid, payload, payloadLen, 32)) {
+            handleItem(payload, payloadLen);
+        }
+        break;
+    case MsgMissionRequest:
+    case MsgMissionRequestInt:
+        if (fromTarget(sysid, compid, payload, payloadLen, 2)) {
+            handleRequest(payload, payloadLen);
+        }
+        break;
+    case MsgMissionAck:
+        if (fromTarget(sysid, compid, payload, payloadLen, 0)) {
+            handleAck(payload, payloadLen);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void MissionTransfer::handleCount(const char *payload, int payloadLen)
+{
+    if (m_state != State::RequestingCount) {
+        return; // повтор MISSION_COUNT во время скачивания
+    }
+    if (Mavlink::readField<quint8>(payload, payloadLen, 4) != MissionTypeMission) {
+        return;
+    }
+
+    const quint16 count = Mavlink::readField<quint16>(payload, payloadLen, 0);
+    const qint64 now = m_clock.nsecsElapsed();
+    if (m_controlAttempts == 1) {
+        m_rtt.sample(now - m_controlSentNs);
+    }
+    m_lastActivityNs = now;
+
+    if (count == 0) {
+        sendAck(MissionAccepted);
+        finish(true, "Vehicle has no mission");
+        return;
+    }
+
+    // После перехода на stop-and-wait уже скачанные элементы сохраняются
+    if (m_items.size() != count) {
+        m_items.assign(count, MissionItem());
+        m_received.assign(count, false);
+        m_transferred = 0;
+    }
+    m_pending.clear();
+    m_nextSeq = 0;
+
+    qDebug() << "🗺️ Mission download:" << count << "items, window up to" << m_maxWindow;
+    setState(State::Downloading);
+    m_progressDirty = true;
+    fillWindow();
+}
+
+void MissionTransfer::handleItem(const char *payload, int payloadLen)
+{
+    if (m_state != State::Downloading) {
+        return;
+    }
+    if (Mavlink::readField<quint8>(payload, payloadLen, 37) != MissionTypeMission) {
+        return;
+    }
+
+    const quint16 seq = Mavlink::readField<quint16>(payload, payloadLen, 28);
+    if (seq >= m_items.size() || m_received[seq]) {
+        return; // дубликат ответа на повторный запрос
+    }
+
+    MissionItem &item = m_items[seq];
+    item.param1 = Mavlink::readField<float>(payload, payloadLen, 0);
+    item.param2 = Mavlink::readField<float>(payload, payloadLen, 4);
+    item.param3 = Mavlink::readField<float>(payload, payloadLen, 8);
+    item.param4 = Mavlink::readField<float>(payload, payloadLen, 12);
+    item.x = Mavlink::readField<qint32>(payload, payloadLen, 16);
+    item.y = Mavlink::readField<qint32>(payload, payloadLen, 20);
+    item.z = Mavlink::readField<float>(payload, payloadLen, 24);
+    item.seq = seq;
+    item.command = Mavlink::readField<quint16>(payload, payloadLen, 30);
+    item.frame = Mavlink::readField<quint8>(payload, payloadLen, 34);
+    item.current = Mavlink::readField<quint8>(payload, payloadLen, 35);
+    item.autocontinue = Mavlink::readField<quint8>(payload, payloadLen, 36);
+
+    m_received[seq] = true;
+    m_transferred++;
+    m_progressDirty = true;
+
+    const qint64 now = m_clock.nsecsElapsed();
+    m_lastActivityNs = now;
+    auto pending = m_pending.find(seq);
+    if (pending != m_pending.end()) {
+        if (pending.value().attempts == 1) {
+            m_rtt.sample(now - pending.value().sentNs);
+        }
+        m_pending.erase(pending);
+    }
+
+    // +1 к окну за RTT без потерь
+    m_window = qMin(double(m_maxWindow), m_window + 1.0 / m_window);
+
+    if (m_transferred == int(m_items.size())) {
+        sendAck(MissionAccepted);
+        finish(true, QString("Mission downloaded: %1 items").arg(m_transferred));
+        return;
+    }
+    fillWindow();
+}
+
+void MissionTransfer::handleRequest(const char *payload, int payloadLen)
+{
+    if (m_state != State::Uploading) {
+        return;
+    }
+    if (Mavlink::readField<quint8>(payload, payloadLen, 4) != MissionTypeMission) {
+        return;
+    }
+
+    const quint16 seq = Mavlink::readField<quint16>(payload, payloadLen, 0);
+    if (seq >= m_items.size()) {
+        return;
+    }
+
+    const qint64 now = m_clock.nsecsElapsed();
+    if (m_transferred == 0 && m_controlAttempts == 1) {
+        m_rtt.sample(now - m_controlSentNs);
+    }
+    m_lastActivityNs = now;
+
+    if (!m_received[seq]) {
+        m_received[seq] = true;
+        m_transferred++;
+        m_progressDirty = true;
+    } else {
+        m_retransmissions++;
+    }
+    sendItem(seq);
+}
+
+void MissionTransfer::handleAck(const char *payload, int payloadLen)
+{
+    if (Mavlink::readField<quint8>(payload, payloadLen, 3) != MissionTypeMission) {
+        return;
+    }
+    const quint8 result = Mavlink::readField<quint8>(payload, payloadLen, 2);
+
+    if (m_state == State::Uploading) {
+        if (result == MissionAccepted && m_transferred == int(m_items.size())) {
+            finish(true, QString("Mission uploaded: %1 items").arg(m_transferred));
+        } else {
+            finish(false, QString("Vehicle rejected mission upload (MAV_MISSION_RESULT %1)").arg(result));
+        }
+        return;
+    }
+
+    if (result == MissionAccepted) {
+        return;
+    }
+
+    // Автопилоты со строгим порядком запросов (PX4) отвечают ошибкой на окно > 1:
+    // начинаем заново в режиме stop-and-wait, скачанные элементы сохраняем
+    if (m_state == State::Downloading && m_maxWindow > 1) {
+        qDebug() << "⚠️ Vehicle rejected pipelined mission requests, falling back to stop-and-wait";
+        m_maxWindow = 1;
+        m_window = 1.0;
+        m_pending.clear();
+        m_controlAttempts = 0;
+        setState(State::RequestingCount);
+        sendRequestList();
+        return;
+    }
+
+    finish(false, QString("Vehicle aborted mission download (MAV_MISSION_RESULT %1)").arg(result));
+}
+
+bool MissionTransfer::saveWaypoints(const QString &path, const QList<MissionItem> &items, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "QGC WPL 110\n";
+    for (const MissionItem &item : items) {
+        const double scale = coordinateScale(item.frame);
+        // quint8 в QTextStream выводится как символ, поэтому явно в int
+        out << item.seq << '\t' << int(item.current) << '\t' << int(item.frame) << '\t' << item.command << '\t'
+            << QString::number(item.param1, 'g', 9) << '\t'
+            << QString::number(item.param2, 'g', 9) << '\t'
+            << QString::number(item.param3, 'g', 9) << '\t'
+            << QString::number(item.param4, 'g', 9) << '\t'
+            << QString::number(item.x / scale, 'f', 8) << '\t'
+            << QString::number(item.y / scale, 'f', 8) << '\t'
+            << QString::number(item.z, 'g', 9) << '\t'
+            << int(item.autocontinue) << '\n';
+    }
+    return true;
+}
+
+bool MissionTransfer::loadWaypoints(const QString &path, QList<MissionItem> *items, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    QTextStream in(&file);
+    if (!in.readLine().startsWith("QGC WPL 110")) {
+        if (error) {
+            *error = "Not a QGC WPL 110 file";
+        }
+        return false;
+    }
+
+    items->clear();
+    int lineNumber = 1;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        lineNumber++;
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        const QStringList fields = line.split('\t');
+        if (fields.size() < 12) {
+            if (error) {
+                *error = QString("Line %1: expected 12 fields").arg(lineNumber);
+            }
+            return false;
+        }
+
+        MissionItem item;
+        item.seq = quint16(items->size());
+        item.current = quint8(fields[1].toUInt());
+        item.frame = quint8(fields[2].toUInt());
+        item.command = quint16(fields[3].toUInt());
+        item.param1 = fields[4].toFloat();
+        item.param2 = fields[5].toFloat();
+        item.param3 = fields[6].toFloat();
+        item.param4 = fields[7].toFloat();
+        const double scale = coordinateScale(item.frame);
+        item.x = qint32(std::llround(fields[8].toDouble() * scale));
+        item.y = qint32(std::llround(fields[9].toDouble() * scale));
+        item.z = fields[10].toFloat();
+        item.autocontinue = quint8(fields[11].toUInt());
+        items->append(item);
+    }
+    return true;
+}
@@ -0,0 +1,154 @@
+#ifndef MISSIONTRANSFER_H
+#define MISSIONTRANSFER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QtQml/qqmlregistration.h>
+#include <vector>
+#include "rttestimator.h"
+#include "scheduler.h"
+
+// Элемент миссии в представлении MISSION_ITEM_INT
+struct MissionItem {
+    quint16 seq = 0;
+    quint8 frame = 3;           // MAV_FRAME_GLOBAL_RELATIVE_ALT
+    quint16 command = 16;       // MAV_CMD_NAV_WAYPOINT
+    quint8 current = 0;
+    quint8 autocontinue = 1;
+    float param1 = 0.0f;
+    float param2 = 0.0f;
+    float param3 = 0.0f;
+    float param4 = 0.0f;
+    qint32 x = 0;               // широта * 1e7 (глобальные системы) или метры * 1e4
+    qint32 y = 0;
+    float z = 0.0f;
+};
+
+// Загрузка и выгрузка миссии по протоколу MAVLink mission.
+// Скачивание идет скользящим окном MISSION_REQUEST_INT: несколько запросов
+// в полете, потерянные элементы перезапрашиваются выборочно, таймаут
+// считается по измеренному RTT (как RTO в TCP). Окно растет на 1 за каждый
+// полностью подтвержденный RTT и уменьшается вдвое при потере.
+// Выгрузку ведет борт (он запрашивает элементы по одному), поэтому здесь
+// ускорение только в мгновенном ответе и таймаутах по RTT.
+class MissionTransfer : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Provided by MavlinkHandler.mission")
+
+    Q_PROPERTY(bool busy READ busy NOTIFY stateChanged)
+    Q_PROPERTY(QString state READ stateName NOTIFY stateChanged)
+    Q_PROPERTY(int totalItems READ totalItems NOTIFY progressChanged)
+    Q_PROPERTY(int transferredItems READ transferredItems NOTIFY progressChanged)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(double itemsPerSecond READ itemsPerSecond NOTIFY progressChanged)
+    Q_PROPERTY(int window READ window NOTIFY progressChanged)
+    Q_PROPERTY(double rttMs READ rttMs NOTIFY progressChanged)
+    Q_PROPERTY(int retransmissions READ retransmissions NOTIFY progressChanged)
+
+public:
+    enum class State {
+        Idle,
+        RequestingCount,
+        Downloading,
+        Uploading,
+        Completed,
+        Failed
+    };
+
+    explicit MissionTransfer(QObject *parent = nullptr);
+
+    bool busy() const;
+    State state() const;
+    QString stateName() const;
+    int totalItems() const;
+    int transferredItems() const;
+    double progress() const;
+    double itemsPerSecond() const;
+    int window() const;
+    double rttMs() const;
+    int retransmissions() const;
+
+    // Предел окна запросов; 1 - классический stop-and-wait
+    void setMaxWindow(int window);
+    // Начальная оценка RTT (например, из TIMESYNC), пока нет своих замеров
+    void setInitialRtt(double rttMs);
+
+    bool startDownload(quint8 targetSystem, quint8 targetComponent);
+    bool startUpload(quint8 targetSystem, quint8 targetComponent, const QList<MissionItem> &items);
+    Q_INVOKABLE void cancel();
+
+    QList<MissionItem> items() const;
+
+    // Сообщения протокола миссий от борта (MISSION_COUNT/ITEM_INT/REQUEST/REQUEST_INT/ACK)
+    static bool isMissionMessage(quint32 msgId);
+    void handleMessage(quint8 sysid, quint8 compid, quint32 msgId, const char *payload, int payloadLen);
+
+    // Файл QGC WPL 110
+    static bool saveWaypoints(const QString &path, const QList<MissionItem> &items, QString *error = nullptr);
+    static bool loadWaypoints(const QString &path, QList<MissionItem> *items, QString *error = nullptr);
+
+signals:
+    void frameReady(const QByteArray &frame);
+    void stateChanged();
+    void progressChanged();
+    void finished(bool success, const QString &message);
+
+private:
+    struct Pending {
+        qint64 sentNs = 0;
+        int attempts = 0;
+    };
+
+    void setState(State state);
+    void finish(bool success, const QString &message);
+    void service();
+    void fillWindow();
+    void requestItem(quint16 seq);
+    void sendRequestList();
+    void sendCount();
+    void sendItem(quint16 seq);
+    void sendAck(quint8 result);
+    void onLoss();
+    bool fromTarget(quint8 sysid, quint8 compid, const char *payload, int payloadLen, int targetOffset) const;
+
+    void handleCount(const char *payload, int payloadLen);
+    void handleItem(const char *payload, int payloadLen);
+    void handleRequest(const char *payload, int payloadLen);
+    void handleAck(const char *payload, int payloadLen);
+
+    State m_state;
+    quint8 m_targetSystem;
+    quint8 m_targetComponent;
+
+    // Скачанные или выгружаемые элементы
+    std::vector<MissionItem> m_items;
+    std::vector<bool> m_received;
+    int m_transferred;
+
+    // Окно запросов
+    QHash<quint16, Pending> m_pending;
+    int m_nextSeq;
+    double m_window;
+    int m_maxWindow;
+    int m_retransmissions;
+
+    // Управляющее сообщение (REQUEST_LIST или COUNT) до ответа борта
+    qint64 m_controlSentNs;
+    int m_controlAttempts;
+    qint64 m_lastActivityNs;
+
+    RttEstimator m_rtt;
+    qint64 m_lastLossNs;
+
+    qint64 m_startNs;
+    bool m_progressDirty;
+
+    QElapsedTimer m_clock;
+    Scheduler::TaskId m_serviceTask;
+};
+
+#endif // MISSIONTRANSFER_H
@@ -1,21 +1,32 @@
 #include "networkmanager.h"
+#include "pipelineprofiler.h"
+#include "bufferpool.h"
+#include "mavlinkprotocol.h"
 #include <QDebug>
 #include <QNetworkInterface>
 #include <QtEndian>
 
 NetworkManager::NetworkManager(QObject *parent)
-    : QObject(parent)
+    : MavlinkLink(parent)
     , m_socket(new QUdpSocket(this))
     , m_connected(false)
     , m_status("Disconnected")
     , m_remotePort(0)
-    , m_heartbeatTimer(new QTimer(this))
+    , m_localPort(14550)
+    , m_senderPort(0)
+    , m_connectToPeer(false)
+    , m_peerConnected(false)
+    , m_heartbeatTask(0)
+    , m_datagramsReceived(Metrics::counter("mavlink_udp_datagrams_received_total", "UDP datagrams accepted from the flight controller"))
+    , m_bytesReceived(Metrics::counter("mavlink_udp_bytes_received_total", "Bytes in accepted UDP datagrams"))
+    , m_datagramsRejected(Metrics::counter("mavlink_udp_datagrams_rejected_total", "UDP datagrams from unexpected sources"))
+    , m_datagramsSent(Metrics::counter("mavlink_udp_datagrams_sent_total", "UDP datagrams sent to the flight controller"))
+    , m_bytesSent(Metrics::counter("mavlink_udp_bytes_sent_total", "Bytes sent to the flight controller"))
+    , m_sendErrors(Metrics::counter("mavlink_udp_send_errors_total", "Failed UDP sends"))
 {
     connect(m_socket, &QUdpSocket::readyRead, this, &NetworkManager::onReadyRead);
-    connect(m_heartbeatTimer, &QTimer::timeout, this, &NetworkManager::sendMavlinkHeartbeat);
 
     // НЕ слушаем порты при старте - только после подключения
-    m_heartbeatTimer->setInterval(1000);
 }
 
 NetworkManager::~NetworkManager()
@@ -33,6 +44,26 @@ QString NetworkManager::status() const
     return m_status;
 }
 
+void NetworkManager::setLocalPort(quint16 port)
+{
+    m_localPort = port;
+}
+
+void NetworkManager::setSourceFilter(const SourceFilter &filter)
+{
+    m_sourceFilter = filter;
+}
+
+SourceFilter NetworkManager::sourceFilter() const
+{
+    return m_sourceFilter;
+}
+
+void NetworkManager::setConnectToPeer(bool enabled)
+{
+    m_connectToPeer = enabled;
+}
+
 void NetworkManager::connectToFC(const QString &ip, int port)
 {
     if (m_connected) {
@@ -45,14 +76,37 @@ void NetworkManager::connectToFC(const QString &ip, int port)
     m_remoteAddress = QHostAddress(ip);
     m_remotePort = port;
 
+    // Список источников разбирается один раз на подключение
+    m_activeFilter = m_sourceFilter;
+    if (m_activeFilter.isEmpty()) {
+        m_activeFilter.addRule(QHostAddress(quint32(0xC0A80100)), 24); // 192.168.1.0/24
+        if (!m_remoteAddress.isNull() && !m_remoteAddress.isBroadcast() && !m_remoteAddress.isMulticast()) {
+            m_activeFilter.addRule(m_remoteAddress, m_remoteAddress.protocol() == QHostAddress::IPv6Protocol ? 128 : 32);
+        }
+    }
+
+    // Для connect() протокол сокета должен совпадать с адресом борта,
+    // иначе Qt создаст новый сокет без нашего bind
+    const bool toPeer = m_connectToPeer && m_remotePort > 0 && !m_remoteAddress.isNull()
+                        && !m_remoteAddress.isBroadcast() && !m_remoteAddress.isMulticast();
+    const QHostAddress bindAddress = !toPeer ? QHostAddress(QHostAddress::Any)
+                                     : m_remoteAddress.protocol() == QHostAddress::IPv6Protocol
+                                         ? QHostAddress(QHostAddress::AnyIPv6)
+                                         : QHostAddress(QHostAddress::AnyIPv4);
+
     // Биндим сокет только при подключении
-    if (m_socket->bind(QHostAddress::Any, 14550)) {
+    if (m_socket->bind(bindAddress, m_localPort)) {
+        attachFilters(toPeer);
         m_connected = true;
         m_status = QString("UDP connected to %1:%2").arg(ip).arg(port);
         emit connectedChanged(m_connected);
         emit statusChanged(m_status);
 
-        m_heartbeatTimer->start();
+        // Heartbeat через общий планировщик, допуск 100 мс для объединения пробуждений
+        Scheduler::instance()->cancel(m_heartbeatTask);
+        m_heartbeatTask = Scheduler::instance()->scheduleRepeating(1000, this, [this]() {
+            sendMavlinkHeartbeat();
+        }, 100);
         qDebug() << "UDP connected to" << ip << ":" << port;
     } else {
         m_status = "Bind failed: " + m_socket->errorString();
@@ -63,8 +117,10 @@ void NetworkManager::connectToFC(const QString &ip, int port)
 
 void NetworkManager::disconnectFromFC()
 {
-    m_heartbeatTimer->stop();
+    Scheduler::instance()->cancel(m_heartbeatTask);
+    m_heartbeatTask = 0;
     m_socket->close();
+    m_peerConnected = false;
     m_connected = false;
     m_status = "Disconnected";
     emit connectedChanged(m_connected);
@@ -74,9 +130,15 @@ void NetworkManager::disconnectFromFC()
 void NetworkManager::sendData(const QByteArray &data)
 {
     if (m_connected && m_remotePort > 0) {
-        qint64 bytesSent = m_socket->writeDatagram(data, m_remoteAddress, m_remotePort);
+        // У подключенного сокета адрес назначения уже задан
+        qint64 bytesSent = m_peerConnected ? m_socket->write(data)
+                                           : m_socket->writeDatagram(data, m_remoteAddress, m_remotePort);
         if (bytesSent == -1) {
+            m_sendErrors->add();
             qDebug() << "Failed to send UDP data:" << m_socket->errorString();
+        } else {
+            m_datagramsSent->add();
+            m_bytesSent->add(quint64(bytesSent));
         }
     }
 }
@@ -84,37 +146,61 @@ void NetworkManager::sendData(const QByteArray &data)
 void NetworkManager::onReadyRead()
 {
     while (m_socket->hasPendingDatagrams()) {
-        QByteArray datagram;
-        datagram.resize(m_socket->pendingDatagramSize());
+        // Буфер из пула потока: после обработки сигнала он возвращается в пул
+        BufferPool::Lease lease(int(qMax<qint64>(m_socket->pendingDatagramSize(), 0)));
+        QByteArray &datagram = lease.buffer();
 
-        QHostAddress sender;
-        quint16 senderPort;
-
-        qint64 bytesRead = m_socket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
+        // Адрес отправителя переиспользуется между датаграммами
+        qint64 bytesRead = m_socket->readDatagram(datagram.data(), datagram.size(), &m_sender, &m_senderPort);
 
         if (bytesRead > 0) {
-            // Логируем ВСЕ полученные данные
-            qDebug() << "📨 Received" << bytesRead << "bytes from" << sender.toString() << ":" << senderPort;
-
-            // Выводим первые 16 байт в hex для анализа
-            QByteArray hexPreview = datagram.left(16).toHex(' ');
-            qDebug() << "Hex preview:" << hexPreview;
-
-            // Проверяем, что данные пришли с ожидаемого адреса
-            if (sender.toString().contains("192.168.1")) { // Более гибкая проверка
+            Trace::point(Trace::Receive, Trace::beginFlow());
+            datagram.resize(int(bytesRead));
+
+            // Логируем ВСЕ полученные данные и первые 16 байт в hex для анализа
+            qCDebug(lcMavlinkPackets) << "📨 Received" << bytesRead << "bytes from" << m_sender.toString() << ":" << m_senderPort;
+            qCDebug(lcMavlinkPackets) << "Hex preview:" << datagram.left(16).toHex(' ');
+
+            // Проверяем источник по разобранному списку: целые числа, без строк.
+            // Если фильтр в ядре, сюда доходят только датаграммы из разрешенных сетей.
+            if (m_activeFilter.accepts(m_sender, m_senderPort)) {
+                m_datagramsReceived->add();
+                m_bytesReceived->add(quint64(bytesRead));
                 emit dataReceived(datagram);
 
-                // Считаем статистику
-                static int packetCount = 0;
-                packetCount++;
-                qDebug() << "📊 Total packets received:" << packetCount;
+                qCDebug(lcMavlinkPackets) << "📊 Total packets received:" << m_datagramsReceived->value();
             } else {
-                qDebug() << "⚠️  Received data from unexpected source:" << sender.toString();
+                m_datagramsRejected->add();
+                qCDebug(lcMavlinkPackets) << "⚠️  Received data from unexpected source:" << m_sender.toString() << ":" << m_senderPort;
             }
         }
     }
 }
 
+void NetworkManager::attachFilters(bool toPeer)
+{
+    if (toPeer) {
+        m_socket->connectToHost(m_remoteAddress, m_remotePort);
+        m_peerConnected = m_socket->state() == QAbstractSocket::ConnectedState
+                          && m_socket->localPort() == m_localPort;
+        if (m_peerConnected) {
+            qDebug() << "🔒 UDP socket connected to peer" << m_remoteAddress.toString() << ":" << m_remotePort;
+            return; // Чужие датаграммы ядро уже не доставит
+        }
+        // Не вышло - обычный сокет и фильтр ниже
+        qWarning() << "⚠️ Cannot connect UDP socket to peer, filtering by source list";
+        m_socket->close();
+        m_socket->bind(QHostAddress::Any, m_localPort);
+    }
+
+    QString error;
+    if (m_activeFilter.attachKernelFilter(m_socket->socketDescriptor(), &error)) {
+        qDebug() << "🔒 Kernel source filter:" << m_activeFilter.toString();
+    } else {
+        qDebug() << "🔒 Source filter:" << m_activeFilter.toString() << "(kernel filter not attached:" << error << ")";
+    }
+}
+
 void NetworkManager::onHeartbeatTimeout()
 {
     // Отправляем простой heartbeat (можно реализовать MAVLink heartbeat позже)
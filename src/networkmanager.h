@@ -1,12 +1,14 @@
 #ifndef NETWORKMANAGER_H
 #define NETWORKMANAGER_H
 
-#include <QObject>
 #include <QUdpSocket>
-#include <QTimer>
 #include <QHostAddress>
+#include "scheduler.h"
+#include "metrics.h"
+#include "mavlinklink.h"
+#include "sourcefilter.h"
 
-class NetworkManager : public QObject
+class NetworkManager : public MavlinkLink
 {
     Q_OBJECT
 
@@ -14,22 +16,25 @@ public:
     explicit NetworkManager(QObject *parent = nullptr);
     ~NetworkManager();
 
-    Q_PROPERTY(bool connected READ connected NOTIFY connectedChanged)
-    Q_PROPERTY(QString status READ status NOTIFY statusChanged)
+    bool connected() const override;
+    QString status() const override;
 
-    bool connected() const;
-    QString status() const;
+    // Локальный порт UDP (по умолчанию 14550); второму каналу UDP нужен свой
+    void setLocalPort(quint16 port);
+
+    // Разрешенные источники датаграмм. Пустой список - 192.168.1.0/24
+    // и сам адрес борта. Вступает в силу при следующем подключении.
+    void setSourceFilter(const SourceFilter &filter);
+    SourceFilter sourceFilter() const;
+
+    // connect() сокета к адресу и порту борта: остальные датаграммы
+    // отбрасывает ядро. Подходит, если борт отвечает с того же порта.
+    void setConnectToPeer(bool enabled);
 
 public slots:
     void connectToFC(const QString &ip, int port);
-    void disconnectFromFC();
-    void sendData(const QByteArray &data);
-
-signals:
-    void connectedChanged(bool connected);
-    void statusChanged(const QString &status);
-    void dataReceived(const QByteArray &data);
-    void errorOccurred(const QString &error);
+    void disconnectFromFC() override;
+    void sendData(const QByteArray &data) override;
 
 private slots:
     void onReadyRead();
@@ -41,8 +46,23 @@ private:
     QString m_status;
     QHostAddress m_remoteAddress;
     quint16 m_remotePort;
-    QTimer *m_heartbeatTimer;
+    quint16 m_localPort;
+    QHostAddress m_sender;
+    quint16 m_senderPort;
+    SourceFilter m_sourceFilter;    // заданный список
+    SourceFilter m_activeFilter;    // действующий для текущего подключения
+    bool m_connectToPeer;
+    bool m_peerConnected;
+    Scheduler::TaskId m_heartbeatTask;
+
+    Metrics::Counter *m_datagramsReceived;
+    Metrics::Counter *m_bytesReceived;
+    Metrics::Counter *m_datagramsRejected;
+    Metrics::Counter *m_datagramsSent;
+    Metrics::Counter *m_bytesSent;
+    Metrics::Counter *m_sendErrors;
 
+    void attachFilters(bool toPeer);
     QByteArray createMavlinkHeartbeat();
     void sendMavlinkHeartbeat();
 
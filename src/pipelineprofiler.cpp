@@ -0,0 +1,439 @@
+#include "pipelineprofiler.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJSEngine>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QThread>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define TRACE_USE_TSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace {
+
+// Период опроса буферов и обновления оверлея (2 Гц)
+constexpr int CollectIntervalMs = 500;
+// Сколько последних событий хранить для экспорта трассы
+constexpr int HistoryLimit = 65536;
+// Поток обработки, не получивший следующей стадии за 2 с, забываем
+constexpr double FlowTimeoutUs = 2e6;
+
+const char *const StageNames[Trace::StageCount] = {
+    "receive", "frame", "decode", "publish", "render"
+};
+
+qint64 steadyNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Счетчик тактов TSC на x86 (десятки тактов на чтение), иначе steady_clock
+inline quint64 rawTimestamp()
+{
+#ifdef TRACE_USE_TSC
+    return __rdtsc();
+#else
+    return quint64(steadyNowNs());
+#endif
+}
+
+struct RawEvent {
+    quint64 ts;
+    quint32 flow;
+    quint8 stage;
+};
+
+// Кольцевой буфер одного потока: пишет только поток-владелец,
+// читает только profiler в GUI-потоке
+struct TraceRing {
+    static constexpr quint32 Size = 8192;
+
+    RawEvent events[Size];
+    std::atomic<quint32> head{0};
+    std::atomic<quint32> tail{0};
+    std::atomic<quint64> dropped{0};
+    quint8 thread = 0;
+    QString name;
+};
+
+QMutex &ringMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+// Буферы живут до конца процесса: завершившийся поток мог оставить
+// в своем буфере еще не прочитанные события
+std::vector<TraceRing *> &ringList()
+{
+    static std::vector<TraceRing *> list;
+    return list;
+}
+
+TraceRing *registerRing()
+{
+    TraceRing *ring = new TraceRing;
+    QMutexLocker locker(&ringMutex());
+    ring->thread = quint8(ringList().size());
+    QThread *current = QThread::currentThread();
+    if (QCoreApplication::instance() && current == QCoreApplication::instance()->thread()) {
+        ring->name = "main";
+    } else if (!current->objectName().isEmpty()) {
+        ring->name = current->objectName();
+    } else {
+        ring->name = QString("thread %1").arg(ring->thread);
+    }
+    ringList().push_back(ring);
+    return ring;
+}
+
+// Калибровка перевода тактов в наносекунды: две опорные точки
+// (включение профилировщика и последний опрос)
+struct Calibration {
+    quint64 ticks0 = 0;
+    qint64 ns0 = 0;
+    double nsPerTick = 1.0;
+};
+
+Calibration s_calibration;
+
+thread_local quint32 t_currentFlow = 0;
+std::atomic<quint32> s_nextFlow{1};
+std::atomic<quint32> s_publishedFlow{0};
+std::atomic<quint32> s_renderedFlow{0};
+
+// Строка для JSON: имена потоков задает приложение и библиотеки
+QString jsonEscape(const QString &text)
+{
+    QString result;
+    result.reserve(text.size());
+    for (const QChar c : text) {
+        if (c == u'"' || c == u'\\') {
+            result += u'\\';
+            result += c;
+        } else if (c.unicode() < 0x20) {
+            result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+namespace Trace {
+
+std::atomic<bool> enabled{false};
+
+void record(Stage stage, quint32 flow)
+{
+    thread_local TraceRing *ring = registerRing();
+
+    const quint32 head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= TraceRing::Size) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    RawEvent &event = ring->events[head & (TraceRing::Size - 1)];
+    event.ts = rawTimestamp();
+    event.flow = flow;
+    event.stage = stage;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+quint32 beginFlow()
+{
+    // Без профилировщика - без записи в общий счетчик на каждой датаграмме
+    if (!enabled.load(std::memory_order_relaxed)) {
+        t_currentFlow = 0;
+        return 0;
+    }
+    t_currentFlow = s_nextFlow.fetch_add(1, std::memory_order_relaxed);
+    return t_currentFlow;
+}
+
+quint32 currentFlow()
+{
+    return t_currentFlow;
+}
+
+void published(quint32 flow)
+{
+    if (enabled.load(std::memory_order_relaxed)) {
+        s_publishedFlow.store(flow, std::memory_order_relaxed);
+    }
+}
+
+void rendered()
+{
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // Отмечаем только кадры, в которых появилось новое значение
+    const quint32 flow = s_publishedFlow.load(std::memory_order_relaxed);
+    if (flow != 0 && s_renderedFlow.exchange(flow, std::memory_order_relaxed) != flow) {
+        record(Render, flow);
+    }
+}
+
+} // namespace Trace
+
+PipelineProfiler::PipelineProfiler(QObject *parent)
+    : QObject(parent)
+    , m_collectTask(0)
+    , m_lastCollectUs(0.0)
+    , m_dropped(0)
+{
+}
+
+PipelineProfiler *PipelineProfiler::instance()
+{
+    static QPointer<PipelineProfiler> profiler;
+    if (!profiler) {
+        profiler = new PipelineProfiler(QCoreApplication::instance());
+    }
+    return profiler;
+}
+
+PipelineProfiler *PipelineProfiler::create(QQmlEngine *qmlEngine, QJSEngine *jsEngine)
+{
+    Q_UNUSED(qmlEngine)
+    Q_UNUSED(jsEngine)
+
+    PipelineProfiler *profiler = instance();
+    // Объектом владеет приложение, а не движок QML
+    QJSEngine::setObjectOwnership(profiler, QJSEngine::CppOwnership);
+    return profiler;
+}
+
+bool PipelineProfiler::enabled() const
+{
+    return Trace::enabled.load(std::memory_order_relaxed);
+}
+
+void PipelineProfiler::setEnabled(bool enabled)
+{
+    if (enabled == this->enabled()) {
+        return;
+    }
+
+    if (enabled) {
+        // Сбрасываем старые события, чтобы не смешивать сеансы
+        {
+            QMutexLocker locker(&ringMutex());
+            for (TraceRing *ring : ringList()) {
+                ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+            }
+        }
+        s_calibration.ticks0 = rawTimestamp();
+        s_calibration.ns0 = steadyNowNs();
+        s_calibration.nsPerTick = 1.0;
+        s_publishedFlow.store(0, std::memory_order_relaxed);
+        s_renderedFlow.store(0, std::memory_order_relaxed);
+
+        m_history.clear();
+        m_flowLastUs.clear();
+        for (StageStats &stats : m_window) {
+            stats = StageStats();
+        }
+        m_lastCollectUs = 0.0;
+
+        Trace::enabled.store(true, std::memory_order_relaxed);
+        m_collectTask = Scheduler::instance()->scheduleRepeating(CollectIntervalMs, this, [this]() {
+            collect();
+        }, CollectIntervalMs / 10);
+        qDebug() << "📈 Pipeline profiler enabled, timestamps:" << timestampSource();
+    } else {
+        Trace::enabled.store(false, std::memory_order_relaxed);
+        Scheduler::instance()->cancel(m_collectTask);
+        m_collectTask = 0;
+        collect();
+        qDebug() << "📈 Pipeline profiler disabled";
+    }
+
+    emit enabledChanged(enabled);
+}
+
+QString PipelineProfiler::timestampSource() const
+{
+#ifdef TRACE_USE_TSC
+    return "rdtsc";
+#else
+    return "steady_clock";
+#endif
+}
+
+QVariantList PipelineProfiler::stages() const
+{
+    return m_stages;
+}
+
+quint64 PipelineProfiler::droppedEvents() const
+{
+    return m_dropped;
+}
+
+void PipelineProfiler::collect()
+{
+    const quint64 nowTicks = rawTimestamp();
+    const qint64 nowNs = steadyNowNs();
+#ifdef TRACE_USE_TSC
+    // Частота TSC уточняется на всем интервале с момента включения
+    if (nowTicks > s_calibration.ticks0 && nowNs > s_calibration.ns0) {
+        s_calibration.nsPerTick = double(nowNs - s_calibration.ns0) / double(nowTicks - s_calibration.ticks0);
+    }
+#else
+    Q_UNUSED(nowTicks)
+#endif
+
+    // Забираем события из всех буферов
+    QList<Event> fresh;
+    quint64 dropped = 0;
+    {
+        QMutexLocker locker(&ringMutex());
+        for (TraceRing *ring : ringList()) {
+            const quint32 head = ring->head.load(std::memory_order_acquire);
+            quint32 tail = ring->tail.load(std::memory_order_relaxed);
+            for (; tail != head; ++tail) {
+                const RawEvent &raw = ring->events[tail & (TraceRing::Size - 1)];
+                const double us = (double(qint64(raw.ts - s_calibration.ticks0)) * s_calibration.nsPerTick) / 1000.0;
+                fresh.append({ us, raw.flow, raw.stage, ring->thread });
+            }
+            ring->tail.store(tail, std::memory_order_release);
+            dropped += ring->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    m_dropped = dropped;
+
+    // Стадии одного потока обработки могут лежать в разных буферах
+    std::sort(fresh.begin(), fresh.end(), [](const Event &a, const Event &b) {
+        return a.us < b.us;
+    });
+
+    for (const Event &event : fresh) {
+        StageStats &stats = m_window[event.stage];
+        stats.count++;
+
+        // Задержка считается от предыдущей стадии того же потока обработки
+        auto it = m_flowLastUs.find(event.flow);
+        if (event.stage != Trace::Receive && it != m_flowLastUs.end()) {
+            const double latencyUs = event.us - it.value();
+            stats.totalUs += latencyUs;
+            stats.maxUs = qMax(stats.maxUs, latencyUs);
+            stats.latencySamples++;
+        }
+        m_flowLastUs.insert(event.flow, event.us);
+    }
+
+    m_history.append(fresh);
+    if (m_history.size() > HistoryLimit) {
+        m_history.remove(0, m_history.size() - HistoryLimit);
+    }
+
+    const double nowUs = double(nowNs - s_calibration.ns0) / 1000.0;
+    for (auto it = m_flowLastUs.begin(); it != m_flowLastUs.end();) {
+        if (nowUs - it.value() > FlowTimeoutUs) {
+            it = m_flowLastUs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Пропускная способность и задержки за прошедшее окно
+    const double windowSec = qMax(1e-3, (nowUs - m_lastCollectUs) / 1e6);
+    m_lastCollectUs = nowUs;
+
+    m_stages.clear();
+    for (int stage = 0; stage < Trace::StageCount; ++stage) {
+        StageStats &stats = m_window[stage];
+        QVariantMap entry;
+        entry["name"] = StageNames[stage];
+        entry["rate"] = double(stats.count) / windowSec;
+        entry["avgUs"] = stats.latencySamples > 0 ? stats.totalUs / double(stats.latencySamples) : 0.0;
+        entry["maxUs"] = stats.maxUs;
+        m_stages.append(entry);
+        stats = StageStats();
+    }
+
+    emit statsChanged();
+}
+
+bool PipelineProfiler::exportChromeTrace(const QString &path)
+{
+    if (enabled()) {
+        collect();
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "❌ Cannot write trace file:" << path << file.errorString();
+        return false;
+    }
+
+    // Формат Trace Event: стадия - отрезок "X" от предыдущей стадии того же
+    // потока обработки, прием датаграммы - мгновенное событие "i"
+    QByteArray json;
+    json.reserve(m_history.size() * 96 + 256);
+    json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    {
+        QMutexLocker locker(&ringMutex());
+        for (const TraceRing *ring : ringList()) {
+            json += QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"%2\"}},\n")
+                        .arg(ring->thread)
+                        .arg(jsonEscape(ring->name))
+                        .toUtf8();
+        }
+    }
+
+    QHash<quint32, double> flowLastUs;
+    bool first = true;
+    for (const Event &event : m_history) {
+        if (!first) {
+            json += ",\n";
+        }
+        first = false;
+
+        auto it = flowLastUs.constFind(event.flow);
+        if (event.stage == Trace::Receive || it == flowLastUs.constEnd()) {
+            json += QString("{\"name\":\"%1\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%2,\"ts\":%3,\"args\":{\"flow\":%4}}")
+                        .arg(StageNames[event.stage])
+                        .arg(event.thread)
+                        .arg(event.us, 0, 'f', 3)
+                        .arg(event.flow)
+                        .toUtf8();
+        } else {
+            json += QString("{\"name\":\"%1\",\"ph\":\"X\",\"pid\":1,\"tid\":%2,\"ts\":%3,\"dur\":%4,\"args\":{\"flow\":%5}}")
+                        .arg(StageNames[event.stage])
+                        .arg(event.thread)
+                        .arg(it.value(), 0, 'f', 3)
+                        .arg(event.us - it.value(), 0, 'f', 3)
+                        .arg(event.flow)
+                        .toUtf8();
+        }
+        flowLastUs.insert(event.flow, event.us);
+    }
+    json += "\n]}\n";
+
+    if (file.write(json) != json.size()) {
+        qWarning() << "❌ Failed to write trace file:" << path << file.errorString();
+        return false;
+    }
+
+    qDebug() << "📈 Pipeline trace exported:" << path << m_history.size() << "events";
+    return true;
+}
@@ -0,0 +1,110 @@
+#ifndef PIPELINEPROFILER_H
+#define PIPELINEPROFILER_H
+
+#include <QObject>
+#include <QHash>
+#include <QVariantList>
+#include <QtQml/qqmlregistration.h>
+#include <atomic>
+#include "scheduler.h"
+
+class QQmlEngine;
+class QJSEngine;
+
+// Точки трассировки горячего пути "датаграмма -> экран".
+// Компилируются всегда; пока профилировщик выключен, точка стоит одну
+// relaxed-загрузку флага. События пишутся в кольцевые буферы потоков.
+namespace Trace {
+
+enum Stage : quint8 {
+    Receive,    // датаграмма прочитана из сокета
+    Frame,      // найден кадр MAVLink
+    Decode,     // сообщение разобрано
+    Publish,    // значение передано в QML (сигнал)
+    Render,     // кадр с новым значением выведен на экран
+    StageCount
+};
+
+extern std::atomic<bool> enabled;
+
+void record(Stage stage, quint32 flow);
+
+inline void point(Stage stage, quint32 flow)
+{
+    if (enabled.load(std::memory_order_relaxed)) {
+        record(stage, flow);
+    }
+}
+
+// Идентификатор потока обработки: выдается при приеме датаграммы и
+// сопровождает ее по всем стадиям в том же потоке выполнения
+// (0 - профилировщик выключен)
+quint32 beginFlow();
+quint32 currentFlow();
+
+// Публикация значения (GUI-поток) и вывод кадра (поток рендера)
+void published(quint32 flow);
+void rendered();
+
+} // namespace Trace
+
+class PipelineProfiler : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_SINGLETON
+
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(QVariantList stages READ stages NOTIFY statsChanged)
+    Q_PROPERTY(QString timestampSource READ timestampSource CONSTANT)
+    Q_PROPERTY(quint64 droppedEvents READ droppedEvents NOTIFY statsChanged)
+
+public:
+    static PipelineProfiler *instance();
+    static PipelineProfiler *create(QQmlEngine *qmlEngine, QJSEngine *jsEngine);
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    // Для каждой стадии: name, rate (событий/с), avgUs и maxUs от предыдущей стадии
+    QVariantList stages() const;
+    QString timestampSource() const;
+    // События, не поместившиеся в кольцевые буферы
+    quint64 droppedEvents() const;
+
+    // Экспорт последних событий в формате Chrome Trace (chrome://tracing, Perfetto)
+    Q_INVOKABLE bool exportChromeTrace(const QString &path);
+
+signals:
+    void enabledChanged(bool enabled);
+    void statsChanged();
+
+private:
+    explicit PipelineProfiler(QObject *parent = nullptr);
+
+    struct StageStats {
+        quint64 count = 0;
+        double totalUs = 0.0;
+        double maxUs = 0.0;
+        quint64 latencySamples = 0;
+    };
+
+    struct Event {
+        double us;
+        quint32 flow;
+        quint8 stage;
+        quint8 thread;
+    };
+
+    void collect();
+
+    Scheduler::TaskId m_collectTask;
+    QList<Event> m_history;
+    QHash<quint32, double> m_flowLastUs;
+    StageStats m_window[Trace::StageCount];
+    QVariantList m_stages;
+    double m_lastCollectUs;
+    quint64 m_dropped;
+};
+
+#endif // PIPELINEPROFILER_H
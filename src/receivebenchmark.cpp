@@ -0,0 +1,119 @@
+#include "receivebenchmark.h"
+#include "allocationcounter.h"
+#include "bufferpool.h"
+#include "mavlinkhandler.h"
+#include "mavlinkprotocol.h"
+#include <QElapsedTimer>
+#include <QList>
+#include <cmath>
+
+namespace ReceiveBenchmark {
+
+namespace {
+
+// 256 кадров подряд: номера последовательности продолжаются при повторе потока
+constexpr int FramesPerPass = 256;
+constexpr int WarmupPasses = 4;
+
+// Поток, похожий на телеметрию ArduPilot: ATTITUDE чаще остальных
+QByteArray buildStream()
+{
+    QByteArray stream;
+    for (int i = 0; i < FramesPerPass; i++) {
+        const quint32 timeBootMs = 1000 + quint32(i) * 20;
+        QByteArray payload;
+        quint32 msgId;
+        switch (i % 4) {
+        case 0:
+        case 2:
+            msgId = Mavlink::MsgAttitude;
+            Mavlink::appendField<quint32>(payload, timeBootMs);
+            Mavlink::appendField<float>(payload, 0.3f * std::sin(i * 0.05f));
+            Mavlink::appendField<float>(payload, 0.1f * std::cos(i * 0.05f));
+            Mavlink::appendField<float>(payload, 1.5f);
+            Mavlink::appendField<float>(payload, 0.01f);
+            Mavlink::appendField<float>(payload, -0.02f);
+            Mavlink::appendField<float>(payload, 0.03f);
+            break;
+        case 1:
+            msgId = Mavlink::MsgGlobalPositionInt;
+            Mavlink::appendField<quint32>(payload, timeBootMs);
+            Mavlink::appendField<qint32>(payload, 557000000);
+            Mavlink::appendField<qint32>(payload, 376000000);
+            Mavlink::appendField<qint32>(payload, 150000);
+            Mavlink::appendField<qint32>(payload, 20000);
+            Mavlink::appendField<qint16>(payload, 100);
+            Mavlink::appendField<qint16>(payload, -50);
+            Mavlink::appendField<qint16>(payload, 0);
+            Mavlink::appendField<quint16>(payload, 9000);
+            break;
+        default:
+            msgId = (i % 8 == 3) ? Mavlink::MsgHeartbeat : Mavlink::MsgSysStatus;
+            payload.fill('\0', msgId == Mavlink::MsgHeartbeat ? 9 : 31);
+            break;
+        }
+        stream.append(Mavlink::packMessage(msgId, payload, 1, 1));
+    }
+    return stream;
+}
+
+// Датаграммы разной длины, кадры режутся на границах
+QList<QByteArray> splitStream(const QByteArray &stream)
+{
+    static const int sizes[] = { 96, 180, 37, 512, 64, 250, 141 };
+    QList<QByteArray> datagrams;
+    int pos = 0;
+    for (int i = 0; pos < stream.size(); i++) {
+        const int size = qMin(sizes[i % 7], int(stream.size()) - pos);
+        datagrams.append(stream.mid(pos, size));
+        pos += size;
+    }
+    return datagrams;
+}
+
+void feedPass(MavlinkHandler *handler, const QList<QByteArray> &datagrams)
+{
+    for (const QByteArray &datagram : datagrams) {
+        // Как в NetworkManager::onReadyRead: чтение в буфер из пула
+        BufferPool::Lease lease(int(datagram.size()));
+        memcpy(lease.buffer().data(), datagram.constData(), size_t(datagram.size()));
+        handler->feedData(lease.buffer());
+    }
+}
+
+} // namespace
+
+Result run(MavlinkHandler *handler, int frames)
+{
+    const QList<QByteArray> datagrams = splitStream(buildStream());
+    const int passes = qMax(1, (frames + FramesPerPass - 1) / FramesPerPass);
+
+    // Прогрев: счетчики метрик по msgid, таблицы последовательностей, пул
+    for (int pass = 0; pass < WarmupPasses; pass++) {
+        feedPass(handler, datagrams);
+    }
+
+    Result result;
+    const quint64 parsedBefore = handler->framesParsed();
+    const quint64 missesBefore = BufferPool::missCount();
+    const quint64 bytesBefore = AllocationCounter::bytes();
+    AllocationCounter::Scope scope;
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int pass = 0; pass < passes; pass++) {
+        feedPass(handler, datagrams);
+    }
+
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    result.allocations = scope.count();
+    result.allocatedBytes = AllocationCounter::bytes() - bytesBefore;
+    result.poolMisses = BufferPool::missCount() - missesBefore;
+    result.frames = quint64(passes) * FramesPerPass;
+    result.parsed = handler->framesParsed() - parsedBefore;
+    result.datagrams = quint64(passes) * quint64(datagrams.size());
+    result.nsPerFrame = double(elapsedNs) / double(result.frames);
+    return result;
+}
+
+} // namespace ReceiveBenchmark
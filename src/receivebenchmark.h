@@ -0,0 +1,31 @@
+#ifndef RECEIVEBENCHMARK_H
+#define RECEIVEBENCHMARK_H
+
+#include <QtGlobal>
+
+class MavlinkHandler;
+
+// Прогон синтетического потока через прием -> разбор -> публикацию
+// (буфер из BufferPool -> MavlinkHandler::feedData -> LinkManager ->
+// разбор) с подсчетом выделений памяти на кадр. Сокет не участвует: внутри
+// QUdpSocket::readDatagram Qt создает свои объекты, на них мы повлиять не можем.
+namespace ReceiveBenchmark {
+
+struct Result {
+    quint64 frames = 0;
+    quint64 datagrams = 0;
+    quint64 parsed = 0;        // дошли до разбора; меньше frames - кадры теряются
+    quint64 allocations = 0;   // в установившемся режиме, после прогрева
+    quint64 allocatedBytes = 0;
+    quint64 poolMisses = 0;
+    double nsPerFrame = 0.0;
+
+    double allocationsPerFrame() const { return frames ? double(allocations) / frames : 0.0; }
+    bool complete() const { return parsed == frames; }
+};
+
+Result run(MavlinkHandler *handler, int frames);
+
+} // namespace ReceiveBenchmark
+
+#endif // RECEIVEBENCHMARK_H
@@ -0,0 +1,43 @@
+#include "rttestimator.h"
+#include <cmath>
+
+void RttEstimator::setInitialRtt(double rttMs)
+{
+    if (rttMs > 0.0) {
+        m_initialRttNs = rttMs * 1e6;
+    }
+}
+
+void RttEstimator::sample(qint64 rttNs)
+{
+    const double r = double(rttNs);
+    if (m_srttNs <= 0.0) {
+        m_srttNs = r;
+        m_rttVarNs = r / 2.0;
+    } else {
+        m_rttVarNs = 0.75 * m_rttVarNs + 0.25 * std::abs(m_srttNs - r);
+        m_srttNs = 0.875 * m_srttNs + 0.125 * r;
+    }
+}
+
+void RttEstimator::reset()
+{
+    m_srttNs = 0.0;
+    m_rttVarNs = 0.0;
+}
+
+double RttEstimator::rttNs() const
+{
+    return m_srttNs > 0.0 ? m_srttNs : m_initialRttNs;
+}
+
+double RttEstimator::rttMs() const
+{
+    return rttNs() / 1e6;
+}
+
+qint64 RttEstimator::rtoNs() const
+{
+    const double rto = m_srttNs > 0.0 ? m_srttNs + 4.0 * m_rttVarNs : 3.0 * m_initialRttNs;
+    return qBound(MinRtoNs, qint64(rto), MaxRtoNs);
+}
@@ -0,0 +1,35 @@
+#ifndef RTTESTIMATOR_H
+#define RTTESTIMATOR_H
+
+#include <QtGlobal>
+
+// Оценка RTT и таймаута повтора по RFC 6298 для транзакций с бортом
+// (команды, миссия, FTP). Замеры - только по запросам без повторов
+// (алгоритм Карна), иначе ответ нельзя отнести к конкретной отправке.
+// До первого замера таймаут считается от начальной оценки, например
+// RTT из TIMESYNC.
+class RttEstimator
+{
+public:
+    static constexpr double DefaultRttNs = 500e6;
+    static constexpr qint64 MinRtoNs = 100000000LL;
+    static constexpr qint64 MaxRtoNs = 5000000000LL;
+
+    // Значения <= 0 игнорируются
+    void setInitialRtt(double rttMs);
+    void sample(qint64 rttNs);
+
+    // Новый сеанс: замеры заново, начальная оценка остается
+    void reset();
+
+    double rttNs() const;   // сглаженный RTT или начальная оценка
+    double rttMs() const;
+    qint64 rtoNs() const;
+
+private:
+    double m_srttNs = 0.0;
+    double m_rttVarNs = 0.0;
+    double m_initialRttNs = DefaultRttNs;
+};
+
+#endif // RTTESTIMATOR_H
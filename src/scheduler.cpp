@@ -0,0 +1,272 @@
+#include "scheduler.h"
+#include <QCoreApplication>
+#include <QDebug>
+
+Scheduler::Scheduler(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_currentTick(0)
+    , m_nextId(1)
+    , m_wakeups(0)
+    , m_tasksMetric(Metrics::gauge("scheduler_tasks", "Tasks queued in the shared scheduler"))
+    , m_wakeupsMetric(Metrics::counter("scheduler_wakeups_total", "Scheduler timer wakeups"))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &Scheduler::onTimeout);
+    m_clock.start();
+}
+
+Scheduler::~Scheduler()
+{
+    m_timer->stop();
+}
+
+Scheduler *Scheduler::instance()
+{
+    static QPointer<Scheduler> scheduler;
+    if (!scheduler) {
+        scheduler = new Scheduler(QCoreApplication::instance());
+    }
+    return scheduler;
+}
+
+Scheduler::TaskId Scheduler::schedule(int delayMs, QObject *context, Task task, int slackMs)
+{
+    return addTask(delayMs, 0, context, std::move(task), slackMs);
+}
+
+Scheduler::TaskId Scheduler::scheduleRepeating(int intervalMs, QObject *context, Task task, int slackMs)
+{
+    return addTask(intervalMs, qMax(intervalMs, TickMs), context, std::move(task), slackMs);
+}
+
+void Scheduler::cancel(TaskId id)
+{
+    // Записи в колесе удаляются лениво при проходе слота
+    m_tasks.remove(id);
+    m_tasksMetric->set(m_tasks.size());
+    if (m_tasks.isEmpty()) {
+        m_timer->stop();
+    }
+}
+
+bool Scheduler::isScheduled(TaskId id) const
+{
+    return m_tasks.contains(id);
+}
+
+int Scheduler::taskCount() const
+{
+    return m_tasks.size();
+}
+
+quint64 Scheduler::wakeups() const
+{
+    return m_wakeups;
+}
+
+quint64 Scheduler::nowTick() const
+{
+    return quint64(m_clock.elapsed()) / TickMs;
+}
+
+quint64 Scheduler::alignDeadline(quint64 tick, quint32 slackTicks)
+{
+    if (slackTicks == 0) {
+        return tick;
+    }
+
+    // Наибольшая степень двойки <= slack + 1: задачи с одинаковым допуском
+    // попадают на одни и те же тики и обслуживаются одним пробуждением
+    quint64 granularity = 1;
+    while ((granularity << 1) <= quint64(slackTicks) + 1) {
+        granularity <<= 1;
+    }
+    return (tick + granularity - 1) & ~(granularity - 1);
+}
+
+Scheduler::TaskId Scheduler::addTask(int delayMs, int intervalMs, QObject *context, Task task, int slackMs)
+{
+    if (m_tasks.isEmpty()) {
+        m_currentTick = nowTick();
+    }
+
+    const TaskId id = m_nextId++;
+    TaskData data;
+    data.task = std::move(task);
+    data.context = context;
+    data.hasContext = context != nullptr;
+    data.intervalTicks = quint32((intervalMs + TickMs - 1) / TickMs);
+    data.slackTicks = quint32(qMax(slackMs, 0) / TickMs);
+    data.nominalTick = nowTick() + quint64(qMax(1, (delayMs + TickMs - 1) / TickMs));
+    data.deadlineTick = alignDeadline(data.nominalTick, data.slackTicks);
+
+    TaskData &stored = m_tasks[id];
+    stored = std::move(data);
+    insert(id, stored);
+    rearm();
+    return id;
+}
+
+void Scheduler::insert(TaskId id, TaskData &data)
+{
+    if (data.deadlineTick <= m_currentTick) {
+        data.deadlineTick = m_currentTick + 1;
+    }
+    data.generation++;
+
+    // Уровень выбирается по расстоянию до срока; дальние задачи
+    // спускаются на нижние уровни при каскадировании
+    const quint64 maxDelta = (quint64(1) << (WheelBits * WheelLevels)) - 1;
+    const quint64 delta = qMin(data.deadlineTick - m_currentTick, maxDelta);
+    const quint64 placeTick = m_currentTick + delta;
+
+    int level = 0;
+    while (level < WheelLevels - 1 && delta >= (quint64(1) << (WheelBits * (level + 1)))) {
+        level++;
+    }
+
+    const int slot = int((placeTick >> (WheelBits * level)) & (WheelSize - 1));
+    m_wheel[level][slot].push_back({ id, data.generation });
+}
+
+void Scheduler::cascade(int level)
+{
+    const int slot = int((m_currentTick >> (WheelBits * level)) & (WheelSize - 1));
+    std::vector<Entry> entries;
+    entries.swap(m_wheel[level][slot]);
+
+    for (const Entry &entry : entries) {
+        auto it = m_tasks.find(entry.id);
+        if (it == m_tasks.end() || it.value().generation != entry.generation) {
+            continue;
+        }
+
+        // Срок совпал с границей уровня - задача выполняется в этом же тике
+        if (it.value().deadlineTick <= m_currentTick) {
+            m_wheel[0][m_currentTick & (WheelSize - 1)].push_back(entry);
+        } else {
+            insert(entry.id, it.value());
+        }
+    }
+}
+
+void Scheduler::advanceTo(quint64 tick)
+{
+    while (m_currentTick < tick && !m_tasks.isEmpty()) {
+        m_currentTick++;
+
+        // Переход через границу уровня - спускаем задачи с верхних уровней
+        for (int level = 1; level < WheelLevels; ++level) {
+            if ((m_currentTick & ((quint64(1) << (WheelBits * level)) - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+
+        runSlot(m_wheel[0][m_currentTick & (WheelSize - 1)]);
+    }
+
+    if (m_tasks.isEmpty()) {
+        m_currentTick = tick;
+    }
+}
+
+void Scheduler::runSlot(std::vector<Entry> &slot)
+{
+    if (slot.empty()) {
+        return;
+    }
+
+    std::vector<Entry> entries;
+    entries.swap(slot);
+
+    for (const Entry &entry : entries) {
+        auto it = m_tasks.find(entry.id);
+        if (it == m_tasks.end() || it.value().generation != entry.generation) {
+            continue;
+        }
+
+        TaskData &data = it.value();
+        if (data.hasContext && !data.context) {
+            m_tasks.erase(it);
+            continue;
+        }
+
+        Task task = data.task;
+        if (data.intervalTicks > 0) {
+            // Следующий срок считаем от номинального, чтобы период не уплывал
+            data.nominalTick += data.intervalTicks;
+            if (data.nominalTick <= m_currentTick) {
+                data.nominalTick = m_currentTick + data.intervalTicks;
+            }
+            data.deadlineTick = alignDeadline(data.nominalTick, data.slackTicks);
+            insert(entry.id, data);
+        } else {
+            m_tasks.erase(it);
+        }
+
+        task();
+    }
+}
+
+quint64 Scheduler::nextWakeTick() const
+{
+    if (m_tasks.isEmpty()) {
+        return 0;
+    }
+
+    // Каскадирование выполняется попутно в advanceTo(), поэтому просыпаться
+    // нужно только к ближайшему сроку. Внутри уровня слоты упорядочены по
+    // времени, достаточно первого слота с живыми задачами на каждом уровне.
+    // Текущий слот любого уровня хранит только задачи через полный оборот
+    // (срок на уровне >= 1 всегда в следующих слотах), поэтому он идет последним.
+    quint64 next = 0;
+    for (int level = 0; level < WheelLevels; ++level) {
+        const int shift = WheelBits * level;
+        for (int offset = 1; offset <= WheelSize; ++offset) {
+            const quint64 base = (m_currentTick >> shift) + offset;
+            quint64 earliest = 0;
+            for (const Entry &entry : m_wheel[level][base & (WheelSize - 1)]) {
+                auto it = m_tasks.constFind(entry.id);
+                if (it == m_tasks.constEnd() || it.value().generation != entry.generation) {
+                    continue;
+                }
+                if (earliest == 0 || it.value().deadlineTick < earliest) {
+                    earliest = it.value().deadlineTick;
+                }
+            }
+            if (earliest != 0) {
+                if (next == 0 || earliest < next) {
+                    next = earliest;
+                }
+                break;
+            }
+        }
+    }
+
+    return next;
+}
+
+void Scheduler::rearm()
+{
+    m_tasksMetric->set(m_tasks.size());
+
+    const quint64 next = nextWakeTick();
+    if (next == 0) {
+        m_timer->stop();
+        return;
+    }
+
+    const qint64 delayMs = qint64(next) * TickMs - m_clock.elapsed();
+    m_timer->start(int(qMax<qint64>(0, delayMs)));
+}
+
+void Scheduler::onTimeout()
+{
+    m_wakeups++;
+    m_wakeupsMetric->add();
+    advanceTo(nowTick());
+    rearm();
+}
@@ -0,0 +1,91 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QTimer>
+#include <functional>
+#include <vector>
+#include "metrics.h"
+
+// Общий планировщик периодических задач и повторов на иерархическом
+// колесе таймеров. Все задачи (heartbeat, замер частоты, повторные запросы)
+// обслуживаются одним QTimer, который взводится только на ближайший срок.
+// Задачи с допуском (slackMs) выравниваются по общей сетке, чтобы
+// срабатывать в одно пробуждение. Используется только из GUI-потока.
+class Scheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef quint64 TaskId;
+    typedef std::function<void()> Task;
+
+    static constexpr int TickMs = 10;
+
+    explicit Scheduler(QObject *parent = nullptr);
+    ~Scheduler();
+
+    // Общий экземпляр приложения
+    static Scheduler *instance();
+
+    // Однократный вызов через delayMs. Если context удален - задача отменяется.
+    TaskId schedule(int delayMs, QObject *context, Task task, int slackMs = 0);
+
+    // Периодический вызов с интервалом intervalMs
+    TaskId scheduleRepeating(int intervalMs, QObject *context, Task task, int slackMs = 0);
+
+    void cancel(TaskId id);
+    bool isScheduled(TaskId id) const;
+
+    int taskCount() const;
+    quint64 wakeups() const;
+
+private slots:
+    void onTimeout();
+
+private:
+    static constexpr int WheelBits = 6;
+    static constexpr int WheelSize = 1 << WheelBits;
+    static constexpr int WheelLevels = 4;
+
+    struct Entry {
+        TaskId id;
+        quint32 generation;
+    };
+
+    struct TaskData {
+        Task task;
+        QPointer<QObject> context;
+        quint64 nominalTick = 0;  // срок без учета выравнивания
+        quint64 deadlineTick = 0; // фактический срок в колесе
+        quint32 intervalTicks = 0;
+        quint32 slackTicks = 0;
+        quint32 generation = 0;
+        bool hasContext = false;
+    };
+
+    TaskId addTask(int delayMs, int intervalMs, QObject *context, Task task, int slackMs);
+    void insert(TaskId id, TaskData &data);
+    void cascade(int level);
+    void advanceTo(quint64 tick);
+    void runSlot(std::vector<Entry> &slot);
+    void rearm();
+    quint64 nextWakeTick() const;
+    quint64 nowTick() const;
+    static quint64 alignDeadline(quint64 tick, quint32 slackTicks);
+
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    quint64 m_currentTick;
+    TaskId m_nextId;
+    quint64 m_wakeups;
+    QHash<TaskId, TaskData> m_tasks;
+    Metrics::Gauge *m_tasksMetric;
+    Metrics::Counter *m_wakeupsMetric;
+    std::vector<Entry> m_wheel[WheelLevels][WheelSize];
+};
+
+#endif // SCHEDULER_H
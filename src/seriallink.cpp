@@ -0,0 +1,128 @@
+#include "seriallink.h"
+#include "bufferpool.h"
+#include "pipelineprofiler.h"
+#include <QDebug>
+
+SerialLink::SerialLink(QObject *parent)
+    : MavlinkLink(parent)
+    , m_port(new QSerialPort(this))
+    , m_connected(false)
+    , m_status("Disconnected")
+    , m_bytesReceived(Metrics::counter("mavlink_serial_bytes_received_total", "Bytes read from serial links"))
+    , m_bytesSent(Metrics::counter("mavlink_serial_bytes_sent_total", "Bytes written to serial links"))
+    , m_errors(Metrics::counter("mavlink_serial_errors_total", "Serial port errors"))
+{
+    connect(m_port, &QSerialPort::readyRead, this, &SerialLink::onReadyRead);
+    connect(m_port, &QSerialPort::errorOccurred, this, &SerialLink::onErrorOccurred);
+}
+
+SerialLink::~SerialLink()
+{
+    if (m_port->isOpen()) {
+        m_port->close();
+    }
+}
+
+bool SerialLink::connected() const
+{
+    return m_connected;
+}
+
+QString SerialLink::status() const
+{
+    return m_status;
+}
+
+void SerialLink::connectToPort(const QString &portName, int baudRate)
+{
+    if (m_connected) {
+        disconnectFromFC();
+    }
+
+    m_port->setPortName(portName);
+    m_port->setBaudRate(baudRate);
+    m_port->setDataBits(QSerialPort::Data8);
+    m_port->setParity(QSerialPort::NoParity);
+    m_port->setStopBits(QSerialPort::OneStop);
+    m_port->setFlowControl(QSerialPort::NoFlowControl);
+
+    if (!m_port->open(QIODevice::ReadWrite)) {
+        setStatus(QString("Serial open failed: %1").arg(m_port->errorString()));
+        emit errorOccurred(m_port->errorString());
+        return;
+    }
+
+    m_connected = true;
+    setStatus(QString("Serial connected to %1 @ %2").arg(portName).arg(baudRate));
+    emit connectedChanged(true);
+    qDebug() << "🔌 Serial connected to" << portName << "@" << baudRate;
+}
+
+void SerialLink::disconnectFromFC()
+{
+    if (m_port->isOpen()) {
+        m_port->close();
+    }
+    if (m_connected) {
+        m_connected = false;
+        emit connectedChanged(false);
+    }
+    setStatus("Disconnected");
+}
+
+void SerialLink::sendData(const QByteArray &data)
+{
+    if (!m_connected || data.isEmpty()) {
+        return;
+    }
+    const qint64 written = m_port->write(data);
+    if (written < 0) {
+        m_errors->add();
+        qDebug() << "Failed to write serial data:" << m_port->errorString();
+    } else {
+        m_bytesSent->add(quint64(written));
+    }
+}
+
+void SerialLink::onReadyRead()
+{
+    while (m_port->bytesAvailable() > 0) {
+        BufferPool::Lease lease(int(qMin<qint64>(m_port->bytesAvailable(), BufferPool::BufferSize)));
+        QByteArray &chunk = lease.buffer();
+
+        const qint64 bytesRead = m_port->read(chunk.data(), chunk.size());
+        if (bytesRead <= 0) {
+            break;
+        }
+        Trace::point(Trace::Receive, Trace::beginFlow());
+        chunk.resize(int(bytesRead));
+        m_bytesReceived->add(quint64(bytesRead));
+        emit dataReceived(chunk);
+    }
+}
+
+void SerialLink::onErrorOccurred(QSerialPort::SerialPortError error)
+{
+    if (error == QSerialPort::NoError) {
+        return;
+    }
+    m_errors->add();
+    qWarning() << "⚠️ Serial port error:" << m_port->portName() << m_port->errorString();
+
+    // Отключение USB или пропажа устройства: канал потерян, LinkManager переключится
+    if (error == QSerialPort::ResourceError || error == QSerialPort::DeviceNotFoundError
+        || error == QSerialPort::PermissionError) {
+        const QString message = m_port->errorString();
+        disconnectFromFC();
+        setStatus(QString("Serial link lost: %1").arg(message));
+        emit errorOccurred(message);
+    }
+}
+
+void SerialLink::setStatus(const QString &status)
+{
+    if (m_status != status) {
+        m_status = status;
+        emit statusChanged(m_status);
+    }
+}
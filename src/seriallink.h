@@ -0,0 +1,42 @@
+#ifndef SERIALLINK_H
+#define SERIALLINK_H
+
+#include <QSerialPort>
+#include "mavlinklink.h"
+#include "metrics.h"
+
+// Канал MAVLink через последовательный порт (радиомодем, USB полетного контроллера).
+// Порт - сплошной поток байтов, кадры собирает LinkManager.
+class SerialLink : public MavlinkLink
+{
+    Q_OBJECT
+
+public:
+    explicit SerialLink(QObject *parent = nullptr);
+    ~SerialLink();
+
+    bool connected() const override;
+    QString status() const override;
+
+public slots:
+    void connectToPort(const QString &portName, int baudRate = 57600);
+    void disconnectFromFC() override;
+    void sendData(const QByteArray &data) override;
+
+private slots:
+    void onReadyRead();
+    void onErrorOccurred(QSerialPort::SerialPortError error);
+
+private:
+    void setStatus(const QString &status);
+
+    QSerialPort *m_port;
+    bool m_connected;
+    QString m_status;
+
+    Metrics::Counter *m_bytesReceived;
+    Metrics::Counter *m_bytesSent;
+    Metrics::Counter *m_errors;
+};
+
+#endif // SERIALLINK_H
@@ -0,0 +1,308 @@
+#include "sha256.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SHA256_HAVE_X86_SHANI 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SHA256_TARGET_SHANI
+#else
+#include <cpuid.h>
+#define SHA256_TARGET_SHANI __attribute__((target("sha,sse4.1,ssse3")))
+#endif
+#endif
+
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#define SHA256_HAVE_ARMV8_CE 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+alignas(16) const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+const uint32_t InitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+typedef void (*CompressFn)(uint32_t state[8], const uint8_t *data, size_t blocks);
+
+inline uint32_t rotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+void compressGeneric(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    uint32_t w[64];
+
+    while (blocks--) {
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (uint32_t(data[i * 4]) << 24) | (uint32_t(data[i * 4 + 1]) << 16)
+                 | (uint32_t(data[i * 4 + 2]) << 8) | uint32_t(data[i * 4 + 3]);
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int i = 0; i < 64; ++i) {
+            uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + S1 + ch + K[i] + w[i];
+            uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = S0 + maj;
+
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+
+        data += 64;
+    }
+}
+
+#ifdef SHA256_HAVE_X86_SHANI
+SHA256_TARGET_SHANI
+void compressShaNi(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // Раскладка состояния под sha256rnds2: ABEF / CDGH
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    while (blocks--) {
+        const __m128i abefSave = state0;
+        const __m128i cdghSave = state1;
+        __m128i msg[4];
+
+        for (int i = 0; i < 16; ++i) {
+            if (i < 4) {
+                msg[i] = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * 16)), MASK);
+            }
+
+            __m128i m = _mm_add_epi32(msg[i & 3],
+                                      _mm_load_si128(reinterpret_cast<const __m128i *>(&K[i * 4])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+
+            if (i >= 3 && i <= 14) {
+                __m128i t = _mm_alignr_epi8(msg[i & 3], msg[(i - 1) & 3], 4);
+                msg[(i + 1) & 3] = _mm_add_epi32(msg[(i + 1) & 3], t);
+                msg[(i + 1) & 3] = _mm_sha256msg2_epu32(msg[(i + 1) & 3], msg[i & 3]);
+            }
+
+            m = _mm_shuffle_epi32(m, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+
+            if (i >= 1 && i <= 12) {
+                msg[(i - 1) & 3] = _mm_sha256msg1_epu32(msg[(i - 1) & 3], msg[i & 3]);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[4]), state1);
+}
+
+bool cpuHasShaNi()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+        return false;
+    __cpuid(regs, 1);
+    const bool ssse3 = regs[2] & (1 << 9);
+    const bool sse41 = regs[2] & (1 << 19);
+    __cpuidex(regs, 7, 0);
+    return ssse3 && sse41 && (regs[1] & (1 << 29));
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    const bool ssse3 = ecx & (1u << 9);
+    const bool sse41 = ecx & (1u << 19);
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return false;
+    return ssse3 && sse41 && (ebx & (1u << 29));
+#endif
+}
+#endif // SHA256_HAVE_X86_SHANI
+
+#ifdef SHA256_HAVE_ARMV8_CE
+void compressArmv8(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    uint32x4_t state0 = vld1q_u32(&state[0]);
+    uint32x4_t state1 = vld1q_u32(&state[4]);
+
+    while (blocks--) {
+        const uint32x4_t abcdSave = state0;
+        const uint32x4_t efghSave = state1;
+        uint32x4_t msg[4];
+
+        for (int i = 0; i < 4; ++i)
+            msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + i * 16)));
+
+        for (int i = 0; i < 16; ++i) {
+            const uint32x4_t wk = vaddq_u32(msg[i & 3], vld1q_u32(&K[i * 4]));
+            if (i < 12)
+                msg[i & 3] = vsha256su0q_u32(msg[i & 3], msg[(i + 1) & 3]);
+
+            const uint32x4_t prev = state0;
+            state0 = vsha256hq_u32(state0, state1, wk);
+            state1 = vsha256h2q_u32(state1, prev, wk);
+
+            if (i < 12)
+                msg[i & 3] = vsha256su1q_u32(msg[i & 3], msg[(i + 2) & 3], msg[(i + 3) & 3]);
+        }
+
+        state0 = vaddq_u32(state0, abcdSave);
+        state1 = vaddq_u32(state1, efghSave);
+        data += 64;
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+#endif // SHA256_HAVE_ARMV8_CE
+
+struct Backend {
+    CompressFn compress;
+    const char *name;
+};
+
+Backend selectBackend()
+{
+#ifdef SHA256_HAVE_X86_SHANI
+    if (cpuHasShaNi())
+        return { compressShaNi, "sha-ni" };
+#endif
+#ifdef SHA256_HAVE_ARMV8_CE
+    return { compressArmv8, "armv8-ce" };
+#endif
+    return { compressGeneric, "generic" };
+}
+
+const Backend &backend()
+{
+    static const Backend selected = selectBackend();
+    return selected;
+}
+
+} // namespace
+
+Sha256::Sha256()
+{
+    reset();
+}
+
+void Sha256::reset()
+{
+    memcpy(m_state, InitialState, sizeof(m_state));
+    m_totalLen = 0;
+    m_blockLen = 0;
+}
+
+void Sha256::update(const void *data, size_t len)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    const CompressFn compress = backend().compress;
+    m_totalLen += len;
+
+    if (m_blockLen > 0) {
+        size_t take = BlockSize - m_blockLen;
+        if (take > len)
+            take = len;
+        memcpy(m_block + m_blockLen, p, take);
+        m_blockLen += take;
+        p += take;
+        len -= take;
+        if (m_blockLen < BlockSize)
+            return;
+        compress(m_state, m_block, 1);
+        m_blockLen = 0;
+    }
+
+    if (len >= BlockSize) {
+        const size_t blocks = len / BlockSize;
+        compress(m_state, p, blocks);
+        p += blocks * BlockSize;
+        len -= blocks * BlockSize;
+    }
+
+    if (len > 0) {
+        memcpy(m_block, p, len);
+        m_blockLen = len;
+    }
+}
+
+void Sha256::finish(uint8_t digest[DigestSize])
+{
+    const uint64_t bitLen = m_totalLen * 8;
+    const CompressFn compress = backend().compress;
+
+    m_block[m_blockLen++] = 0x80;
+    if (m_blockLen > BlockSize - 8) {
+        memset(m_block + m_blockLen, 0, BlockSize - m_blockLen);
+        compress(m_state, m_block, 1);
+        m_blockLen = 0;
+    }
+    memset(m_block + m_blockLen, 0, BlockSize - 8 - m_blockLen);
+    for (int i = 0; i < 8; ++i)
+        m_block[BlockSize - 1 - i] = uint8_t(bitLen >> (i * 8));
+    compress(m_state, m_block, 1);
+
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = uint8_t(m_state[i] >> 24);
+        digest[i * 4 + 1] = uint8_t(m_state[i] >> 16);
+        digest[i * 4 + 2] = uint8_t(m_state[i] >> 8);
+        digest[i * 4 + 3] = uint8_t(m_state[i]);
+    }
+
+    reset();
+}
+
+void Sha256::hash(const void *data, size_t len, uint8_t digest[DigestSize])
+{
+    Sha256 ctx;
+    ctx.update(data, len);
+    ctx.finish(digest);
+}
+
+const char *Sha256::backendName()
+{
+    return backend().name;
+}
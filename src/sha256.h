@@ -0,0 +1,34 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+
+// SHA-256 для подписи MAVLink2.
+// Сжатие блока выбирается один раз при старте: SHA-NI на x86-64,
+// ARMv8 Crypto Extensions на AArch64, иначе портируемая реализация.
+class Sha256
+{
+public:
+    static constexpr int DigestSize = 32;
+    static constexpr int BlockSize = 64;
+
+    Sha256();
+
+    void reset();
+    void update(const void *data, size_t len);
+    void finish(uint8_t digest[DigestSize]);
+
+    static void hash(const void *data, size_t len, uint8_t digest[DigestSize]);
+
+    // Имя используемой реализации ("sha-ni", "armv8-ce", "generic")
+    static const char *backendName();
+
+private:
+    uint32_t m_state[8];
+    uint8_t m_block[BlockSize];
+    uint64_t m_totalLen;
+    size_t m_blockLen;
+};
+
+#endif // SHA256_H
@@ -0,0 +1,247 @@
+#include "sourcefilter.h"
+#include <QStringList>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <linux/filter.h>
+#include <sys/socket.h>
+#endif
+
+namespace {
+
+bool parsePorts(const QString &text, quint16 *from, quint16 *to)
+{
+    const QStringList parts = text.split('-');
+    if (parts.isEmpty() || parts.size() > 2) {
+        return false;
+    }
+    bool ok1 = false;
+    bool ok2 = false;
+    const uint first = parts[0].toUInt(&ok1);
+    const uint last = parts.size() == 2 ? parts[1].toUInt(&ok2) : first;
+    if (!ok1 || (parts.size() == 2 && !ok2) || first == 0 || first > 65535 || last < first || last > 65535) {
+        return false;
+    }
+    *from = quint16(first);
+    *to = quint16(last);
+    return true;
+}
+
+bool prefixMatches(const Q_IPV6ADDR &address, const Q_IPV6ADDR &network, int prefix)
+{
+    int i = 0;
+    for (; prefix >= 8; prefix -= 8, i++) {
+        if (address[i] != network[i]) {
+            return false;
+        }
+    }
+    if (prefix > 0) {
+        const quint8 mask = quint8(0xFF << (8 - prefix));
+        return (address[i] & mask) == network[i];
+    }
+    return true;
+}
+
+} // namespace
+
+bool SourceFilter::parse(const QString &spec, QString *error)
+{
+    SourceFilter parsed;
+    for (QString entry : spec.split(',', Qt::SkipEmptyParts)) {
+        entry = entry.trimmed();
+        if (entry.isEmpty()) {
+            continue;
+        }
+
+        // Адрес с префиксом и необязательные порты после последнего ':'
+        QString addressPart = entry;
+        QString portPart;
+        if (entry.startsWith('[')) {
+            const int close = entry.indexOf(']');
+            if (close < 0) {
+                if (error) *error = QString("Missing ']' in \"%1\"").arg(entry);
+                return false;
+            }
+            const int colon = entry.indexOf(':', close);
+            addressPart = entry.mid(1, close - 1) + (colon < 0 ? entry.mid(close + 1) : entry.mid(close + 1, colon - close - 1));
+            portPart = colon < 0 ? QString() : entry.mid(colon + 1);
+        } else {
+            const int colon = entry.lastIndexOf(':');
+            if (colon >= 0) {
+                addressPart = entry.left(colon);
+                portPart = entry.mid(colon + 1);
+            }
+        }
+
+        quint16 portFrom = 0;
+        quint16 portTo = 65535;
+        if (!portPart.isEmpty() && !parsePorts(portPart, &portFrom, &portTo)) {
+            if (error) *error = QString("Invalid port range in \"%1\"").arg(entry);
+            return false;
+        }
+
+        if (addressPart == "*") {
+            parsed.addRule(QHostAddress(QHostAddress::AnyIPv4), 0, portFrom, portTo);
+            parsed.addRule(QHostAddress(QHostAddress::AnyIPv6), 0, portFrom, portTo);
+            continue;
+        }
+
+        const QPair<QHostAddress, int> subnet = QHostAddress::parseSubnet(addressPart);
+        if (subnet.first.isNull() || !parsed.addRule(subnet.first, subnet.second, portFrom, portTo)) {
+            if (error) *error = QString("Invalid address in \"%1\"").arg(entry);
+            return false;
+        }
+    }
+
+    m_rules = parsed.m_rules;
+    return true;
+}
+
+bool SourceFilter::addRule(const QHostAddress &network, int prefix, quint16 portFrom, quint16 portTo)
+{
+    Rule rule;
+    rule.portFrom = portFrom;
+    rule.portTo = portTo;
+
+    bool isIPv4 = false;
+    const quint32 ipv4 = network.toIPv4Address(&isIPv4);
+    if (isIPv4 && network.protocol() == QHostAddress::IPv4Protocol) {
+        if (prefix < 0 || prefix > 32) {
+            return false;
+        }
+        rule.prefix = prefix;
+        rule.mask = prefix == 0 ? 0 : ~quint32(0) << (32 - prefix);
+        rule.network = ipv4 & rule.mask;
+    } else if (network.protocol() == QHostAddress::IPv6Protocol) {
+        if (prefix < 0 || prefix > 128) {
+            return false;
+        }
+        rule.ipv6 = true;
+        rule.prefix = prefix;
+        rule.network6 = network.toIPv6Address();
+        // Биты за префиксом обнуляем, чтобы сравнение было побайтным
+        for (int bit = prefix; bit < 128; bit++) {
+            rule.network6[bit / 8] &= quint8(~(0x80 >> (bit % 8)));
+        }
+    } else {
+        return false;
+    }
+
+    m_rules.append(rule);
+    return true;
+}
+
+void SourceFilter::clear()
+{
+    m_rules.clear();
+}
+
+bool SourceFilter::isEmpty() const
+{
+    return m_rules.isEmpty();
+}
+
+const QList<SourceFilter::Rule> &SourceFilter::rules() const
+{
+    return m_rules;
+}
+
+QString SourceFilter::toString() const
+{
+    QStringList entries;
+    for (const Rule &rule : m_rules) {
+        QString entry = rule.ipv6
+                            ? QString("[%1]/%2").arg(QHostAddress(rule.network6).toString()).arg(rule.prefix)
+                            : QString("%1/%2").arg(QHostAddress(rule.network).toString()).arg(rule.prefix);
+        if (rule.portFrom != 0 || rule.portTo != 65535) {
+            entry += rule.portFrom == rule.portTo ? QString(":%1").arg(rule.portFrom)
+                                                  : QString(":%1-%2").arg(rule.portFrom).arg(rule.portTo);
+        }
+        entries.append(entry);
+    }
+    return entries.join(", ");
+}
+
+bool SourceFilter::accepts(const QHostAddress &address, quint16 port) const
+{
+    if (m_rules.isEmpty()) {
+        return true;
+    }
+
+    // IPv4 (в том числе IPv4-mapped IPv6 двухстекового сокета) - одно целое
+    bool isIPv4 = false;
+    const quint32 ipv4 = address.toIPv4Address(&isIPv4);
+    Q_IPV6ADDR ipv6 {};
+    if (!isIPv4) {
+        ipv6 = address.toIPv6Address();
+    }
+
+    for (const Rule &rule : m_rules) {
+        if (port < rule.portFrom || port > rule.portTo) {
+            continue;
+        }
+        if (isIPv4) {
+            if (!rule.ipv6 && (ipv4 & rule.mask) == rule.network) {
+                return true;
+            }
+        } else if (rule.ipv6 && prefixMatches(ipv6, rule.network6, rule.prefix)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SourceFilter::attachKernelFilter(qintptr socketDescriptor, QString *error) const
+{
+#ifdef Q_OS_LINUX
+    // Программа classic BPF: IPv4 - сравнение адреса отправителя с каждой сетью,
+    // IPv6 пропускается в пространство пользователя, если есть IPv6-правила.
+    bool hasIPv6 = false;
+    QList<const Rule *> ipv4Rules;
+    for (const Rule &rule : m_rules) {
+        if (rule.ipv6) {
+            hasIPv6 = true;
+        } else if (rule.prefix == 0) {
+            if (error) *error = "rule matches every IPv4 source";
+            return false;
+        } else {
+            ipv4Rules.append(&rule);
+        }
+    }
+    if (m_rules.isEmpty() || ipv4Rules.size() > 64) {
+        if (error) *error = m_rules.isEmpty() ? "empty allowlist" : "too many rules";
+        return false;
+    }
+
+    const quint32 acceptAll = 0x40000;
+    std::vector<sock_filter> program;
+    // 0: версия IP из первого байта сетевого заголовка
+    program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, quint32(SKF_NET_OFF)));
+    program.push_back(BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0xF0));
+    program.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x40, 1, 0));
+    program.push_back(BPF_STMT(BPF_RET | BPF_K, hasIPv6 ? acceptAll : 0));
+    // Адрес отправителя IPv4: смещение 12 в заголовке
+    for (const Rule *rule : ipv4Rules) {
+        program.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, quint32(SKF_NET_OFF + 12)));
+        program.push_back(BPF_STMT(BPF_ALU | BPF_AND | BPF_K, rule->mask));
+        program.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, rule->network, 0, 1));
+        program.push_back(BPF_STMT(BPF_RET | BPF_K, acceptAll));
+    }
+    program.push_back(BPF_STMT(BPF_RET | BPF_K, 0));
+
+    sock_fprog fprog;
+    fprog.len = static_cast<unsigned short>(program.size());
+    fprog.filter = program.data();
+    if (setsockopt(int(socketDescriptor), SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) != 0) {
+        if (error) *error = QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(socketDescriptor);
+    if (error) *error = "socket filters are not supported on this platform";
+    return false;
+#endif
+}
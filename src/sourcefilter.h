@@ -0,0 +1,48 @@
+#ifndef SOURCEFILTER_H
+#define SOURCEFILTER_H
+
+#include <QHostAddress>
+#include <QList>
+#include <QString>
+
+// Список разрешенных источников датаграмм: сеть CIDR и диапазон портов.
+// Правила разбираются один раз в целые числа, проверка датаграммы - несколько
+// сравнений без строк. Адресная часть IPv4-правил может быть перенесена в ядро
+// (Linux, SO_ATTACH_FILTER): чужие датаграммы отбрасываются до копирования
+// в сокет и не будят поток GUI.
+//
+// Формат: правила через запятую, каждое - адрес[/префикс][:порт[-порт]],
+// IPv6 в квадратных скобках, * - любой адрес:
+//   192.168.1.0/24, 10.0.0.7:14555, *:14550-14560, [fd00::]/8
+class SourceFilter
+{
+public:
+    struct Rule {
+        bool ipv6 = false;
+        quint32 network = 0;    // IPv4, уже с наложенной маской
+        quint32 mask = 0;
+        Q_IPV6ADDR network6 {};
+        int prefix = 0;
+        quint16 portFrom = 0;
+        quint16 portTo = 65535;
+    };
+
+    bool parse(const QString &spec, QString *error = nullptr);
+    bool addRule(const QHostAddress &network, int prefix, quint16 portFrom = 0, quint16 portTo = 65535);
+    void clear();
+
+    bool isEmpty() const;       // пустой список пропускает все
+    const QList<Rule> &rules() const;
+    QString toString() const;
+
+    bool accepts(const QHostAddress &address, quint16 port) const;
+
+    // Фильтр по адресу отправителя в ядре (только IPv4-правила, порты
+    // по-прежнему проверяет accepts). false, если не поддерживается.
+    bool attachKernelFilter(qintptr socketDescriptor, QString *error = nullptr) const;
+
+private:
+    QList<Rule> m_rules;
+};
+
+#endif // SOURCEFILTER_H
@@ -0,0 +1,79 @@
+#include "startuptimer.h"
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <chrono>
+
+namespace {
+
+// Отсчет идет от статической инициализации - самая ранняя точка,
+// доступная без платформенных API
+const std::chrono::steady_clock::time_point ProcessStart = std::chrono::steady_clock::now();
+
+QMutex &phaseMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+QList<StartupTimer::Phase> &phaseList()
+{
+    static QList<StartupTimer::Phase> list;
+    return list;
+}
+
+} // namespace
+
+double StartupTimer::elapsedMs()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ProcessStart).count();
+}
+
+bool StartupTimer::mark(const QString &phase)
+{
+    const double ms = elapsedMs();
+    {
+        QMutexLocker locker(&phaseMutex());
+        for (const Phase &existing : phaseList()) {
+            if (existing.name == phase) {
+                return false;
+            }
+        }
+        phaseList().append({ phase, ms });
+    }
+
+    qInfo().noquote() << QString("⏱️ Startup: %1 at %2 ms").arg(phase).arg(ms, 0, 'f', 1);
+    return true;
+}
+
+bool StartupTimer::hasPhase(const QString &phase)
+{
+    QMutexLocker locker(&phaseMutex());
+    for (const Phase &existing : phaseList()) {
+        if (existing.name == phase) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QList<StartupTimer::Phase> StartupTimer::phases()
+{
+    QMutexLocker locker(&phaseMutex());
+    return phaseList();
+}
+
+QString StartupTimer::report()
+{
+    const QList<Phase> list = phases();
+    QString text = "Startup phases (ms since process start):\n";
+    double previous = 0.0;
+    for (const Phase &phase : list) {
+        text += QString("  %1 %2  (+%3)\n")
+                    .arg(phase.name, -18)
+                    .arg(phase.ms, 9, 'f', 1)
+                    .arg(phase.ms - previous, 0, 'f', 1);
+        previous = phase.ms;
+    }
+    return text;
+}
@@ -0,0 +1,28 @@
+#ifndef STARTUPTIMER_H
+#define STARTUPTIMER_H
+
+#include <QList>
+#include <QString>
+
+// Отметки фаз запуска приложения относительно старта процесса:
+// process start -> engine ready -> first frame -> first telemetry.
+// mark() можно вызывать из любого потока (first frame приходит из потока рендера).
+class StartupTimer
+{
+public:
+    struct Phase {
+        QString name;
+        double ms;
+    };
+
+    // Возвращает false, если фаза уже была отмечена
+    static bool mark(const QString &phase);
+    static bool hasPhase(const QString &phase);
+    static double elapsedMs();
+    static QList<Phase> phases();
+
+    // Таблица фаз для лога и командной строки
+    static QString report();
+};
+
+#endif // STARTUPTIMER_H
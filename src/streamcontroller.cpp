@@ -0,0 +1,310 @@
+#include "streamcontroller.h"
+#include "commandmanager.h"
+#include "mavlinkprotocol.h"
+#include "messageinspector.h"
+#include <QDebug>
+#include <QVariantMap>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double DefaultFrameBytes = 40.0;  // пока длина кадра не измерена
+constexpr int MaxSequenceGap = 100;         // больше - перезапуск борта или переупорядочивание
+
+constexpr quint8 ResultDenied = 2;          // MAV_RESULT_DENIED
+constexpr quint8 ResultUnsupported = 3;     // MAV_RESULT_UNSUPPORTED
+
+} // namespace
+
+StreamController::StreamController(CommandManager *commands, MessageInspector *inspector, QObject *parent)
+    : QObject(parent)
+    , m_commands(commands)
+    , m_inspector(inspector)
+    , m_enabled(true)
+    , m_running(false)
+    , m_budget(DefaultBudget)
+    , m_scale(1.0)
+    , m_loss(0.0)
+    , m_plannedBandwidth(0.0)
+    , m_targetSystem(1)
+    , m_targetComponent(1)
+    , m_received(0)
+    , m_lost(0)
+    , m_controlTask(0)
+{
+    m_clock.start();
+
+    // Потоки, которые запрашивает приложение, от важного к второстепенному
+    setStream(Mavlink::MsgAttitude, 0, 5.0, 50.0);
+    setStream(Mavlink::MsgGlobalPositionInt, 1, 1.0, 10.0);
+    setStream(Mavlink::MsgSysStatus, 2, 1.0, 5.0);
+    setStream(Mavlink::MsgVfrHud, 3, 1.0, 10.0);
+}
+
+StreamController::~StreamController()
+{
+    Scheduler::instance()->cancel(m_controlTask);
+}
+
+bool StreamController::enabled() const
+{
+    return m_enabled;
+}
+
+void StreamController::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+    m_enabled = enabled;
+    if (m_running) {
+        if (enabled) {
+            start(m_targetSystem, m_targetComponent);
+        } else {
+            Scheduler::instance()->cancel(m_controlTask);
+            m_controlTask = 0;
+        }
+    }
+    emit enabledChanged();
+}
+
+int StreamController::budget() const
+{
+    return m_budget;
+}
+
+void StreamController::setBudget(int bytesPerSecond)
+{
+    if (bytesPerSecond <= 0 || m_budget == bytesPerSecond) {
+        return;
+    }
+    m_budget = bytesPerSecond;
+    emit budgetChanged();
+}
+
+void StreamController::setStream(quint32 msgId, int priority, double minHz, double maxHz)
+{
+    Stream *stream = find(msgId);
+    if (!stream) {
+        m_streams.append(Stream());
+        stream = &m_streams.last();
+        stream->msgId = msgId;
+    }
+    stream->priority = priority;
+    stream->maxHz = qMax(0.0, maxHz);
+    stream->minHz = qBound(0.0, minHz, stream->maxHz);
+
+    std::stable_sort(m_streams.begin(), m_streams.end(), [](const Stream &a, const Stream &b) {
+        return a.priority < b.priority;
+    });
+}
+
+void StreamController::setMaxRate(quint32 msgId, double maxHz)
+{
+    Stream *stream = find(msgId);
+    if (stream) {
+        setStream(msgId, stream->priority, qMin(stream->minHz, maxHz), maxHz);
+    }
+}
+
+double StreamController::scale() const
+{
+    return m_scale;
+}
+
+double StreamController::loss() const
+{
+    return m_loss;
+}
+
+double StreamController::plannedBandwidth() const
+{
+    return m_plannedBandwidth;
+}
+
+QVariantList StreamController::streams() const
+{
+    QVariantList result;
+    for (const Stream &stream : m_streams) {
+        const char *name = Mavlink::messageName(stream.msgId);
+        QVariantMap entry;
+        entry["name"] = name ? QString::fromLatin1(name) : QString::number(stream.msgId);
+        entry["priority"] = stream.priority;
+        entry["minHz"] = stream.minHz;
+        entry["maxHz"] = stream.maxHz;
+        entry["plannedHz"] = stream.plannedHz;
+        entry["requestedHz"] = stream.requestedHz;
+        entry["deliveredHz"] = stream.deliveredHz;
+        entry["state"] = stream.unsupported ? "unsupported" : stream.pending ? "pending" : "ok";
+        result.append(entry);
+    }
+    return result;
+}
+
+void StreamController::start(quint8 targetSystem, quint8 targetComponent)
+{
+    m_targetSystem = targetSystem;
+    m_targetComponent = targetComponent;
+    m_running = true;
+    m_scale = 1.0;
+    m_loss = 0.0;
+    m_received = 0;
+    m_lost = 0;
+    for (Stream &stream : m_streams) {
+        stream.requestedHz = 0.0;
+        stream.deliveredHz = 0.0;
+        stream.pending = false;
+        stream.unsupported = false;
+        stream.lastCommandMs = -1;
+    }
+
+    Scheduler::instance()->cancel(m_controlTask);
+    m_controlTask = 0;
+    if (!m_enabled) {
+        return;
+    }
+    m_controlTask = Scheduler::instance()->scheduleRepeating(ControlIntervalMs, this, [this]() {
+        control();
+    }, ControlIntervalMs / 10);
+
+    // Первый план сразу, по оценкам длины кадров
+    control();
+}
+
+void StreamController::stop()
+{
+    m_running = false;
+    Scheduler::instance()->cancel(m_controlTask);
+    m_controlTask = 0;
+}
+
+void StreamController::recordFrame(quint8 sysid, int lost)
+{
+    if (sysid != m_targetSystem) {
+        return;
+    }
+    m_received++;
+    if (lost > 0 && lost <= MaxSequenceGap) {
+        m_lost += quint64(lost);
+    }
+}
+
+void StreamController::control()
+{
+    // Потери за период: AIMD по доле используемого бюджета
+    const quint64 total = m_received + m_lost;
+    if (total >= quint64(MinLossSamples)) {
+        m_loss = double(m_lost) / double(total);
+        if (m_loss > LossHigh) {
+            m_scale = qMax(MinScale, m_scale * DecreaseFactor);
+        } else if (m_loss < LossLow) {
+            m_scale = qMin(1.0, m_scale + IncreaseStep);
+        }
+    }
+    m_received = 0;
+    m_lost = 0;
+
+    plan();
+    apply();
+    emit updated();
+}
+
+void StreamController::plan()
+{
+    // Полоса сообщений вне управления (HEARTBEAT, ответы на команды и т.п.)
+    // вычитается из бюджета; длина кадра - измеренная средняя
+    QList<double> frameBytes;
+    double managedBandwidth = 0.0;
+    for (Stream &stream : m_streams) {
+        const MessageInspector::Stats stats = m_inspector->stats(m_targetSystem, m_targetComponent, stream.msgId);
+        stream.deliveredHz = stats.rateHz;
+        frameBytes.append(stats.frameBytes > 0.0 ? stats.frameBytes : DefaultFrameBytes);
+        managedBandwidth += stats.bytesPerSec;
+    }
+    const double other = qMax(0.0, m_inspector->totalBandwidth() - managedBandwidth);
+    double available = m_budget * m_scale - other;
+
+    // Сначала минимум каждому, затем остаток по приоритету
+    for (int i = 0; i < m_streams.size(); i++) {
+        Stream &stream = m_streams[i];
+        stream.plannedHz = stream.unsupported ? 0.0 : stream.minHz;
+        available -= stream.plannedHz * frameBytes[i];
+    }
+    for (int i = 0; i < m_streams.size() && available > 0.0; i++) {
+        Stream &stream = m_streams[i];
+        if (stream.unsupported) {
+            continue;
+        }
+        const double extra = qMin(stream.maxHz - stream.minHz, available / frameBytes[i]);
+        // Шаг 0.5 Гц, чтобы мелкие колебания оценок не меняли план
+        stream.plannedHz = qMax(stream.minHz, std::floor((stream.minHz + extra) * 2.0) / 2.0);
+        available -= (stream.plannedHz - stream.minHz) * frameBytes[i];
+    }
+
+    m_plannedBandwidth = 0.0;
+    for (int i = 0; i < m_streams.size(); i++) {
+        m_plannedBandwidth += m_streams[i].plannedHz * frameBytes[i];
+    }
+}
+
+void StreamController::apply()
+{
+    const qint64 now = m_clock.elapsed();
+    for (Stream &stream : m_streams) {
+        if (stream.unsupported || stream.pending) {
+            continue;
+        }
+        const bool waited = stream.lastCommandMs < 0 || now - stream.lastCommandMs >= RestoreIntervalMs;
+        bool needed = false;
+        if (stream.requestedHz <= 0.0) {
+            // Еще не подтвержден - повтор после паузы (повторы внутри ведет CommandManager)
+            needed = waited;
+        } else if (std::abs(stream.plannedHz - stream.requestedHz) > ChangeThreshold * stream.requestedHz) {
+            needed = true;
+        } else if (stream.deliveredHz < 0.2 * stream.requestedHz && waited) {
+            // Поток пропал при чистом канале: перезагрузка борта сбрасывает интервалы
+            needed = m_loss < LossHigh;
+        }
+        if (needed) {
+            send(stream);
+        }
+    }
+}
+
+void StreamController::send(Stream &stream)
+{
+    stream.pending = true;
+    stream.lastCommandMs = m_clock.elapsed();
+
+    const quint32 msgId = stream.msgId;
+    const double hz = stream.plannedHz;
+    const qint32 intervalUs = hz > 0.0 ? qRound(1e6 / hz) : -1; // -1 - выключить поток
+    m_commands->setMessageInterval(m_targetSystem, m_targetComponent, msgId, intervalUs)
+        .then(this, [this, msgId, hz](CommandResult result) {
+            Stream *stream = find(msgId);
+            if (!stream) {
+                return;
+            }
+            stream->pending = false;
+            if (result.accepted()) {
+                stream->requestedHz = hz;
+            } else if (result.result == ResultUnsupported || result.result == ResultDenied) {
+                // Борт не управляет этим потоком - больше не трогаем до нового сеанса
+                stream->unsupported = true;
+                qWarning() << "⚠️ Stream" << msgId << "rate not controllable:" << result.resultName();
+            }
+            emit updated();
+        });
+    qDebug() << "🎚️ Stream" << msgId << "->" << hz << "Hz (budget" << m_budget * m_scale << "B/s)";
+}
+
+StreamController::Stream *StreamController::find(quint32 msgId)
+{
+    for (Stream &stream : m_streams) {
+        if (stream.msgId == msgId) {
+            return &stream;
+        }
+    }
+    return nullptr;
+}
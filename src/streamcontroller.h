@@ -0,0 +1,116 @@
+#ifndef STREAMCONTROLLER_H
+#define STREAMCONTROLLER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QVariantList>
+#include <QtQml/qqmlregistration.h>
+#include "scheduler.h"
+
+class CommandManager;
+class MessageInspector;
+
+// Частоты потоков телеметрии в пределах полосы канала.
+// Раз в ControlIntervalMs бюджет (байт/с) делится между потоками по
+// приоритету: сначала каждому минимальная частота, затем остаток по
+// порядку важности до максимальной. Размер кадра и полоса прочих сообщений
+// берутся из MessageInspector, потери - по пропускам seq. При потерях
+// выше LossHigh используемая доля бюджета уменьшается мультипликативно,
+// при чистом канале растет аддитивно (AIMD), так что перегрузку гасят
+// прежде всего младшие потоки, а не все разом.
+//
+// Частоты ставятся через MAV_CMD_SET_MESSAGE_INTERVAL с подтверждением;
+// команда уходит только при заметном изменении плана, одна на поток.
+class StreamController : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Provided by MavlinkHandler.streams")
+
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(int budget READ budget WRITE setBudget NOTIFY budgetChanged)
+    Q_PROPERTY(double scale READ scale NOTIFY updated)
+    Q_PROPERTY(double loss READ loss NOTIFY updated)
+    Q_PROPERTY(double plannedBandwidth READ plannedBandwidth NOTIFY updated)
+    Q_PROPERTY(QVariantList streams READ streams NOTIFY updated)
+
+public:
+    static constexpr int ControlIntervalMs = 1000;
+    static constexpr int DefaultBudget = 5000;      // байт/с, радиомодем SiK на 57600
+    static constexpr double LossHigh = 0.05;
+    static constexpr double LossLow = 0.01;
+    static constexpr double DecreaseFactor = 0.7;
+    static constexpr double IncreaseStep = 0.05;    // доля бюджета за период
+    static constexpr double MinScale = 0.2;
+    static constexpr double ChangeThreshold = 0.1;  // меньшие изменения плана не отправляются
+    static constexpr int MinLossSamples = 20;       // кадров за период для решения по потерям
+    static constexpr int RestoreIntervalMs = 5000;  // повтор пропавшего или не подтвержденного потока
+
+    StreamController(CommandManager *commands, MessageInspector *inspector, QObject *parent = nullptr);
+    ~StreamController();
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+    int budget() const;
+    void setBudget(int bytesPerSecond);
+
+    // priority 0 - самый важный; частоты в Гц
+    void setStream(quint32 msgId, int priority, double minHz, double maxHz);
+    void setMaxRate(quint32 msgId, double maxHz);
+
+    double scale() const;
+    double loss() const;
+    double plannedBandwidth() const;
+    QVariantList streams() const;
+
+    void start(quint8 targetSystem, quint8 targetComponent);
+    void stop();
+
+    // Кадр от борта и число пропущенных перед ним (по seq)
+    void recordFrame(quint8 sysid, int lost);
+
+signals:
+    void enabledChanged();
+    void budgetChanged();
+    void updated();
+
+private:
+    struct Stream {
+        quint32 msgId = 0;
+        int priority = 0;
+        double minHz = 0.0;
+        double maxHz = 0.0;
+        double plannedHz = 0.0;
+        double requestedHz = 0.0;   // подтверждено бортом, 0 - еще нет
+        double deliveredHz = 0.0;
+        bool pending = false;
+        bool unsupported = false;
+        qint64 lastCommandMs = -1;
+    };
+
+    void control();
+    void plan();
+    void apply();
+    void send(Stream &stream);
+    Stream *find(quint32 msgId);
+
+    CommandManager *m_commands;
+    MessageInspector *m_inspector;
+    QList<Stream> m_streams;        // по приоритету
+
+    bool m_enabled;
+    bool m_running;
+    int m_budget;
+    double m_scale;
+    double m_loss;
+    double m_plannedBandwidth;
+    quint8 m_targetSystem;
+    quint8 m_targetComponent;
+    quint64 m_received;
+    quint64 m_lost;
+    QElapsedTimer m_clock;
+    Scheduler::TaskId m_controlTask;
+};
+
+#endif // STREAMCONTROLLER_H
@@ -0,0 +1,230 @@
+#include "timesync.h"
+#include "mavlinkprotocol.h"
+#include <QDateTime>
+#include <QDebug>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+// Количество отсчетов, после которого оценка считается устойчивой
+constexpr int ConvergedSamples = 5;
+constexpr int UsableSamples = 3;
+
+// Коэффициенты alpha-beta фильтра смещения
+constexpr double AlphaInitial = 0.5;
+constexpr double AlphaConverged = 0.1;
+constexpr double BetaConverged = 0.005;
+constexpr double MaxDrift = 500e-6; // 500 ppm
+
+// Скачок больше 100 мс три раза подряд - перезагрузка борта, сбрасываем оценку
+constexpr double ResetThresholdNs = 100e6;
+constexpr int ResetOutliers = 3;
+
+constexpr qint64 MaxRttNs = 10000000000LL;
+
+constexpr double LatencySmoothing = 0.1;
+
+} // namespace
+
+TimeSync::TimeSync(QObject *parent)
+    : QObject(parent)
+    , m_requestTask(0)
+    , m_epochBaseNs(QDateTime::currentMSecsSinceEpoch() * 1000000LL - hostNowNs())
+{
+}
+
+qint64 TimeSync::hostNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TimeSync::start(int intervalMs)
+{
+    Scheduler::instance()->cancel(m_requestTask);
+    m_requestTask = Scheduler::instance()->scheduleRepeating(intervalMs, this, [this]() {
+        sendRequest();
+    }, intervalMs / 10);
+    sendRequest();
+}
+
+void TimeSync::stop()
+{
+    Scheduler::instance()->cancel(m_requestTask);
+    m_requestTask = 0;
+}
+
+void TimeSync::clear()
+{
+    m_clocks.clear();
+    m_latencies.clear();
+}
+
+QByteArray TimeSync::createTimesync(qint64 tc1, qint64 ts1, quint8 targetSystem) const
+{
+    QByteArray payload;
+    Mavlink::appendField<qint64>(payload, tc1);
+    Mavlink::appendField<qint64>(payload, ts1);
+    payload.append(char(targetSystem));
+    payload.append(char(0)); // target_component
+
+    return Mavlink::packMessage(Mavlink::MsgTimesync, payload);
+}
+
+void TimeSync::sendRequest()
+{
+    // Широковещательный запрос: отвечают все аппараты на линке
+    emit frameReady(createTimesync(0, hostNowNs(), 0));
+}
+
+void TimeSync::handleTimesync(quint8 sysid, const char *payload, int payloadLen, qint64 rxNs)
+{
+    const qint64 tc1 = Mavlink::readField<qint64>(payload, payloadLen, 0);
+    const qint64 ts1 = Mavlink::readField<qint64>(payload, payloadLen, 8);
+    const quint8 targetSystem = Mavlink::readField<quint8>(payload, payloadLen, 16);
+
+    if (tc1 == 0) {
+        // Запрос от борта - отвечаем своим временем
+        emit frameReady(createTimesync(rxNs, ts1, sysid));
+        return;
+    }
+
+    // Ответ другой наземной станции
+    if (targetSystem != 0 && targetSystem != Mavlink::GcsSystemId) {
+        return;
+    }
+
+    updateEstimate(sysid, tc1, ts1, rxNs);
+}
+
+void TimeSync::updateEstimate(quint8 sysid, qint64 vehicleNs, qint64 sentNs, qint64 rxNs)
+{
+    const qint64 rtt = rxNs - sentNs;
+    if (rtt < 0 || rtt > MaxRttNs) {
+        return;
+    }
+
+    // Предполагаем симметричный канал: борт ответил в середине RTT
+    const double sampleOffset = (double(sentNs) + double(rxNs)) / 2.0 - double(vehicleNs);
+    ClockState &st = m_clocks[sysid];
+
+    if (st.samples == 0) {
+        st.offsetNs = sampleOffset;
+        st.drift = 0.0;
+        st.rttNs = double(rtt);
+        st.lastUpdateNs = rxNs;
+        st.samples = 1;
+        st.outliers = 0;
+        return;
+    }
+
+    // Пакеты, застрявшие в очереди радиомодема, дают смещенную оценку
+    if (st.samples >= ConvergedSamples && rtt > 3.0 * st.rttNs + 1e6) {
+        return;
+    }
+
+    const double dt = double(rxNs - st.lastUpdateNs);
+    const double predicted = st.offsetNs + st.drift * dt;
+    const double residual = sampleOffset - predicted;
+
+    if (std::abs(residual) > ResetThresholdNs) {
+        if (++st.outliers >= ResetOutliers) {
+            qDebug() << "⏱️ TIMESYNC offset jump for system" << sysid << "- resetting clock estimate";
+            const bool wasSynchronized = st.samples >= UsableSamples;
+            st = ClockState();
+            if (wasSynchronized) {
+                emit synchronizedChanged(sysid, false);
+            }
+            updateEstimate(sysid, vehicleNs, sentNs, rxNs);
+        }
+        return;
+    }
+    st.outliers = 0;
+
+    const bool converged = st.samples >= ConvergedSamples;
+    st.offsetNs = predicted + (converged ? AlphaConverged : AlphaInitial) * residual;
+    if (converged && dt > 0.0) {
+        st.drift = qBound(-MaxDrift, st.drift + BetaConverged * residual / dt, MaxDrift);
+    }
+    st.rttNs += 0.1 * (double(rtt) - st.rttNs);
+    st.lastUpdateNs = rxNs;
+    st.samples++;
+
+    if (st.samples == UsableSamples) {
+        qDebug() << "⏱️ Clock synchronized with system" << sysid
+                 << "offset=" << st.offsetNs / 1e6 << "ms rtt=" << st.rttNs / 1e6 << "ms";
+        emit synchronizedChanged(sysid, true);
+    }
+}
+
+bool TimeSync::isSynchronized(quint8 sysid) const
+{
+    auto it = m_clocks.constFind(sysid);
+    return it != m_clocks.constEnd() && it.value().samples >= UsableSamples;
+}
+
+double TimeSync::offsetMs(quint8 sysid) const
+{
+    return m_clocks.value(sysid).offsetNs / 1e6;
+}
+
+double TimeSync::driftPpm(quint8 sysid) const
+{
+    return m_clocks.value(sysid).drift * 1e6;
+}
+
+double TimeSync::rttMs(quint8 sysid) const
+{
+    return m_clocks.value(sysid).rttNs / 1e6;
+}
+
+qint64 TimeSync::vehicleToHostNs(quint8 sysid, quint32 timeBootMs) const
+{
+    auto it = m_clocks.constFind(sysid);
+    if (it == m_clocks.constEnd() || it.value().samples < UsableSamples) {
+        return -1;
+    }
+
+    const ClockState &st = it.value();
+    const double vehicleNs = double(timeBootMs) * 1e6;
+    const double dt = vehicleNs + st.offsetNs - double(st.lastUpdateNs);
+    return qint64(vehicleNs + st.offsetNs + st.drift * dt);
+}
+
+qint64 TimeSync::vehicleToHostEpochMs(quint8 sysid, quint32 timeBootMs) const
+{
+    const qint64 hostNs = vehicleToHostNs(sysid, timeBootMs);
+    if (hostNs < 0) {
+        return 0;
+    }
+    return (hostNs + m_epochBaseNs) / 1000000LL;
+}
+
+double TimeSync::recordLatency(quint8 sysid, quint32 msgId, quint32 timeBootMs, qint64 rxNs)
+{
+    const qint64 hostNs = vehicleToHostNs(sysid, timeBootMs);
+    if (hostNs < 0) {
+        return -1.0;
+    }
+
+    const double latencyMs = double(rxNs - hostNs) / 1e6;
+    Latency &lat = m_latencies[msgId];
+    if (lat.samples == 0) {
+        lat.avgMs = latencyMs;
+        lat.minMs = latencyMs;
+        lat.maxMs = latencyMs;
+    } else {
+        lat.avgMs += LatencySmoothing * (latencyMs - lat.avgMs);
+        lat.minMs = qMin(lat.minMs, latencyMs);
+        lat.maxMs = qMax(lat.maxMs, latencyMs);
+    }
+    lat.lastMs = latencyMs;
+    lat.samples++;
+    return latencyMs;
+}
+
+QHash<quint32, TimeSync::Latency> TimeSync::latencies() const
+{
+    return m_latencies;
+}
@@ -0,0 +1,78 @@
+#ifndef TIMESYNC_H
+#define TIMESYNC_H
+
+#include <QObject>
+#include <QHash>
+#include "scheduler.h"
+
+// Синхронизация часов с бортом по протоколу TIMESYNC (msg 111).
+// Для каждого аппарата (sysid) ведется отфильтрованная оценка смещения
+// и дрейфа бортовых часов относительно монотонных часов хоста.
+class TimeSync : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Latency {
+        double lastMs = 0.0;
+        double avgMs = 0.0;
+        double minMs = 0.0;
+        double maxMs = 0.0;
+        quint64 samples = 0;
+    };
+
+    explicit TimeSync(QObject *parent = nullptr);
+
+    // Монотонное время хоста в наносекундах
+    static qint64 hostNowNs();
+
+    void start(int intervalMs = 1000);
+    void stop();
+
+    // Обработка входящего TIMESYNC: ответ на запрос борта или новая оценка смещения
+    void handleTimesync(quint8 sysid, const char *payload, int payloadLen, qint64 rxNs);
+
+    bool isSynchronized(quint8 sysid) const;
+    double offsetMs(quint8 sysid) const;
+    double driftPpm(quint8 sysid) const;
+    double rttMs(quint8 sysid) const;
+
+    // Перевод бортового time_boot_ms в монотонное время хоста (нс), -1 если нет синхронизации
+    qint64 vehicleToHostNs(quint8 sysid, quint32 timeBootMs) const;
+
+    // То же, но в миллисекундах Unix-времени хоста, 0 если нет синхронизации
+    qint64 vehicleToHostEpochMs(quint8 sysid, quint32 timeBootMs) const;
+
+    // Регистрирует задержку "борт -> прием" для сообщения с time_boot_ms.
+    // Возвращает задержку в мс или -1, если часы еще не синхронизированы.
+    double recordLatency(quint8 sysid, quint32 msgId, quint32 timeBootMs, qint64 rxNs);
+
+    QHash<quint32, Latency> latencies() const;
+    void clear();
+
+signals:
+    void frameReady(const QByteArray &frame);
+    void synchronizedChanged(quint8 sysid, bool synchronized);
+
+private:
+    void sendRequest();
+
+    struct ClockState {
+        double offsetNs = 0.0;   // host = vehicle + offset
+        double drift = 0.0;      // нс/нс
+        double rttNs = 0.0;
+        qint64 lastUpdateNs = 0;
+        int samples = 0;
+        int outliers = 0;
+    };
+
+    void updateEstimate(quint8 sysid, qint64 vehicleNs, qint64 sentNs, qint64 rxNs);
+    QByteArray createTimesync(qint64 tc1, qint64 ts1, quint8 targetSystem) const;
+
+    Scheduler::TaskId m_requestTask;
+    QHash<quint8, ClockState> m_clocks;
+    QHash<quint32, Latency> m_latencies;
+    qint64 m_epochBaseNs;
+};
+
+#endif // TIMESYNC_H
@@ -0,0 +1,130 @@
+#include "workstealingpool.h"
+#include <algorithm>
+
+namespace {
+// Пул и номер очереди текущего рабочего потока
+thread_local WorkStealingPool *t_pool = nullptr;
+thread_local int t_index = -1;
+}
+
+WorkStealingPool::WorkStealingPool(int threads)
+    : m_queued(0)
+    , m_pending(0)
+    , m_nextQueue(0)
+    , m_stolen(0)
+    , m_stopping(false)
+{
+    if (threads <= 0) {
+        threads = int(std::thread::hardware_concurrency());
+    }
+    threads = std::max(threads, 1);
+
+    for (int i = 0; i < threads; ++i) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 0; i < threads; ++i) {
+        m_threads.emplace_back([this, i]() { run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    // Из рабочего потока - в свою очередь, снаружи - по кругу
+    const int index = t_pool == this ? t_index : int(m_nextQueue++ % m_queues.size());
+
+    m_pending++;
+    {
+        Queue &queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued++;
+    }
+    m_wake.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_pending == 0; });
+}
+
+int WorkStealingPool::threadCount() const
+{
+    return int(m_threads.size());
+}
+
+quint64 WorkStealingPool::stolenTasks() const
+{
+    return m_stolen;
+}
+
+bool WorkStealingPool::popLocal(int index, Task *task)
+{
+    Queue &queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    *task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(int index, Task *task)
+{
+    const int count = int(m_queues.size());
+    for (int offset = 1; offset < count; ++offset) {
+        Queue &queue = *m_queues[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            *task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            m_stolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int index)
+{
+    t_pool = this;
+    t_index = index;
+
+    for (;;) {
+        Task task;
+        if (popLocal(index, &task) || steal(index, &task)) {
+            m_queued--;
+            task();
+            task = nullptr;
+            if (--m_pending == 0) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_idle.notify_all();
+            }
+            continue;
+        }
+
+        // Увеличение m_queued происходит под m_mutex, поэтому пробуждение не теряется
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this]() { return m_stopping || m_queued > 0; });
+        if (m_stopping && m_queued == 0) {
+            return;
+        }
+    }
+}
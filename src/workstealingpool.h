@@ -0,0 +1,61 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом задач (work stealing). У каждого потока своя
+// очередь: задачи, порожденные внутри задачи, кладутся в очередь текущего
+// потока и берутся с конца (LIFO, данные еще в кэше), а простаивающий поток
+// забирает самые старые задачи из начала чужой очереди.
+class WorkStealingPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    // threads <= 0 - по числу ядер
+    explicit WorkStealingPool(int threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    void submit(Task task);
+
+    // Ждет завершения всех задач, включая порожденные во время ожидания
+    void wait();
+
+    int threadCount() const;
+    quint64 stolenTasks() const;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(int index);
+    bool popLocal(int index, Task *task);
+    bool steal(int index, Task *task);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::atomic<int> m_queued;      // задачи в очередях
+    std::atomic<int> m_pending;     // задачи в очередях и выполняемые
+    std::atomic<unsigned> m_nextQueue;
+    std::atomic<quint64> m_stolen;
+    bool m_stopping;
+};
+
+#endif // WORKSTEALINGPOOL_H